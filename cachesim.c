@@ -0,0 +1,441 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Topic: Description
+        Trace driven cache and TLB simulator, for the address traces of a
+        TRACE_RUN build (--trace). Built on the host by make cachesim, it
+        does not depend on the port.
+
+        Each trace file is replayed through its own hierarchy (the caches
+        of one core): set associative caches with LRU replacement, one
+        level after the other, and a set associative TLB with LRU
+        replacement. An access that misses a level is looked up in the next
+        one, and allocated in every level it missed. Every access is treated
+        as a read of the line holding its address.
+
+        The report gives, for each kind of access (list, matrix, state) and
+        in total, the accesses and the misses of each level and of the TLB.
+        --sweep replays the traces through a single cache of each power of
+        two size in a range, to show how the misses depend on the size.
+
+        Usage:
+        cachesim [--cache=<size>:<ways>:<line>]... [--tlb=<entries>:<ways>:<page>]
+        [--sweep=<min>:<max>] <trace>...
+
+        Sizes take a k, m or g suffix. The default hierarchy is
+        --cache=32k:8:64 --cache=1m:16:64 --tlb=64:4:4k.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_MAX_LEVELS 4
+#define SIM_KINDS      3
+
+static const char *sim_kinds[SIM_KINDS] = { "list", "matrix", "state" };
+
+typedef unsigned long long sim_addr;
+
+/* A set associative cache (or TLB) with LRU replacement */
+typedef struct SIM_CACHE_S
+{
+    unsigned long long size;  /* bytes, or entries for a TLB */
+    unsigned int       ways;
+    unsigned int       line;  /* bytes per line, or per page */
+    unsigned int       sets;
+    sim_addr *         tags;  /* sets * ways, tag + 1, 0 if invalid */
+    unsigned long long *used; /* sets * ways, time of the last access */
+    unsigned long long now;
+    unsigned long long misses[SIM_KINDS];
+} sim_cache;
+
+/* A decoded trace */
+typedef struct SIM_TRACE_S
+{
+    const char *    name;
+    sim_addr *      addr;
+    unsigned char * kind;
+    unsigned long   num;
+    int             truncated;
+} sim_trace;
+
+/* Function: sim_size
+        Parse a size with an optional k, m or g suffix.
+*/
+static unsigned long long
+sim_size(const char *s, const char **end)
+{
+    char *             e;
+    unsigned long long v = strtoull(s, &e, 0);
+    if (*e == 'k' || *e == 'K')
+        v <<= 10, e++;
+    else if (*e == 'm' || *e == 'M')
+        v <<= 20, e++;
+    else if (*e == 'g' || *e == 'G')
+        v <<= 30, e++;
+    if (end)
+        *end = e;
+    return v;
+}
+
+/* Function: sim_geometry
+        Parse <size>:<ways>:<line> into a cache, <size> being the number of
+   entries of a TLB.
+
+        Returns:
+        0 on success, 1 on a syntax or geometry error.
+*/
+static int
+sim_geometry(const char *s, sim_cache *c, int tlb)
+{
+    const char *p;
+    memset(c, 0, sizeof(*c));
+    c->size = sim_size(s, &p);
+    if (*p++ != ':')
+        return 1;
+    c->ways = (unsigned int)strtoul(p, (char **)&p, 0);
+    if (*p++ != ':')
+        return 1;
+    c->line = (unsigned int)sim_size(p, &p);
+    if (*p || c->ways == 0 || c->line == 0 || (c->line & (c->line - 1)))
+        return 1;
+    c->sets = (unsigned int)((tlb ? c->size : c->size / c->line) / c->ways);
+    return c->sets == 0;
+}
+
+/* Function: sim_reset
+        Allocate or clear the state of a cache.
+*/
+static int
+sim_reset(sim_cache *c)
+{
+    unsigned long long n = (unsigned long long)c->sets * c->ways;
+    if (c->tags == NULL)
+    {
+        c->tags = (sim_addr *)malloc(n * sizeof(sim_addr));
+        c->used = (unsigned long long *)malloc(n * sizeof(unsigned long long));
+        if (c->tags == NULL || c->used == NULL)
+            return 1;
+    }
+    memset(c->tags, 0, n * sizeof(sim_addr));
+    memset(c->used, 0, n * sizeof(unsigned long long));
+    memset(c->misses, 0, sizeof(c->misses));
+    c->now = 0;
+    return 0;
+}
+
+/* Function: sim_access
+        Look up the line of an address, allocate it on a miss.
+
+        Returns:
+        1 on a hit, 0 on a miss.
+*/
+static int
+sim_access(sim_cache *c, sim_addr addr, int kind)
+{
+    sim_addr            line = addr / c->line;
+    unsigned int        set  = (unsigned int)(line % c->sets), w, victim = 0;
+    sim_addr *          tags = c->tags + (unsigned long long)set * c->ways;
+    unsigned long long *used = c->used + (unsigned long long)set * c->ways;
+
+    c->now++;
+    for (w = 0; w < c->ways; w++)
+    {
+        if (tags[w] == line + 1)
+        {
+            used[w] = c->now;
+            return 1;
+        }
+        if (used[w] < used[victim])
+            victim = w;
+    }
+    tags[victim] = line + 1;
+    used[victim] = c->now;
+    c->misses[kind]++;
+    return 0;
+}
+
+/* Function: sim_load
+        Read and decode a trace file.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+static int
+sim_load(const char *name, sim_trace *t)
+{
+    FILE *          fp = fopen(name, "rb");
+    char            magic[8];
+    unsigned int    header[4];
+    unsigned char * buf, *p, *end;
+    sim_addr        last = 0;
+    unsigned long   n    = 0;
+
+    memset(t, 0, sizeof(*t));
+    t->name = name;
+    if (fp == NULL)
+    {
+        fprintf(stderr, "cachesim: cannot open %s\n", name);
+        return 1;
+    }
+    if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, "CMTRACE1", 8) != 0
+        || fread(header, sizeof(header), 1, fp) != 1)
+    {
+        fprintf(stderr, "cachesim: %s is not a trace\n", name);
+        fclose(fp);
+        return 1;
+    }
+    buf     = (unsigned char *)malloc(header[1] + 1);
+    t->addr = (sim_addr *)malloc((header[0] + 1) * sizeof(sim_addr));
+    t->kind = (unsigned char *)malloc(header[0] + 1);
+    if (buf == NULL || t->addr == NULL || t->kind == NULL
+        || fread(buf, 1, header[1], fp) != header[1])
+    {
+        fprintf(stderr, "cachesim: cannot read %s\n", name);
+        fclose(fp);
+        free(buf);
+        return 1;
+    }
+    fclose(fp);
+    t->truncated = header[2];
+    for (p = buf, end = buf + header[1]; p < end && n < header[0]; n++)
+    {
+        sim_addr     v = 0, d;
+        unsigned int shift = 0;
+        do
+            v |= (sim_addr)(*p & 0x7f) << shift, shift += 7;
+        while ((*p++ & 0x80) && p < end);
+        t->kind[n] = (unsigned char)(v & 3);
+        v >>= 2;
+        d          = (v & 1) ? ~(v >> 1) : (v >> 1);
+        last += d;
+        t->addr[n] = last;
+    }
+    t->num = n;
+    free(buf);
+    return 0;
+}
+
+/* Function: sim_run
+        Replay the traces through the hierarchy, each with cleared state,
+   and add up the misses.
+
+        Returns:
+        0 on success, 1 if the state cannot be allocated.
+*/
+static int
+sim_run(sim_trace *     traces,
+        int             num_traces,
+        sim_cache *     levels,
+        int             num_levels,
+        sim_cache *     tlb,
+        unsigned long long misses[][SIM_KINDS],
+        unsigned long long accesses[SIM_KINDS])
+{
+    int           i, l, k;
+    unsigned long n;
+    for (l = 0; l <= num_levels; l++)
+        for (k = 0; k < SIM_KINDS; k++)
+            misses[l][k] = 0;
+    for (k = 0; k < SIM_KINDS; k++)
+        accesses[k] = 0;
+    for (i = 0; i < num_traces; i++)
+    {
+        sim_trace *t = &traces[i];
+        for (l = 0; l < num_levels; l++)
+            if (sim_reset(&levels[l]))
+                return 1;
+        if (tlb && sim_reset(tlb))
+            return 1;
+        for (n = 0; n < t->num; n++)
+        {
+            int kind = t->kind[n] < SIM_KINDS ? t->kind[n] : 0;
+            accesses[kind]++;
+            if (tlb)
+                sim_access(tlb, t->addr[n], kind);
+            for (l = 0; l < num_levels; l++)
+                if (sim_access(&levels[l], t->addr[n], kind))
+                    break;
+        }
+        for (l = 0; l < num_levels; l++)
+            for (k = 0; k < SIM_KINDS; k++)
+                misses[l][k] += levels[l].misses[k];
+        if (tlb)
+            for (k = 0; k < SIM_KINDS; k++)
+                misses[num_levels][k] += tlb->misses[k];
+    }
+    return 0;
+}
+
+/* Function: sim_ratio
+        Misses per 100 accesses.
+*/
+static double
+sim_ratio(unsigned long long misses, unsigned long long accesses)
+{
+    return accesses ? 100.0 * (double)misses / (double)accesses : 0.0;
+}
+
+static void
+sim_usage(void)
+{
+    fprintf(stderr,
+            "usage: cachesim [--cache=<size>:<ways>:<line>]... "
+            "[--tlb=<entries>:<ways>:<page>]\n"
+            "                [--sweep=<min>:<max>] <trace>...\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    sim_cache          levels[SIM_MAX_LEVELS], tlb;
+    sim_trace *        traces;
+    unsigned long long misses[SIM_MAX_LEVELS + 1][SIM_KINDS];
+    unsigned long long accesses[SIM_KINDS], total, sweep_min = 0, sweep_max = 0;
+    int                num_levels = 0, num_traces = 0, i, l, k, truncated = 0;
+
+    traces = (sim_trace *)malloc(argc * sizeof(sim_trace));
+    if (traces == NULL)
+        return 1;
+    if (sim_geometry("64:4:4k", &tlb, 1))
+        return 1;
+    for (i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        if (strncmp(a, "--cache=", 8) == 0)
+        {
+            if (num_levels == SIM_MAX_LEVELS
+                || sim_geometry(a + 8, &levels[num_levels++], 0))
+            {
+                fprintf(stderr, "cachesim: bad cache %s\n", a + 8);
+                return 1;
+            }
+        }
+        else if (strncmp(a, "--tlb=", 6) == 0)
+        {
+            if (sim_geometry(a + 6, &tlb, 1))
+            {
+                fprintf(stderr, "cachesim: bad tlb %s\n", a + 6);
+                return 1;
+            }
+        }
+        else if (strncmp(a, "--sweep=", 8) == 0)
+        {
+            const char *p;
+            sweep_min = sim_size(a + 8, &p);
+            sweep_max = *p == ':' ? sim_size(p + 1, NULL) : 0;
+            if (sweep_min == 0 || sweep_max < sweep_min)
+            {
+                fprintf(stderr, "cachesim: bad sweep %s\n", a + 8);
+                return 1;
+            }
+        }
+        else if (a[0] == '-')
+        {
+            sim_usage();
+            return 1;
+        }
+        else
+        {
+            if (sim_load(a, &traces[num_traces]))
+                return 1;
+            truncated |= traces[num_traces++].truncated;
+        }
+    }
+    if (num_traces == 0)
+    {
+        sim_usage();
+        return 1;
+    }
+    if (num_levels == 0)
+    {
+        sim_geometry("32k:8:64", &levels[num_levels++], 0);
+        sim_geometry("1m:16:64", &levels[num_levels++], 0);
+    }
+    if (truncated)
+        printf("WARNING! Truncated traces, the buffer was full\n");
+
+    if (sweep_min)
+    {
+        /* one level of each size, with the ways and line of the first */
+        unsigned long long size;
+        printf("%10s %14s %10s", "size", "misses", "miss%");
+        for (k = 0; k < SIM_KINDS; k++)
+            printf(" %9s%%", sim_kinds[k]);
+        printf("\n");
+        for (size = sweep_min; size <= sweep_max; size *= 2)
+        {
+            sim_cache c = levels[0];
+            c.size      = size;
+            c.sets      = (unsigned int)(size / c.line / c.ways);
+            c.tags      = NULL;
+            c.used      = NULL;
+            if (c.sets == 0)
+                continue;
+            if (sim_run(traces, num_traces, &c, 1, NULL, misses, accesses))
+                return 1;
+            total = accesses[0] + accesses[1] + accesses[2];
+            if (size & 1023)
+                printf("%10llu", size);
+            else
+                printf("%9lluk", size >> 10);
+            printf(" %14llu %9.3f%%",
+                   misses[0][0] + misses[0][1] + misses[0][2],
+                   sim_ratio(misses[0][0] + misses[0][1] + misses[0][2],
+                             total));
+            for (k = 0; k < SIM_KINDS; k++)
+                printf(" %9.3f%%", sim_ratio(misses[0][k], accesses[k]));
+            printf("\n");
+            free(c.tags);
+            free(c.used);
+        }
+        return 0;
+    }
+
+    if (sim_run(traces, num_traces, levels, num_levels, &tlb, misses, accesses))
+        return 1;
+    total = accesses[0] + accesses[1] + accesses[2];
+    printf("Traces           : %d\n", num_traces);
+    for (l = 0; l < num_levels; l++)
+        printf("L%d               : %lluk, %u ways, %u byte lines\n",
+               l + 1,
+               levels[l].size >> 10,
+               levels[l].ways,
+               levels[l].line);
+    printf("TLB              : %llu entries, %u ways, %uk pages\n",
+           tlb.size,
+           tlb.ways,
+           tlb.line >> 10);
+    printf("%-8s %12s", "kind", "accesses");
+    for (l = 0; l < num_levels; l++)
+        printf("    L%d misses (%%)     ", l + 1);
+    printf("   TLB misses (%%)\n");
+    for (k = 0; k <= SIM_KINDS; k++)
+    {
+        unsigned long long a = k < SIM_KINDS ? accesses[k] : total;
+        printf("%-8s %12llu", k < SIM_KINDS ? sim_kinds[k] : "total", a);
+        for (l = 0; l <= num_levels; l++)
+        {
+            unsigned long long m = k < SIM_KINDS ? misses[l][k]
+                                                 : misses[l][0] + misses[l][1]
+                                                       + misses[l][2];
+            printf(" %12llu (%6.3f)", m, sim_ratio(m, a));
+        }
+        printf("\n");
+    }
+    return 0;
+}
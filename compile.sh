@@ -1 +1 @@
-xvsa all.c -noxa -noxfa -c -I. -Ilinux64 -c -DFLAGS_STR=\""-O2  -lrt"\" -DITERATIONS=0 -o all.uwm
+make -s PORT_DIR=linux64 all.c && xvsa all.c -noxa -noxfa -c -I. -Ilinux64 -c -DFLAGS_STR=\""$(make -s PORT_DIR=linux64 flags_str)"\" -DITERATIONS=0 -o all.uwm
@@ -0,0 +1,314 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Interleaved A/B comparison.
+
+        Two configurations are compared in the same process, on the same cpu,
+        by alternating short timed slices of each, so that thermal and
+        frequency drift affect both alike. A configuration is either:
+        - a list of kernel variants, as for --kernel ("ref" for the kernels
+        of the run), when <KERNEL_REGISTRY> is enabled.
+        - the path of a library build (make lib), loaded with dlopen, whose
+        <core_run> runs the slices.
+
+        Every slice runs the same seeds and iterations, calibrated on A to
+        about <AB_DEFAULT_MS>. Pairs run in the order A B, B A, A B, ... so
+        that a linear drift cancels out. For each pair, the difference of B
+        to A in iterations per second is taken relative to A; the report
+        gives the mean of these paired differences and its confidence
+        interval, from Student's t distribution.
+*/
+#if AB_RUN
+#include <string.h>
+#if PLUGIN_DLOPEN
+#include <dlfcn.h>
+#endif
+
+#define AB_DEFAULT_PAIRS 30
+#define AB_DEFAULT_MS    100 /* length of a slice */
+
+typedef ee_s16 (*ab_run_fn)(const core_run_config *, core_run_result *);
+
+typedef struct AB_SIDE_S
+{
+    const char *spec;
+    ab_run_fn   run;
+#if KERNEL_REGISTRY
+    core_kernels kernels;
+#endif
+    void *   lib;
+    ee_u16   crc;
+    secs_ret sum; /* iterations per second, over all slices */
+} ab_side;
+
+/* Function: ab_t95
+        Two sided 95% critical value of Student's t distribution with <df>
+   degrees of freedom: exact values up to 10, then the Cornish-Fisher
+   expansion, within 0.001 of the exact value.
+*/
+static secs_ret
+ab_t95(ee_u32 df)
+{
+    static const secs_ret t[] = { 12.706, 4.303, 3.182, 2.776, 2.571,
+                                  2.447,  2.365, 2.306, 2.262, 2.228 };
+    secs_ret z = 1.959964, d = df;
+    if (df == 0)
+        return 0;
+    if (df <= 10)
+        return t[df - 1];
+    return z + (z * z * z + z) / (4 * d)
+           + (5 * z * z * z * z * z + 16 * z * z * z + 3 * z) / (96 * d * d);
+}
+
+/* Function: ab_sqrt
+        Square root by Newton iterations, to avoid a dependency on libm.
+*/
+static secs_ret
+ab_sqrt(secs_ret x)
+{
+    secs_ret r = x > 1 ? x : 1;
+    int      i;
+    if (x <= 0)
+        return 0;
+    for (i = 0; i < 64; i++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+/* Function: ab_setup
+        Prepare one side of the comparison from its spec.
+
+        Returns:
+        0 on success, 1 if the spec cannot be used.
+*/
+static ee_s16
+ab_setup(ab_side *side, const char *spec)
+{
+    side->spec = (spec && *spec) ? spec : "ref";
+    side->run  = core_run;
+    side->lib  = NULL;
+    side->sum  = 0;
+    if (strchr(side->spec, '/') != NULL)
+    {
+#if PLUGIN_DLOPEN
+        /* each library has its own copy of the benchmark and its globals */
+        side->lib = dlopen(side->spec, RTLD_NOW | RTLD_LOCAL);
+        if (side->lib == NULL)
+        {
+            ee_printf("ERROR! Cannot load %s: %s\n", side->spec, dlerror());
+            return 1;
+        }
+        side->run = (ab_run_fn)dlsym(side->lib, "core_run");
+        if (side->run == NULL)
+        {
+            ee_printf("ERROR! %s does not export core_run\n", side->spec);
+            dlclose(side->lib);
+            side->lib = NULL;
+            return 1;
+        }
+        return 0;
+#else
+        ee_printf("ERROR! Loading builds is not supported by this port\n");
+        return 1;
+#endif
+    }
+#if KERNEL_REGISTRY
+    {
+        core_kernels saved = core_kernel;
+        ee_s16       err   = 0;
+        if (strcmp(side->spec, "ref") != 0)
+            err = core_kernels_select(side->spec);
+        side->kernels = core_kernel;
+        core_kernel   = saved;
+        return err;
+    }
+#else
+    if (strcmp(side->spec, "ref") != 0)
+    {
+        ee_printf("ERROR! Kernel variants are not supported by this port\n");
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+/* Function: ab_slice
+        Run one timed slice of a side.
+
+        Returns:
+        Iterations per second, 0 if the run failed.
+*/
+static secs_ret
+ab_slice(ab_side *side, core_run_config *cfg, core_run_result *out)
+{
+#if KERNEL_REGISTRY
+    core_kernels saved = core_kernel;
+    if (side->lib == NULL)
+        core_kernel = side->kernels;
+#endif
+    if (side->run(cfg, out) < 0)
+        out->iterations_per_sec = 0;
+#if KERNEL_REGISTRY
+    core_kernel = saved;
+#endif
+    return out->iterations_per_sec;
+}
+
+/* Function: core_ab_run
+        Run the interleaved A/B comparison.
+
+        Parameters:
+        res - seeds, algorithms and total size of the data block.
+        spec_a, spec_b - the configurations, see the description.
+        pairs - number of A/B pairs, 0 for <AB_DEFAULT_PAIRS>.
+        slice_ms - length of a slice, 0 for <AB_DEFAULT_MS>.
+        cpu - cpu to run on.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+ee_s16
+core_ab_run(core_results *res,
+            const char *  spec_a,
+            const char *  spec_b,
+            ee_u32        pairs,
+            ee_u32        slice_ms,
+            ee_u32        cpu)
+{
+    ab_side         side[2];
+    core_run_config cfg;
+    core_run_result out;
+    secs_ret *      diff, mean = 0, var = 0, half, ips[2];
+    ee_u32          k, s;
+    ee_s16          err = 0;
+
+    if (pairs < 2)
+        pairs = pairs ? 2 : AB_DEFAULT_PAIRS;
+    if (slice_ms == 0)
+        slice_ms = AB_DEFAULT_MS;
+    if (ab_setup(&side[0], spec_a))
+        return 1;
+    if (ab_setup(&side[1], spec_b))
+    {
+#if PLUGIN_DLOPEN
+        if (side[0].lib)
+            dlclose(side[0].lib);
+#endif
+        return 1;
+    }
+    if (!portable_set_affinity(cpu))
+        ee_printf("WARNING! Cannot run on cpu %u, not pinned\n", cpu);
+
+    cfg.seed1      = res->seed1;
+    cfg.seed2      = res->seed2;
+    cfg.seed3      = res->seed3;
+    cfg.iterations = 0;
+    cfg.target_ms  = slice_ms;
+    cfg.execs      = res->execs;
+    cfg.size       = res->size;
+    cfg.memblock   = portable_malloc(cfg.size);
+    diff           = (secs_ret *)portable_malloc(pairs * sizeof(secs_ret));
+    if (cfg.memblock == NULL || diff == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate the A/B comparison\n");
+        err = 1;
+        goto out_free;
+    }
+
+    /* calibrate on A, then one slice of each side to warm up */
+    if (ab_slice(&side[0], &cfg, &out) == 0)
+        err = 1;
+    cfg.iterations = out.iterations;
+    for (s = 0; s < 2 && !err; s++)
+    {
+        if (ab_slice(&side[s], &cfg, &out) == 0)
+            err = 1;
+        side[s].crc = out.crcfinal;
+    }
+    for (k = 0; k < pairs && !err; k++)
+    {
+        for (s = 0; s < 2; s++)
+        {
+            ee_u32 x = (k & 1) ? 1 - s : s;
+            ips[x]   = ab_slice(&side[x], &cfg, &out);
+            if (ips[x] == 0 || out.crcfinal != side[x].crc)
+            {
+                ee_printf("ERROR! Slice of %s failed\n", side[x].spec);
+                err = 1;
+                break;
+            }
+            side[x].sum += ips[x];
+        }
+        if (!err)
+        {
+            diff[k] = 100 * (ips[1] - ips[0]) / ips[0];
+            mean += diff[k];
+        }
+    }
+    if (err)
+    {
+        ee_printf("Errors detected\n");
+        goto out_free;
+    }
+    mean /= pairs;
+    for (k = 0; k < pairs; k++)
+        var += (diff[k] - mean) * (diff[k] - mean);
+    var /= pairs - 1;
+    half = ab_t95(pairs - 1) * ab_sqrt(var / pairs);
+
+    ee_printf("A                : %s\n", side[0].spec);
+    ee_printf("B                : %s\n", side[1].spec);
+    ee_printf("Pairs            : %u slices of %lu iterations on cpu %u\n",
+              pairs,
+              (long unsigned)cfg.iterations,
+              cpu);
+    for (s = 0; s < 2; s++)
+        ee_printf("%c Iterations/Sec : %f, crcfinal 0x%04x\n",
+                  'A' + s,
+                  side[s].sum / pairs,
+                  side[s].crc);
+    if (side[0].crc != side[1].crc)
+        ee_printf("WARNING! A and B do not compute the same crcs\n");
+    ee_printf("B vs A           : %+.3f%% (95%% CI %+.3f%% to %+.3f%%, "
+              "stddev %.3f%%)\n",
+              mean,
+              mean - half,
+              mean + half,
+              ab_sqrt(var));
+    if (mean - half > 0)
+        ee_printf("Verdict          : B is faster\n");
+    else if (mean + half < 0)
+        ee_printf("Verdict          : B is slower\n");
+    else
+        ee_printf("Verdict          : no significant difference\n");
+out_free:
+    if (cfg.memblock)
+        portable_free(cfg.memblock);
+    if (diff)
+        portable_free(diff);
+#if PLUGIN_DLOPEN
+    for (s = 0; s < 2; s++)
+    {
+        if (side[s].lib)
+            dlclose(side[s].lib);
+    }
+#endif
+    return err;
+}
+#endif /* AB_RUN */
@@ -0,0 +1,215 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Data alignment sensitivity sweep.
+
+        Run the benchmark with <core_run> several times, with the same seeds
+        and iterations, moving the base of the data block:
+        - across a cache line, in steps of the pointer size (the alignment
+        the list requires).
+        - across a page, in steps of <ALIGN_PAGE_STEP> bytes.
+
+        Each offset is run <repeats> times, offsets interleaved so that
+        drift affects all of them alike. The report gives the score at each
+        offset and the distribution over all runs. A change in score smaller
+        than the spread of the sweep cannot be told apart from alignment
+        luck.
+
+        The crcs must be the same at every offset.
+
+        Code alignment is swept by building variants, see the align_report
+        target of the Makefile.
+*/
+#if ALIGN_SWEEP
+
+#define ALIGN_LINE        64
+#define ALIGN_PAGE        4096
+#define ALIGN_PAGE_STEP   256
+#define ALIGN_MAX_OFFSETS (ALIGN_LINE / 4 + ALIGN_PAGE / ALIGN_PAGE_STEP)
+/* calibrate each run for about this time when no iterations are given */
+#define ALIGN_DEFAULT_MS 1000
+
+/* Function: align_sort
+        Sort in place, ascending.
+*/
+static void
+align_sort(secs_ret *v, ee_u32 n)
+{
+    ee_u32 i, j;
+    for (i = 1; i < n; i++)
+    {
+        secs_ret x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+}
+
+/* Function: align_sqrt
+        Square root by Newton iterations, to avoid a dependency on libm.
+*/
+static secs_ret
+align_sqrt(secs_ret x)
+{
+    secs_ret r = x > 1 ? x : 1;
+    int      i;
+    if (x <= 0)
+        return 0;
+    for (i = 0; i < 64; i++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+/* Function: core_align_sweep
+        Run the data alignment sweep.
+
+        Parameters:
+        res - seeds, iterations (0 to calibrate), algorithms and total size
+   of the data block.
+        repeats - runs at each offset, 0 for 1.
+
+        Returns:
+        0 on success, 1 if a run failed or the crcs depend on the offset.
+*/
+ee_s16
+core_align_sweep(core_results *res, ee_u32 repeats)
+{
+    ee_u32          offsets[ALIGN_MAX_OFFSETS];
+    ee_u32          num_offsets = 0, i, r, n;
+    core_run_config cfg;
+    core_run_result out;
+    ee_u8 *         block, *base;
+    secs_ret *      ips, *sorted, sum = 0, var = 0, mean, median;
+    ee_u16          crc = 0;
+    ee_s16          err = 0;
+
+    if (repeats == 0)
+        repeats = 1;
+    for (i = 0; i < ALIGN_LINE; i += sizeof(void *))
+        offsets[num_offsets++] = i;
+    for (i = ALIGN_PAGE_STEP; i < ALIGN_PAGE; i += ALIGN_PAGE_STEP)
+        offsets[num_offsets++] = i;
+    n = num_offsets * repeats;
+
+    block = (ee_u8 *)portable_malloc(res->size + 2 * ALIGN_PAGE);
+    ips   = (secs_ret *)portable_malloc(2 * n * sizeof(secs_ret));
+    if (block == NULL || ips == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate the alignment sweep\n");
+        if (block)
+            portable_free(block);
+        if (ips)
+            portable_free(ips);
+        return 1;
+    }
+    sorted = ips + n;
+    base   = (ee_u8 *)(((ee_ptr_int)block + ALIGN_PAGE - 1)
+                     & ~(ee_ptr_int)(ALIGN_PAGE - 1));
+
+    cfg.seed1      = res->seed1;
+    cfg.seed2      = res->seed2;
+    cfg.seed3      = res->seed3;
+    cfg.iterations = res->iterations;
+    cfg.target_ms  = ALIGN_DEFAULT_MS;
+    cfg.execs      = res->execs;
+    cfg.memblock   = base;
+    cfg.size       = res->size;
+    if (cfg.iterations == 0)
+    {
+        /* calibrate once, then run every offset with the same iterations */
+        if (core_run(&cfg, &out) < 0)
+            err = 1;
+        cfg.iterations = out.iterations;
+    }
+
+    for (r = 0; r < repeats && !err; r++)
+    {
+        for (i = 0; i < num_offsets; i++)
+        {
+            cfg.memblock = base + offsets[i];
+            if (core_run(&cfg, &out) < 0)
+            {
+                err = 1;
+                break;
+            }
+            if (r == 0 && i == 0)
+                crc = out.crcfinal;
+            else if (out.crcfinal != crc)
+            {
+                ee_printf("ERROR! crcfinal 0x%04x at offset %u, expected "
+                          "0x%04x\n",
+                          out.crcfinal,
+                          offsets[i],
+                          crc);
+                err = 1;
+            }
+            ips[i * repeats + r] = out.iterations_per_sec;
+        }
+    }
+    if (err)
+    {
+        ee_printf("Errors detected\n");
+        portable_free(ips);
+        portable_free(block);
+        return 1;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        sorted[i] = ips[i];
+        sum += ips[i];
+    }
+    align_sort(sorted, n);
+    mean   = sum / n;
+    median = (n & 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    for (i = 0; i < n; i++)
+        var += (ips[i] - mean) * (ips[i] - mean);
+    var = n > 1 ? var / (n - 1) : 0;
+
+    ee_printf("Iterations       : %lu per run, %u runs per offset\n",
+              (long unsigned)cfg.iterations,
+              repeats);
+    ee_printf("crcfinal         : 0x%04x at all offsets\n", crc);
+    ee_printf("Offset  Within   Iterations/Sec  vs median\n");
+    for (i = 0; i < num_offsets; i++)
+    {
+        secs_ret m = 0;
+        for (r = 0; r < repeats; r++)
+            m += ips[i * repeats + r];
+        m /= repeats;
+        ee_printf("%6u  %-6s %16.3f  %+8.2f%%\n",
+                  offsets[i],
+                  offsets[i] < ALIGN_LINE ? "line" : "page",
+                  m,
+                  median > 0 ? 100 * (m - median) / median : 0.0);
+    }
+    ee_printf("Sweep min        : %f\n", sorted[0]);
+    ee_printf("Sweep median     : %f\n", median);
+    ee_printf("Sweep max        : %f\n", sorted[n - 1]);
+    ee_printf("Sweep mean       : %f\n", mean);
+    ee_printf("Sweep stddev     : %f (%.2f%%)\n",
+              align_sqrt(var),
+              mean > 0 ? 100 * align_sqrt(var) / mean : 0.0);
+    ee_printf("Sweep spread     : %.2f%% of the median (max - min)\n",
+              median > 0 ? 100 * (sorted[n - 1] - sorted[0]) / median : 0.0);
+    portable_free(ips);
+    portable_free(block);
+    return 0;
+}
+#endif /* ALIGN_SWEEP */
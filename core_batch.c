@@ -0,0 +1,286 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Multi-seed batch mode.
+
+        Run a list of configurations in a single process, instead of launching
+        the benchmark once per configuration. Each line of the batch file holds
+        one configuration:
+
+        seed1 seed2 seed3 size iterations
+
+        Values are parsed like the command line arguments (decimal, 0x hex, K
+        and M suffixes). A size of 0 selects <TOTAL_DATA_SIZE>, and 0
+        iterations selects automatic calibration. Empty lines and lines
+        starting with '#' are ignored.
+
+        The memory block of each context is allocated once, for the largest
+        size in the file, and the data is initialized again in place for each
+        configuration. One result row is printed per configuration.
+*/
+#if BATCH_RUN
+#include <stdio.h>
+
+#define BATCH_LINE_LEN 256
+
+/* Function: batch_parse_line
+        Split a line of the batch file into its fields.
+
+        Returns:
+        Number of fields found, 0 for an empty or comment line.
+*/
+static int
+batch_parse_line(char *line, ee_s32 *fields)
+{
+    int n = 0;
+    while (*line)
+    {
+        char *tok;
+        while (*line == ' ' || *line == '\t' || *line == ','
+               || *line == '\r' || *line == '\n')
+            line++;
+        if (*line == 0 || *line == '#')
+            break;
+        tok = line;
+        while (*line && *line != ' ' && *line != '\t' && *line != ','
+               && *line != '\r' && *line != '\n')
+            line++;
+        if (*line)
+            *line++ = 0;
+        if (n < BATCH_FIELDS)
+            fields[n] = parseval(tok);
+        n++;
+    }
+    return n;
+}
+
+/* Function: core_batch_load
+        Read all configurations from a batch file.
+
+        The file is closed before returning, so that it is never shared with
+   forked contexts or processes.
+
+        Parameters:
+        filename - batch file to read.
+        num_rows - set to the number of configurations.
+        max_size - set to the largest size of a configuration.
+
+        Returns:
+        Array of <num_rows> configurations of BATCH_FIELDS values each,
+   allocated with <portable_malloc>, or NULL if the file could not be used.
+*/
+ee_s32 *
+core_batch_load(const char *filename, ee_u32 *num_rows, ee_u32 *max_size)
+{
+    FILE *  f;
+    char    line[BATCH_LINE_LEN];
+    ee_s32  fields[BATCH_FIELDS];
+    ee_s32 *rows;
+    ee_u32  lineno = 0, row;
+
+    *num_rows = 0;
+    *max_size = 0;
+    f         = fopen(filename, "r");
+    if (f == NULL)
+    {
+        ee_printf("ERROR! Cannot open batch file %s\n", filename);
+        return NULL;
+    }
+    /* first pass, check the file and count the configurations */
+    while (fgets(line, sizeof(line), f))
+    {
+        int n = batch_parse_line(line, fields);
+        lineno++;
+        if (n == 0)
+            continue;
+        if (n != BATCH_FIELDS)
+        {
+            ee_printf("ERROR! %s:%u: expected %d fields, found %d\n",
+                      filename,
+                      lineno,
+                      BATCH_FIELDS,
+                      n);
+            fclose(f);
+            return NULL;
+        }
+        (*num_rows)++;
+    }
+    if (*num_rows == 0)
+    {
+        ee_printf("ERROR! No configurations in batch file %s\n", filename);
+        fclose(f);
+        return NULL;
+    }
+    /* second pass, load the configurations */
+    rows = (ee_s32 *)portable_malloc(*num_rows * BATCH_FIELDS * sizeof(ee_s32));
+    if (rows == NULL)
+    {
+        fclose(f);
+        return NULL;
+    }
+    rewind(f);
+    row = 0;
+    while (fgets(line, sizeof(line), f) && row < *num_rows)
+    {
+        ee_s32 *cfg = rows + row * BATCH_FIELDS;
+        if (batch_parse_line(line, cfg) == 0)
+            continue;
+        if (cfg[3] == 0)
+            cfg[3] = TOTAL_DATA_SIZE;
+        if ((ee_u32)cfg[3] > *max_size)
+            *max_size = (ee_u32)cfg[3];
+        row++;
+    }
+    fclose(f);
+    return rows;
+}
+
+/* Function: core_batch_run
+        Execute all configurations listed in a batch file.
+
+        Parameters:
+        filename - batch file to read.
+        res - results of each context, only the port field needs to be set.
+        num_ctx - number of contexts to run in parallel.
+        cache - reference cache file for configurations without known crcs,
+   see <core_reference_crcs>.
+
+        Returns:
+        Number of configurations that failed validation or could not run, or
+   -1 if the file could not be used.
+*/
+ee_s16
+core_batch_run(const char *  filename,
+               core_results *res,
+               ee_u32        num_ctx,
+               const char *  cache)
+{
+    ee_s32 *rows;
+    ee_u32  max_size, num_rows, row, i;
+    ee_s16  failed = 0;
+
+#if !REFERENCE_RUN
+    (void)cache;
+#endif
+    /* forked contexts share the file offset, so all configurations are
+     * loaded before any context is started */
+    rows = core_batch_load(filename, &num_rows, &max_size);
+    if (rows == NULL)
+        return -1;
+
+    /* one memory block per context, reused for all configurations */
+    for (i = 0; i < num_ctx; i++)
+    {
+        res[i].memblock[0] = portable_malloc(max_size);
+        if (res[i].memblock[0] == NULL)
+        {
+            ee_printf("ERROR! Cannot allocate %u bytes\n", max_size);
+            while (i--)
+                portable_free(res[i].memblock[0]);
+            portable_free(rows);
+            return -1;
+        }
+    }
+
+    ee_printf(
+        "  row  seed1  seed2  seed3     size iterations      secs   "
+        "iter/sec crclist crcmatrix crcstate crcfinal status\n");
+    fflush(stdout); /* do not duplicate buffered output in forked contexts */
+    for (row = 0; row < num_rows; row++)
+    {
+        ee_s32 *    cfg = rows + row * BATCH_FIELDS;
+        CORE_TICKS  total_time;
+        secs_ret    secs;
+        ee_u16      seedcrc;
+        ee_s16      known_id, errors = 0;
+        const char *status;
+
+        if (!core_size_valid((ee_u32)cfg[3], ALL_ALGORITHMS_MASK))
+        {
+            ee_printf("%5u %6d %6d %6d %8lu ERROR! Size too small for the "
+                      "algorithms\n",
+                      row,
+                      (ee_s16)cfg[0],
+                      (ee_s16)cfg[1],
+                      (ee_s16)cfg[2],
+                      (long unsigned)cfg[3]);
+            fflush(stdout);
+            failed++;
+            continue;
+        }
+        /* re-init in place, memblock[0] stays the same */
+        for (i = 0; i < num_ctx; i++)
+        {
+            res[i].seed1      = (ee_s16)cfg[0];
+            res[i].seed2      = (ee_s16)cfg[1];
+            res[i].seed3      = (ee_s16)cfg[2];
+            res[i].size       = (ee_u32)cfg[3];
+            res[i].iterations = (ee_u32)cfg[4];
+            res[i].execs      = ALL_ALGORITHMS_MASK;
+            res[i].err        = 0;
+        }
+        core_init_data(res, num_ctx);
+        if (res[0].iterations == 0)
+            core_calibrate(&res[0]);
+        total_time = core_run_contexts(res, num_ctx);
+        secs       = time_in_secs(total_time);
+
+        known_id = core_known_id(&res[0], &seedcrc);
+        errors   = -1; /* crcs cannot be validated */
+        if (known_id >= 0)
+            errors = core_check_crcs(res, num_ctx, known_id);
+#if REFERENCE_RUN
+        else
+            errors = core_reference_check(res, num_ctx, cache);
+#endif
+        status = errors > 0 ? "ERROR" : errors == 0 ? "valid" : "unknown";
+        if (errors > 0)
+            failed++;
+        /* the size of the configuration, not the size of each algorithm */
+        ee_printf("%5u %6d %6d %6d %8lu %10lu ",
+                  row,
+                  res[0].seed1,
+                  res[0].seed2,
+                  res[0].seed3,
+                  (long unsigned)cfg[3],
+                  (long unsigned)res[0].iterations);
+#if HAS_FLOAT
+        ee_printf("%9.3f %10.2f",
+                  secs,
+                  secs > 0 ? num_ctx * res[0].iterations / secs : 0);
+#else
+        ee_printf("%9lu %10lu",
+                  (long unsigned)secs,
+                  (long unsigned)(secs > 0 ? num_ctx * res[0].iterations / secs
+                                           : 0));
+#endif
+        ee_printf("  0x%04x    0x%04x   0x%04x   0x%04x %s\n",
+                  res[0].crclist,
+                  res[0].crcmatrix,
+                  res[0].crcstate,
+                  res[0].crc,
+                  status);
+        fflush(stdout);
+    }
+    for (i = 0; i < num_ctx; i++)
+        portable_free(res[i].memblock[0]);
+    portable_free(rows);
+    return failed;
+}
+#endif /* BATCH_RUN */
@@ -0,0 +1,722 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Localhost cluster mode.
+
+        A coordinator process drives N worker processes over a Unix domain
+        socket. The workers are either spawned by the coordinator, or started
+        separately with --cluster-worker=<socket> and attached to it.
+
+        Each job (a configuration as in the batch file: seeds, size and
+        iterations) is run by all workers at the same time:
+        - the coordinator sends the job to every worker.
+        - each worker initializes its data (and calibrates if iterations is
+        0), then reports ready. With automatic calibration, all workers use
+        the smallest iteration count reported.
+        - once all workers are ready, the coordinator sends the start message
+        to all of them.
+        - each worker runs the iterations in <CLUSTER_SLICES> timed slices,
+        validates the crcs of the first iteration and sends back its result.
+
+        Messages are fixed size binary records on a SOCK_SEQPACKET socket, so
+        message boundaries are preserved and no framing is needed. Workers
+        and coordinator always run on the same host, so native byte order is
+        used.
+
+        The report gives, per job, a row per worker, the aggregate iterations
+        per second of the fleet and a histogram of the slice rates, and
+        flags workers that deviate from the median by more than the outlier
+        threshold. It also gives the counters of each worker over the timed
+        slices, from getrusage: user and system cpu time, voluntary and
+        involuntary context switches, and minor and major page faults.
+*/
+#if CLUSTER_RUN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define CLUSTER_MAGIC 0x4c434d43 /* "CMCL" */
+/* timed slices per job and worker, for the rate histogram */
+#define CLUSTER_SLICES 16
+/* seconds to wait for workers to connect or answer */
+#define CLUSTER_TIMEOUT        60
+#define CLUSTER_HIST_BUCKETS   10
+#define CLUSTER_DEFAULT_OUTLIER 5
+
+enum CLUSTER_MSG_TYPE
+{
+    CLUSTER_HELLO = 1, /* worker -> coordinator, on connect */
+    CLUSTER_JOB,       /* coordinator -> worker, configuration to run */
+    CLUSTER_READY,     /* worker -> coordinator, data initialized */
+    CLUSTER_START,     /* coordinator -> worker, run now */
+    CLUSTER_RESULT,    /* worker -> coordinator */
+    CLUSTER_BYE        /* coordinator -> worker, exit */
+};
+
+typedef struct CLUSTER_MSG_S
+{
+    ee_u32 magic;
+    ee_u16 type;
+    ee_u16 nslices;
+    ee_u32 job;
+    ee_u32 pid;
+    ee_s32 cfg[BATCH_FIELDS]; /* seed1 seed2 seed3 size iterations */
+    ee_u16 crclist;
+    ee_u16 crcmatrix;
+    ee_u16 crcstate;
+    ee_s16 status; /* 1 valid, 0 cannot be validated, -1 errors */
+    double secs;
+    double slices[CLUSTER_SLICES]; /* iterations per second of each slice */
+    /* counters of the timed slices */
+    double user, sys;     /* cpu time, in seconds */
+    ee_u32 nvcsw, nivcsw; /* voluntary and involuntary context switches */
+    ee_u32 minflt, majflt; /* page faults */
+} cluster_msg;
+
+/* Function: cluster_send
+        Send a message of the given type.
+
+        Returns:
+        1 on success, 0 otherwise.
+*/
+static ee_u8
+cluster_send(int fd, cluster_msg *m, ee_u16 type)
+{
+    m->magic = CLUSTER_MAGIC;
+    m->type  = type;
+    return send(fd, m, sizeof(*m), MSG_NOSIGNAL) == (ssize_t)sizeof(*m);
+}
+
+/* Function: cluster_recv
+        Wait for a message of the given type, for at most <CLUSTER_TIMEOUT>
+   seconds, or forever if timeout is 0.
+
+        Returns:
+        1 on success, 0 on timeout, error, closed connection or unexpected
+   message.
+*/
+static ee_u8
+cluster_recv(int fd, cluster_msg *m, ee_u16 type, int timeout)
+{
+    struct pollfd p;
+    p.fd     = fd;
+    p.events = POLLIN;
+    if (timeout && poll(&p, 1, timeout * 1000) <= 0)
+        return 0;
+    if (recv(fd, m, sizeof(*m), 0) != (ssize_t)sizeof(*m))
+        return 0;
+    return (m->magic == CLUSTER_MAGIC) && (m->type == type);
+}
+
+/* Function: cluster_median
+        Median of n values, sorts the values in place.
+*/
+static double
+cluster_median(double *v, ee_u32 n)
+{
+    ee_u32 i, j;
+    if (n == 0)
+        return 0;
+    for (i = 1; i < n; i++)
+    {
+        double x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+    return (n & 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* Function: cluster_usage_secs
+        Seconds of a struct timeval.
+*/
+static double
+cluster_usage_secs(const struct timeval *tv)
+{
+    return (double)tv->tv_sec + (double)tv->tv_usec / 1000000;
+}
+
+/* Function: cluster_run_job
+        Run one job in a worker, between the job and result messages.
+
+        Returns:
+        1 on success, 0 if the job could not be run or the connection to the
+   coordinator was lost.
+*/
+static ee_u8
+cluster_run_job(int fd, cluster_msg *m, core_results *res, ee_u32 *alloc)
+{
+    ee_u16        crclist, crcmatrix, crcstate, seedcrc;
+    ee_u32        iterations, done = 0, k;
+    ee_s16        known_id, errors = -1;
+    struct rusage u0, u1;
+
+    res->seed1      = (ee_s16)m->cfg[0];
+    res->seed2      = (ee_s16)m->cfg[1];
+    res->seed3      = (ee_s16)m->cfg[2];
+    res->size       = m->cfg[3] ? (ee_u32)m->cfg[3] : TOTAL_DATA_SIZE;
+    res->iterations = (ee_u32)m->cfg[4];
+    res->execs      = ALL_ALGORITHMS_MASK;
+    res->err        = 0;
+    if (!core_size_valid(res->size, res->execs))
+    {
+        ee_printf("ERROR! Size %lu too small for the algorithms\n",
+                  (long unsigned)res->size);
+        return 0;
+    }
+    if (res->size > *alloc)
+    {
+        portable_free(res->memblock[0]);
+        res->memblock[0] = portable_malloc(res->size);
+        *alloc           = res->memblock[0] ? res->size : 0;
+    }
+    if (res->memblock[0] == NULL)
+    {
+        /* the coordinator reports the worker as failed */
+        ee_printf("ERROR! Cannot allocate %lu bytes\n",
+                  (long unsigned)res->size);
+        return 0;
+    }
+    core_init_data(res, 1);
+    if (res->iterations == 0)
+        core_calibrate(res);
+    m->cfg[4] = (ee_s32)res->iterations;
+    if (!cluster_send(fd, m, CLUSTER_READY)
+        || !cluster_recv(fd, m, CLUSTER_START, 0))
+        return 0;
+
+    /* the coordinator sets the common iteration count */
+    iterations = (ee_u32)m->cfg[4];
+    m->pid     = (ee_u32)getpid();
+    m->nslices = iterations < CLUSTER_SLICES ? iterations : CLUSTER_SLICES;
+    m->secs    = 0;
+    crclist = crcmatrix = crcstate = 0;
+    getrusage(RUSAGE_SELF, &u0);
+    for (k = 0; k < m->nslices; k++)
+    {
+        ee_u32   n = (iterations - done) / (m->nslices - k);
+        secs_ret t = portable_time();
+        res->iterations = n;
+        iterate(res);
+        t = portable_time() - t;
+        m->secs += t;
+        m->slices[k] = t > 0 ? n / t : 0;
+        done += n;
+        if (k == 0)
+        {
+            /* crcs of the first iteration, as in a regular run */
+            crclist   = res->crclist;
+            crcmatrix = res->crcmatrix;
+            crcstate  = res->crcstate;
+        }
+    }
+    getrusage(RUSAGE_SELF, &u1);
+    m->user
+        = cluster_usage_secs(&u1.ru_utime) - cluster_usage_secs(&u0.ru_utime);
+    m->sys
+        = cluster_usage_secs(&u1.ru_stime) - cluster_usage_secs(&u0.ru_stime);
+    m->nvcsw  = (ee_u32)(u1.ru_nvcsw - u0.ru_nvcsw);
+    m->nivcsw = (ee_u32)(u1.ru_nivcsw - u0.ru_nivcsw);
+    m->minflt = (ee_u32)(u1.ru_minflt - u0.ru_minflt);
+    m->majflt = (ee_u32)(u1.ru_majflt - u0.ru_majflt);
+    res->iterations = iterations;
+    res->crclist    = crclist;
+    res->crcmatrix  = crcmatrix;
+    res->crcstate   = crcstate;
+    m->crclist      = crclist;
+    m->crcmatrix    = crcmatrix;
+    m->crcstate     = crcstate;
+    known_id        = core_known_id(res, &seedcrc);
+    if (known_id >= 0)
+        errors = core_check_crcs(res, 1, known_id);
+#if REFERENCE_RUN
+    else /* no cache, the workers would write it at the same time */
+        errors = core_reference_check(res, 1, NULL);
+#endif
+    m->status = errors < 0 ? 0 : errors ? -1 : 1;
+    return cluster_send(fd, m, CLUSTER_RESULT);
+}
+
+/* Function: core_cluster_worker
+        Connect to a coordinator and run the jobs it sends, until told to
+   exit.
+
+        Returns:
+        0 on success, 1 if the coordinator could not be reached or went away.
+*/
+ee_s16
+core_cluster_worker(const char *path)
+{
+    struct sockaddr_un sa;
+    cluster_msg        m;
+    core_results       res;
+    ee_u32             alloc = 0;
+    ee_s16             err   = 1;
+    int                fd;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", path);
+    fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+    {
+        ee_printf("ERROR! Cannot connect to coordinator %s: %s\n",
+                  path,
+                  strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+    memset(&m, 0, sizeof(m));
+    memset(&res, 0, sizeof(res));
+    m.pid = (ee_u32)getpid();
+    if (cluster_send(fd, &m, CLUSTER_HELLO))
+    {
+        for (;;)
+        {
+            if (recv(fd, &m, sizeof(m), 0) != (ssize_t)sizeof(m)
+                || m.magic != CLUSTER_MAGIC)
+                break;
+            if (m.type == CLUSTER_BYE)
+            {
+                err = 0;
+                break;
+            }
+            if (m.type != CLUSTER_JOB)
+                break;
+            if (!cluster_run_job(fd, &m, &res, &alloc))
+                break;
+        }
+    }
+    if (err)
+        ee_printf("ERROR! Lost connection to coordinator %s\n", path);
+    portable_free(res.memblock[0]);
+    close(fd);
+    return err;
+}
+
+/* Function: cluster_report_job
+        Print the result rows and aggregate of one job.
+
+        Returns:
+        Number of workers that failed validation.
+*/
+static ee_u32
+cluster_report_job(cluster_msg *r,
+                   ee_u32       workers,
+                   double       wall,
+                   ee_u32       outlier,
+                   double *     rel)
+{
+    double *rates, *slices, median, total = 0, lo = 0, hi = 0;
+    ee_u32  w, k, n = 0, failed = 0;
+    ee_u32  hist[CLUSTER_HIST_BUCKETS];
+
+    rates  = (double *)portable_malloc(workers * sizeof(double));
+    slices = (double *)portable_malloc(workers * CLUSTER_SLICES
+                                       * sizeof(double));
+    if (rates == NULL || slices == NULL)
+    {
+        portable_free(rates);
+        portable_free(slices);
+        return workers;
+    }
+    for (w = 0; w < workers; w++)
+    {
+        rates[w] = r[w].secs > 0 ? r[w].cfg[4] / r[w].secs : 0;
+        total += rates[w];
+        for (k = 0; k < r[w].nslices; k++)
+            slices[n++] = r[w].slices[k];
+    }
+    for (w = 0; w < workers; w++)
+        rel[w] = rates[w];
+    median = cluster_median(rates, workers);
+
+    ee_printf("Job %u: seeds 0x%x 0x%x 0x%x, size %lu, %lu iterations\n",
+              r[0].job,
+              (ee_u16)r[0].cfg[0],
+              (ee_u16)r[0].cfg[1],
+              (ee_u16)r[0].cfg[2],
+              (long unsigned)r[0].cfg[3],
+              (long unsigned)r[0].cfg[4]);
+    ee_printf(
+        "worker     pid      secs   iter/sec  slice min/median/max iter/sec "
+        "crclist crcmatrix crcstate status\n");
+    for (w = 0; w < workers; w++)
+    {
+        double dev = median > 0 ? 100 * (rel[w] / median - 1) : 0;
+        double smed = cluster_median(r[w].slices, r[w].nslices);
+        double smin = r[w].nslices ? r[w].slices[0] : 0;
+        double smax = r[w].nslices ? r[w].slices[r[w].nslices - 1] : 0;
+        ee_printf(
+            "%6u %7u %9.3f %10.2f  %10.2f %10.2f %10.2f  0x%04x    0x%04x   "
+            "0x%04x %s",
+            w,
+            r[w].pid,
+            r[w].secs,
+            rel[w],
+            smin,
+            smed,
+            smax,
+            r[w].crclist,
+            r[w].crcmatrix,
+            r[w].crcstate,
+            r[w].status > 0 ? "valid" : r[w].status ? "ERROR" : "unknown");
+        if (dev > (double)outlier || dev < -(double)outlier)
+            ee_printf(" OUTLIER %+.1f%%", dev);
+        ee_printf("\n");
+        if (r[w].status < 0)
+            failed++;
+        /* keep the deviation from the median for the summary */
+        rel[w] = dev;
+    }
+    ee_printf("Aggregate iter/sec: %.2f (median %.2f, min %.2f, max %.2f), "
+              "wall %.3f secs\n",
+              total,
+              median,
+              workers ? rates[0] : 0,
+              workers ? rates[workers - 1] : 0,
+              wall);
+    ee_printf("worker  user secs   sys secs  vol ctxsw invol ctxsw  minflt  "
+              "majflt\n");
+    for (w = 0; w < workers; w++)
+        ee_printf("%6u %10.3f %10.3f %10u %11u %7u %7u\n",
+                  w,
+                  r[w].user,
+                  r[w].sys,
+                  r[w].nvcsw,
+                  r[w].nivcsw,
+                  r[w].minflt,
+                  r[w].majflt);
+
+    /* histogram of the slice rates of all workers */
+    cluster_median(slices, n);
+    if (n)
+    {
+        lo = slices[0];
+        hi = slices[n - 1];
+    }
+    for (k = 0; k < CLUSTER_HIST_BUCKETS; k++)
+        hist[k] = 0;
+    for (k = 0; k < n; k++)
+    {
+        ee_u32 b = hi > lo ? (ee_u32)((slices[k] - lo) / (hi - lo)
+                                      * CLUSTER_HIST_BUCKETS)
+                           : 0;
+        if (b >= CLUSTER_HIST_BUCKETS)
+            b = CLUSTER_HIST_BUCKETS - 1;
+        hist[b]++;
+    }
+    ee_printf("Slice histogram (iter/sec, %u slices):\n", n);
+    for (k = 0; k < CLUSTER_HIST_BUCKETS && n; k++)
+    {
+        ee_u32 j, bar = (hist[k] * 50 + n - 1) / n;
+        ee_printf("  %10.2f - %10.2f %5u ",
+                  lo + (hi - lo) * k / CLUSTER_HIST_BUCKETS,
+                  lo + (hi - lo) * (k + 1) / CLUSTER_HIST_BUCKETS,
+                  hist[k]);
+        for (j = 0; j < bar; j++)
+            ee_printf("#");
+        ee_printf("\n");
+        if (hi <= lo)
+            break; /* all slices in one bucket */
+    }
+    portable_free(rates);
+    portable_free(slices);
+    return failed;
+}
+
+/* Function: cluster_accept
+        Accept one worker connection.
+
+        Returns:
+        The connected socket, or -1 on timeout or error.
+*/
+static int
+cluster_accept(int lfd)
+{
+    struct pollfd p;
+    p.fd     = lfd;
+    p.events = POLLIN;
+    if (poll(&p, 1, CLUSTER_TIMEOUT * 1000) <= 0)
+        return -1;
+    return accept(lfd, NULL, NULL);
+}
+
+/* Function: core_cluster_run
+        Coordinate a run of all jobs on a fleet of worker processes.
+
+        Parameters:
+        res - configuration from the command line, used as the only job when
+   no job file is given.
+        workers - number of worker processes, 0 for one per cpu.
+        path - Unix domain socket to listen on, NULL or "" for a name based
+   on the process id.
+        attach - if 0, spawn the workers, otherwise wait for workers started
+   with --cluster-worker=<path>.
+        jobs_file - batch file with the jobs, or NULL.
+        outlier - threshold in percent from the median to flag a worker.
+
+        Returns:
+        Number of failed jobs and workers, or -1 if the fleet could not be set
+   up.
+*/
+ee_s16
+core_cluster_run(core_results *res,
+                 ee_u32        workers,
+                 const char *  path,
+                 ee_u8         attach,
+                 const char *  jobs_file,
+                 ee_u32        outlier)
+{
+    struct sockaddr_un sa;
+    cluster_msg        m, *results = NULL;
+    ee_s32 *           jobs;
+    ee_u32             num_jobs, max_size, j, w, connected = 0;
+    ee_u32             valid = 0, unknown = 0, failed = 0, ran = 0;
+    ee_s16             err = 0;
+    int *              fds;
+    pid_t *            pids;
+    double *           dev, *sum_dev;
+    char               defpath[sizeof(sa.sun_path)];
+    int                lfd;
+
+    if (workers == 0)
+        workers = portable_num_cpus();
+    if (path == NULL || *path == 0)
+    {
+        snprintf(defpath, sizeof(defpath), "/tmp/coremark-%ld.sock",
+                 (long)getpid());
+        path = defpath;
+    }
+    if (outlier == 0)
+        outlier = CLUSTER_DEFAULT_OUTLIER;
+    if (jobs_file != NULL)
+        jobs = core_batch_load(jobs_file, &num_jobs, &max_size);
+    else
+    {
+        num_jobs = 1;
+        jobs     = (ee_s32 *)portable_malloc(BATCH_FIELDS * sizeof(ee_s32));
+        if (jobs != NULL)
+        {
+            jobs[0] = res->seed1;
+            jobs[1] = res->seed2;
+            jobs[2] = res->seed3;
+            jobs[3] = res->size ? (ee_s32)res->size : TOTAL_DATA_SIZE;
+            jobs[4] = (ee_s32)res->iterations;
+        }
+    }
+    if (jobs == NULL)
+        return -1;
+    fds     = (int *)portable_malloc(workers * sizeof(int));
+    pids    = (pid_t *)portable_malloc(workers * sizeof(pid_t));
+    dev     = (double *)portable_malloc(workers * sizeof(double));
+    sum_dev = (double *)portable_malloc(workers * sizeof(double));
+    results = (cluster_msg *)portable_malloc(workers * sizeof(cluster_msg));
+    if (!fds || !pids || !dev || !sum_dev || !results)
+    {
+        err = -1;
+        goto out_free;
+    }
+    for (w = 0; w < workers; w++)
+    {
+        fds[w]     = -1;
+        pids[w]    = 0;
+        sum_dev[w] = 0;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", path);
+    unlink(path);
+    lfd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (lfd < 0 || bind(lfd, (struct sockaddr *)&sa, sizeof(sa)) != 0
+        || listen(lfd, (int)workers) != 0)
+    {
+        ee_printf("ERROR! Cannot listen on %s: %s\n", path, strerror(errno));
+        if (lfd >= 0)
+            close(lfd);
+        err = -1;
+        goto out_free;
+    }
+    if (!attach)
+    {
+        fflush(stdout); /* do not duplicate buffered output in the workers */
+        for (w = 0; w < workers; w++)
+        {
+            pids[w] = fork();
+            if (pids[w] == 0)
+            {
+                close(lfd);
+                _exit(core_cluster_worker(path));
+            }
+        }
+    }
+    else
+        ee_printf("Waiting for %u workers on %s\n", workers, path);
+
+    /* workers are numbered in the order they connect */
+    for (connected = 0; connected < workers; connected++)
+    {
+        fds[connected] = cluster_accept(lfd);
+        if (fds[connected] < 0
+            || !cluster_recv(
+                fds[connected], &m, CLUSTER_HELLO, CLUSTER_TIMEOUT))
+        {
+            ee_printf("ERROR! Only %u of %u workers connected\n",
+                      connected,
+                      workers);
+            if (fds[connected] >= 0)
+                close(fds[connected]);
+            err = -1;
+            goto out_close;
+        }
+        if (attach)
+            pids[connected] = (pid_t)m.pid;
+    }
+
+    ee_printf("Cluster workers  : %u (%s) on %s\n",
+              workers,
+              attach ? "attached" : "spawned",
+              path);
+    for (j = 0; j < num_jobs; j++)
+    {
+        ee_s32   iterations = 0;
+        secs_ret t0;
+
+        memset(&m, 0, sizeof(m));
+        m.job = j;
+        for (w = 0; w < BATCH_FIELDS; w++)
+            m.cfg[w] = jobs[j * BATCH_FIELDS + w];
+        if (!core_size_valid((ee_u32)m.cfg[3], ALL_ALGORITHMS_MASK))
+        {
+            /* not sent, the workers would drop the connection */
+            ee_printf("Job %u: ERROR! Size %lu too small for the algorithms\n",
+                      j,
+                      (long unsigned)m.cfg[3]);
+            failed++;
+            continue;
+        }
+        for (w = 0; w < workers; w++)
+        {
+            if (!cluster_send(fds[w], &m, CLUSTER_JOB))
+                break;
+        }
+        /* wait until every worker has initialized its data */
+        for (w = 0; w < workers; w++)
+        {
+            if (!cluster_recv(fds[w], &results[w], CLUSTER_READY, 0))
+                break;
+            if (w == 0 || results[w].cfg[4] < iterations)
+                iterations = results[w].cfg[4];
+        }
+        if (w < workers)
+        {
+            ee_printf("ERROR! Worker %u failed on job %u\n", w, j);
+            err = -1;
+            goto out_close;
+        }
+        m.cfg[4] = iterations;
+        t0       = portable_time();
+        for (w = 0; w < workers; w++)
+            cluster_send(fds[w], &m, CLUSTER_START);
+        for (w = 0; w < workers; w++)
+        {
+            if (!cluster_recv(fds[w], &results[w], CLUSTER_RESULT, 0))
+                break;
+        }
+        if (w < workers)
+        {
+            ee_printf("ERROR! Worker %u failed on job %u\n", w, j);
+            err = -1;
+            goto out_close;
+        }
+        if (cluster_report_job(results,
+                               workers,
+                               portable_time() - t0,
+                               outlier,
+                               dev))
+            failed++;
+        else if (results[0].status > 0)
+            valid++;
+        else
+            unknown++;
+        for (w = 0; w < workers; w++)
+            sum_dev[w] += dev[w];
+        ran++;
+        fflush(stdout);
+    }
+
+    ee_printf("Cluster jobs     : %u (valid %u, unknown %u, errors %u)\n",
+              num_jobs,
+              valid,
+              unknown,
+              failed);
+    ee_printf("worker     pid  mean deviation from median\n");
+    for (w = 0; w < workers; w++)
+    {
+        double d = ran ? sum_dev[w] / ran : 0;
+        ee_printf("%6u %7u %+8.1f%%%s\n",
+                  w,
+                  (ee_u32)pids[w],
+                  d,
+                  (d > (double)outlier || d < -(double)outlier) ? " OUTLIER"
+                                                               : "");
+    }
+    err = (ee_s16)failed;
+
+out_close:
+    for (w = 0; w < connected; w++)
+    {
+        if (err >= 0)
+        {
+            memset(&m, 0, sizeof(m));
+            cluster_send(fds[w], &m, CLUSTER_BYE);
+        }
+        close(fds[w]);
+    }
+    close(lfd);
+    unlink(path);
+    if (!attach)
+    {
+        for (w = 0; w < workers; w++)
+        {
+            int status;
+            if (pids[w] > 0 && waitpid(pids[w], &status, 0) == pids[w]
+                && (!WIFEXITED(status) || WEXITSTATUS(status)) && err >= 0)
+                err++;
+        }
+    }
+out_free:
+    portable_free(fds);
+    portable_free(pids);
+    portable_free(dev);
+    portable_free(sum_dev);
+    portable_free(results);
+    portable_free(jobs);
+    return err;
+}
+#endif /* CLUSTER_RUN */
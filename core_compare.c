@@ -0,0 +1,901 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Result files and regression detection.
+
+        Sample mode runs each kernel several times, with iterations
+        calibrated once per kernel and the samples interleaved between
+        kernels. The kernels are the full benchmark, run with <core_run>,
+        then the matrix and state benchmarks alone. The list benchmark is
+        not sampled alone, since it calls the other two from its comparator.
+        Plugins selected with --plugin are sampled as further kernels, named
+        after the plugin, with <core_plugin_sample>.
+        The samples can be stored in a result file (--json) and compared
+        against a result file stored before (--compare).
+
+        A result file holds entries, one per host fingerprint (see
+        <portable_fingerprint>) and configuration (seeds and size). Storing
+        results replaces the entry of the same host and configuration, and
+        keeps the others. Each entry holds the samples, in iterations per
+        second, of each kernel, with the compiler and flags of the build.
+
+        The comparison uses the entry of the same host and configuration.
+        For each kernel of the run, the samples are compared with the
+        Mann-Whitney U test, one sided, and the change of the median is
+        computed. A kernel regresses when the median is slower by more than
+        the threshold and the test is significant at the 5% level.
+*/
+#if COMPARE_RUN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COMPARE_KERNELS           3 /* built-in kernels */
+#define COMPARE_MAX_PLUGINS       8
+#define COMPARE_MAX_KERNELS       (COMPARE_KERNELS + COMPARE_MAX_PLUGINS)
+#define COMPARE_NAME_LEN          64
+#define COMPARE_MAX_SAMPLES       256
+#define COMPARE_MAX_ENTRIES       64
+#define COMPARE_DEFAULT_SAMPLES   10
+#define COMPARE_DEFAULT_MS        200  /* length of a sample */
+#define COMPARE_ALPHA             0.05 /* significance level */
+#define COMPARE_DEFAULT_THRESHOLD 2.0 /* percent */
+
+static const char *compare_names[COMPARE_KERNELS]
+    = { "all", "matrix", "state" };
+
+typedef struct COMPARE_ENTRY_S
+{
+    char     host[256];
+    char     config[128];
+    char     compiler[128];
+    char     flags[256];
+    ee_u32   kernels;
+    char     kernel[COMPARE_MAX_KERNELS][COMPARE_NAME_LEN];
+    ee_u32   num[COMPARE_MAX_KERNELS];
+    secs_ret samples[COMPARE_MAX_KERNELS][COMPARE_MAX_SAMPLES];
+} compare_entry;
+
+/* Function: compare_exp
+        Exponential by range reduction and Taylor series, to avoid a
+   dependency on libm.
+*/
+static secs_ret
+compare_exp(secs_ret x)
+{
+    secs_ret r = 1, term = 1, scale = 1;
+    int      k = 0, i;
+    if (x < -700)
+        return 0;
+    while (x > 0.5)
+    {
+        x -= 0.693147180559945309;
+        k++;
+    }
+    while (x < -0.5)
+    {
+        x += 0.693147180559945309;
+        k--;
+    }
+    for (i = 1; i < 20; i++)
+    {
+        term *= x / i;
+        r += term;
+    }
+    for (; k > 0; k--)
+        scale *= 2;
+    for (; k < 0; k++)
+        scale /= 2;
+    return r * scale;
+}
+
+/* Function: compare_sqrt
+        Square root by Newton iterations.
+*/
+static secs_ret
+compare_sqrt(secs_ret x)
+{
+    secs_ret r = x > 1 ? x : 1;
+    int      i;
+    if (x <= 0)
+        return 0;
+    for (i = 0; i < 64; i++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+/* Function: compare_phi
+        Standard normal cumulative distribution (Zelen and Severo, error
+   below 1e-7).
+*/
+static secs_ret
+compare_phi(secs_ret z)
+{
+    secs_ret x = z < 0 ? -z : z, t = 1 / (1 + 0.2316419 * x), p;
+    p = 0.398942280401432678 * compare_exp(-x * x / 2) * t
+        * (0.319381530
+           + t * (-0.356563782
+                  + t * (1.781477937 + t * (-1.821255978 + t * 1.330274429))));
+    return z < 0 ? p : 1 - p;
+}
+
+/* Function: compare_median
+        Median of samples, sorted in place.
+*/
+static secs_ret
+compare_median(secs_ret *v, ee_u32 n)
+{
+    ee_u32 i, j;
+    for (i = 1; i < n; i++)
+    {
+        secs_ret x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+    if (n == 0)
+        return 0;
+    return (n & 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* Function: compare_mann_whitney
+        One sided Mann-Whitney U test that the new samples are smaller than
+   the base samples, with the normal approximation corrected for ties and
+   continuity. Both sets must be sorted.
+
+        Returns:
+        p-value.
+*/
+static secs_ret
+compare_mann_whitney(const secs_ret *base,
+                     ee_u32          nb,
+                     const secs_ret *cur,
+                     ee_u32          nc)
+{
+    secs_ret rank_sum = 0, ties = 0, n = nb + nc, mean, var, u;
+    ee_u32   i = 0, j = 0, rank = 1;
+    if (nb == 0 || nc == 0)
+        return 1;
+    /* merge the sorted sets, giving tied values their average rank */
+    while (i < nb || j < nc)
+    {
+        secs_ret v = (j == nc || (i < nb && base[i] < cur[j])) ? base[i]
+                                                                : cur[j];
+        ee_u32   tb = 0, tc = 0, t;
+        while (i < nb && base[i] == v)
+        {
+            i++;
+            tb++;
+        }
+        while (j < nc && cur[j] == v)
+        {
+            j++;
+            tc++;
+        }
+        t = tb + tc;
+        rank_sum += tc * (rank + (secs_ret)(t - 1) / 2);
+        ties += (secs_ret)t * t * t - t;
+        rank += t;
+    }
+    u    = rank_sum - (secs_ret)nc * (nc + 1) / 2;
+    mean = (secs_ret)nb * nc / 2;
+    var  = (secs_ret)nb * nc / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (var <= 0)
+        return u < mean ? 0 : 1;
+    return compare_phi((u - mean + 0.5) / compare_sqrt(var));
+}
+
+/* Function: json_skip
+        Skip white space.
+*/
+static const char *
+json_skip(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    return p;
+}
+
+/* Function: json_string
+        Parse a string into <out>, truncated to <len>.
+
+        Returns:
+        Position after the string, NULL on a syntax error.
+*/
+static const char *
+json_string(const char *p, char *out, ee_u32 len)
+{
+    ee_u32 n = 0;
+    p        = json_skip(p);
+    if (*p++ != '"')
+        return NULL;
+    while (*p && *p != '"')
+    {
+        char c = *p++;
+        if (c == '\\')
+        {
+            c = *p++;
+            if (c == 'n')
+                c = '\n';
+            else if (c == 't')
+                c = '\t';
+            else if (c == 0)
+                return NULL;
+        }
+        if (n + 1 < len)
+            out[n++] = c;
+    }
+    if (len)
+        out[n] = 0;
+    return *p == '"' ? p + 1 : NULL;
+}
+
+/* Function: json_value
+        Skip any value.
+
+        Returns:
+        Position after the value, NULL on a syntax error.
+*/
+static const char *
+json_value(const char *p)
+{
+    char   tmp[1];
+    ee_u32 depth = 0;
+    p            = json_skip(p);
+    if (*p == '"')
+        return json_string(p, tmp, 0);
+    if (*p != '{' && *p != '[')
+    {
+        while (*p && *p != ',' && *p != '}' && *p != ']')
+            p++;
+        return p;
+    }
+    do
+    {
+        if (*p == '"')
+        {
+            p = json_string(p, tmp, 0);
+            if (p == NULL)
+                return NULL;
+            continue;
+        }
+        if (*p == '{' || *p == '[')
+            depth++;
+        else if (*p == '}' || *p == ']')
+            depth--;
+        else if (*p == 0)
+            return NULL;
+        p++;
+    } while (depth);
+    return p;
+}
+
+/* Function: json_object
+        Parse the members of an object, calling <member> for each key. The
+   callback parses the value and returns the position after it.
+
+        Returns:
+        Position after the object, NULL on a syntax error.
+*/
+static const char *
+json_object(const char *p,
+            const char *(*member)(const char *key, const char *p, void *arg),
+            void *arg)
+{
+    char key[64];
+    p = json_skip(p);
+    if (*p++ != '{')
+        return NULL;
+    p = json_skip(p);
+    if (*p == '}')
+        return p + 1;
+    for (;;)
+    {
+        p = json_string(p, key, sizeof(key));
+        if (p == NULL)
+            return NULL;
+        p = json_skip(p);
+        if (*p++ != ':')
+            return NULL;
+        p = member(key, p, arg);
+        if (p == NULL)
+            return NULL;
+        p = json_skip(p);
+        if (*p == '}')
+            return p + 1;
+        if (*p++ != ',')
+            return NULL;
+    }
+}
+
+/* Function: compare_kernel_index
+        Index of the kernel <name> in an entry, <e->kernels> if none.
+*/
+static ee_u32
+compare_kernel_index(const compare_entry *e, const char *name)
+{
+    ee_u32 k;
+    for (k = 0; k < e->kernels; k++)
+    {
+        if (strcmp(e->kernel[k], name) == 0)
+            break;
+    }
+    return k;
+}
+
+/* Function: json_kernel
+        Parse the samples of a kernel, an array of numbers.
+*/
+static const char *
+json_kernel(const char *key, const char *p, void *arg)
+{
+    compare_entry *e = (compare_entry *)arg;
+    ee_u32         k = compare_kernel_index(e, key);
+    if (k == e->kernels)
+    {
+        if (k == COMPARE_MAX_KERNELS || strlen(key) >= COMPARE_NAME_LEN)
+            return json_value(p);
+        strcpy(e->kernel[k], key);
+        e->kernels++;
+    }
+    p = json_skip(p);
+    if (*p++ != '[')
+        return NULL;
+    e->num[k] = 0;
+    for (;;)
+    {
+        char *end;
+        p = json_skip(p);
+        if (*p == ']')
+            return p + 1;
+        if (e->num[k] < COMPARE_MAX_SAMPLES)
+            e->samples[k][e->num[k]++] = strtod(p, &end);
+        else
+            strtod(p, &end);
+        if (end == p)
+            return NULL;
+        p = json_skip(end);
+        if (*p == ',')
+            p++;
+        else if (*p != ']')
+            return NULL;
+    }
+}
+
+/* Function: json_entry
+        Parse a member of an entry.
+*/
+static const char *
+json_entry(const char *key, const char *p, void *arg)
+{
+    compare_entry *e = (compare_entry *)arg;
+    if (strcmp(key, "host") == 0)
+        return json_string(p, e->host, sizeof(e->host));
+    if (strcmp(key, "config") == 0)
+        return json_string(p, e->config, sizeof(e->config));
+    if (strcmp(key, "compiler") == 0)
+        return json_string(p, e->compiler, sizeof(e->compiler));
+    if (strcmp(key, "flags") == 0)
+        return json_string(p, e->flags, sizeof(e->flags));
+    if (strcmp(key, "kernels") == 0)
+        return json_object(p, json_kernel, e);
+    return json_value(p);
+}
+
+typedef struct COMPARE_FILE_S
+{
+    compare_entry *entries;
+    ee_u32         num;
+} compare_file;
+
+/* Function: json_file
+        Parse a member of the top level object of a result file.
+*/
+static const char *
+json_file(const char *key, const char *p, void *arg)
+{
+    compare_file *f = (compare_file *)arg;
+    if (strcmp(key, "entries") != 0)
+        return json_value(p);
+    p = json_skip(p);
+    if (*p++ != '[')
+        return NULL;
+    for (;;)
+    {
+        p = json_skip(p);
+        if (*p == ']')
+            return p + 1;
+        if (f->num == COMPARE_MAX_ENTRIES)
+            return NULL;
+        memset(&f->entries[f->num], 0, sizeof(compare_entry));
+        p = json_object(p, json_entry, &f->entries[f->num]);
+        if (p == NULL)
+            return NULL;
+        f->num++;
+        p = json_skip(p);
+        if (*p == ',')
+            p++;
+        else if (*p != ']')
+            return NULL;
+    }
+}
+
+/* Function: compare_load
+        Load a result file.
+
+        Returns:
+        0 on success, 1 if the file is missing, 2 if it cannot be parsed.
+*/
+static ee_s16
+compare_load(const char *filename, compare_file *f)
+{
+    FILE *fp = fopen(filename, "rb");
+    char *text;
+    long  len;
+    int   ok;
+    f->num = 0;
+    if (fp == NULL)
+        return 1;
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    text = (char *)portable_malloc(len > 0 ? (size_t)len + 1 : 1);
+    if (text == NULL)
+    {
+        fclose(fp);
+        return 2;
+    }
+    len       = (long)fread(text, 1, len > 0 ? (size_t)len : 0, fp);
+    text[len] = 0;
+    fclose(fp);
+    ok = json_object(text, json_file, f) != NULL;
+    portable_free(text);
+    if (!ok)
+    {
+        ee_printf("ERROR! Cannot parse result file %s\n", filename);
+        return 2;
+    }
+    return 0;
+}
+
+/* Function: json_put
+        Write a string with the characters JSON requires escaped.
+*/
+static void
+json_put(FILE *fp, const char *s)
+{
+    fputc('"', fp);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', fp);
+        if (*s == '\n')
+            fputs("\\n", fp);
+        else if ((unsigned char)*s >= ' ')
+            fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+/* Function: compare_store
+        Write a result file.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+static ee_s16
+compare_store(const char *filename, const compare_file *f)
+{
+    FILE * fp = fopen(filename, "w");
+    ee_u32 i, k, s;
+    if (fp == NULL)
+    {
+        ee_printf("ERROR! Cannot write result file %s\n", filename);
+        return 1;
+    }
+    fprintf(fp, "{\n  \"coremark_results\": 1,\n  \"entries\": [");
+    for (i = 0; i < f->num; i++)
+    {
+        const compare_entry *e = &f->entries[i];
+        fprintf(fp, "%s\n    {\n      \"host\": ", i ? "," : "");
+        json_put(fp, e->host);
+        fprintf(fp, ",\n      \"config\": ");
+        json_put(fp, e->config);
+        fprintf(fp, ",\n      \"compiler\": ");
+        json_put(fp, e->compiler);
+        fprintf(fp, ",\n      \"flags\": ");
+        json_put(fp, e->flags);
+        fprintf(fp, ",\n      \"kernels\": {");
+        for (k = 0; k < e->kernels; k++)
+        {
+            fprintf(fp, "%s\n        \"%s\": [", k ? "," : "", e->kernel[k]);
+            for (s = 0; s < e->num[k]; s++)
+                fprintf(fp, "%s%.3f", s ? ", " : "", e->samples[k][s]);
+            fprintf(fp, "]");
+        }
+        fprintf(fp, "\n      }\n    }");
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    return fclose(fp) == 0 ? 0 : 1;
+}
+
+/* Function: compare_find
+        Index of the entry of a host and configuration, <f->num> if none.
+*/
+static ee_u32
+compare_find(const compare_file *f, const compare_entry *e)
+{
+    ee_u32 i;
+    for (i = 0; i < f->num; i++)
+    {
+        if (strcmp(f->entries[i].host, e->host) == 0
+            && strcmp(f->entries[i].config, e->config) == 0)
+            break;
+    }
+    return i;
+}
+
+/* Function: compare_kernel
+        Run <n> iterations of a kernel alone, on the data of <r>.
+
+        The full benchmark runs with <core_run>, which also checks its crcs.
+   The matrix and state benchmarks run directly, the way the list benchmark
+   calls them from its comparator, with a step that changes each iteration.
+   Kernels after the built-in ones are the plugins in <plugin>.
+
+        Returns:
+        Iterations per second, 0 if the run failed.
+*/
+static secs_ret
+compare_kernel(ee_u32           k,
+               core_results *   r,
+               core_run_config *cfg,
+               core_plugin_ctx **plugin,
+               ee_u32           n)
+{
+    core_run_result out;
+    secs_ret        start;
+    ee_u16          crc = 0;
+    ee_u32          i;
+#if PLUGIN_RUN
+    if (k >= COMPARE_KERNELS)
+        return core_plugin_sample(plugin[k - COMPARE_KERNELS], n);
+#else
+    (void)plugin;
+#endif
+    if (k == 0)
+    {
+        cfg->iterations = n;
+        if (core_run(cfg, &out) < 0)
+            return 0;
+        return out.iterations_per_sec;
+    }
+    start = portable_time();
+    for (i = 0; i < n; i++)
+    {
+        ee_s16 step = (ee_s16)(0x22 + (i & 0x5d));
+        if (k == 1)
+            crc = core_bench_matrix(&r->mat, step, crc);
+        else
+            crc = core_bench_state(
+                r->size, r->memblock[3], r->seed1, r->seed2, step, crc);
+    }
+    r->crc = crc; /* keep the results live */
+    return n / (portable_time() - start);
+}
+
+/* Function: compare_sample
+        Collect the samples of every kernel.
+
+        Returns:
+        0 on success, 1 if a run failed.
+*/
+static ee_s16
+compare_sample(core_results *res, compare_entry *e, ee_u32 samples, ee_u32 ms)
+{
+    core_run_config  cfg;
+    core_results     r;
+    core_plugin_ctx *plugin[COMPARE_MAX_PLUGINS];
+    ee_u32           iterations[COMPARE_MAX_KERNELS], k, s;
+    ee_s16           err = 0;
+
+    memset(&r, 0, sizeof(r));
+    memset(plugin, 0, sizeof(plugin));
+    r.seed1          = res->seed1;
+    r.seed2          = res->seed2;
+    r.seed3          = res->seed3;
+    r.execs          = ALL_ALGORITHMS_MASK;
+    r.size           = res->size;
+    r.memblock[0]    = portable_malloc(res->size);
+    cfg.seed1        = res->seed1;
+    cfg.seed2        = res->seed2;
+    cfg.seed3        = res->seed3;
+    cfg.target_ms    = ms;
+    cfg.execs        = ALL_ALGORITHMS_MASK;
+    cfg.size         = res->size;
+    cfg.memblock     = portable_malloc(res->size);
+    if (r.memblock[0] == NULL || cfg.memblock == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate %u bytes\n", res->size);
+        err = 1;
+        goto out_free;
+    }
+    core_init_data(&r, 1);
+#if PLUGIN_RUN
+    /* plugins run with the seeds and size per algorithm of the full
+     * benchmark */
+    for (k = COMPARE_KERNELS; k < e->kernels && !err; k++)
+    {
+        plugin[k - COMPARE_KERNELS] = core_plugin_open(e->kernel[k], &r);
+        if (plugin[k - COMPARE_KERNELS] == NULL)
+            err = 1;
+    }
+#endif
+
+    /* calibrate each kernel once, so that all its samples run the same
+     * iterations */
+    for (k = 0; k < e->kernels && !err; k++)
+    {
+        secs_ret ips;
+        e->num[k]     = 0;
+        iterations[k] = 1;
+        while ((ips = compare_kernel(k, &r, &cfg, plugin, iterations[k])) > 0
+               && iterations[k] / ips < ms / 1000.0)
+        {
+            if (iterations[k] > 0x7fffffff / 2)
+                break;
+            iterations[k] *= 2;
+        }
+        if (ips == 0)
+            err = 1;
+    }
+    for (s = 0; s < samples && !err; s++)
+    {
+        for (k = 0; k < e->kernels; k++)
+        {
+            secs_ret ips = compare_kernel(k, &r, &cfg, plugin, iterations[k]);
+            if (ips == 0)
+            {
+                err = 1;
+                break;
+            }
+            e->samples[k][e->num[k]++] = ips;
+        }
+    }
+    if (err)
+        ee_printf("ERROR! Run failed\n");
+out_free:
+#if PLUGIN_RUN
+    for (k = 0; k < COMPARE_MAX_PLUGINS; k++)
+    {
+        if (plugin[k])
+            core_plugin_close(plugin[k]);
+    }
+#endif
+    if (cfg.memblock)
+        portable_free(cfg.memblock);
+    if (r.memblock[0])
+        portable_free(r.memblock[0]);
+    return err;
+}
+
+/* Function: compare_report
+        Compare the samples of an entry with the baseline, per kernel.
+
+        Returns:
+        Number of kernels that regressed.
+*/
+static ee_u32
+compare_report(compare_entry *base, compare_entry *cur, secs_ret threshold)
+{
+    secs_ret vb[COMPARE_MAX_SAMPLES], vc[COMPARE_MAX_SAMPLES];
+    ee_u32   i, k, regressions = 0;
+    ee_printf("Baseline build   : %s %s\n", base->compiler, base->flags);
+    ee_printf("Kernel       Baseline       Current   Change  p(slower)  "
+              "Status\n");
+    for (k = 0; k < cur->kernels; k++)
+    {
+        ee_u32      b = compare_kernel_index(base, cur->kernel[k]);
+        secs_ret    mb, mc, change, p;
+        const char *status;
+        if (b == base->kernels || base->num[b] == 0 || cur->num[k] == 0)
+        {
+            ee_printf("%-8s  (no samples)\n", cur->kernel[k]);
+            continue;
+        }
+        /* samples are stored in run order, sort copies */
+        for (i = 0; i < base->num[b]; i++)
+            vb[i] = base->samples[b][i];
+        for (i = 0; i < cur->num[k]; i++)
+            vc[i] = cur->samples[k][i];
+        mb     = compare_median(vb, base->num[b]);
+        mc     = compare_median(vc, cur->num[k]);
+        change = mb > 0 ? 100 * (mc - mb) / mb : 0;
+        p      = compare_mann_whitney(vb, base->num[b], vc, cur->num[k]);
+        if (-change > threshold && p < COMPARE_ALPHA)
+        {
+            status = "REGRESSION";
+            regressions++;
+        }
+        else if (p < COMPARE_ALPHA)
+            status = "slower, within threshold";
+        else if (1 - p < COMPARE_ALPHA && change > 0)
+            status = "faster";
+        else
+            status = "ok";
+        ee_printf("%-8s %12.3f  %12.3f %+7.2f%%  %9.4f  %s\n",
+                  cur->kernel[k],
+                  mb,
+                  mc,
+                  change,
+                  p,
+                  status);
+    }
+    return regressions;
+}
+
+/* Function: core_compare_run
+        Collect samples, store them and compare them with a baseline.
+
+        Parameters:
+        res - seeds and total size of the data block.
+        json_file - result file to store the samples in, or NULL.
+        baseline - result file to compare with, or NULL.
+        samples - samples per kernel, 0 for <COMPARE_DEFAULT_SAMPLES>.
+        sample_ms - length of a sample, 0 for <COMPARE_DEFAULT_MS>.
+        threshold - slowdown of the median, in percent, above which a
+   significant difference is a regression, NULL for
+   <COMPARE_DEFAULT_THRESHOLD>.
+        plugins - plugins to sample as further kernels, separated by ',', or
+   NULL.
+
+        Returns:
+        0 on success, 1 on error, 2 if a kernel regressed.
+*/
+ee_s16
+core_compare_run(core_results *res,
+                 const char *  json_file,
+                 const char *  baseline,
+                 ee_u32        samples,
+                 ee_u32        sample_ms,
+                 const char *  threshold,
+                 const char *  plugins)
+{
+    compare_file  f;
+    compare_entry cur;
+    ee_u32        i, k;
+    ee_s16        err      = 0;
+    secs_ret      slowdown = COMPARE_DEFAULT_THRESHOLD;
+
+    if (samples == 0)
+        samples = COMPARE_DEFAULT_SAMPLES;
+    if (samples > COMPARE_MAX_SAMPLES)
+        samples = COMPARE_MAX_SAMPLES;
+    if (sample_ms == 0)
+        sample_ms = COMPARE_DEFAULT_MS;
+    if (threshold != NULL && *threshold)
+        slowdown = strtod(threshold, NULL);
+    f.entries = (compare_entry *)portable_malloc(COMPARE_MAX_ENTRIES
+                                                 * sizeof(compare_entry));
+    if (f.entries == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate result entries\n");
+        return 1;
+    }
+    memset(&cur, 0, sizeof(cur));
+    portable_fingerprint(cur.host, sizeof(cur.host));
+    snprintf(cur.config,
+             sizeof(cur.config),
+             "seeds 0x%x 0x%x 0x%x size %u",
+             (ee_u16)res->seed1,
+             (ee_u16)res->seed2,
+             (ee_u16)res->seed3,
+             res->size);
+    snprintf(cur.compiler, sizeof(cur.compiler), "%s", COMPILER_VERSION);
+    snprintf(cur.flags, sizeof(cur.flags), "%s", COMPILER_FLAGS);
+    for (k = 0; k < COMPARE_KERNELS; k++)
+        strcpy(cur.kernel[cur.kernels++], compare_names[k]);
+    while (plugins != NULL && *plugins)
+    {
+        ee_u32 n = 0;
+        while (plugins[n] && plugins[n] != ',')
+            n++;
+        if (n >= COMPARE_NAME_LEN || cur.kernels == COMPARE_MAX_KERNELS)
+        {
+            ee_printf("ERROR! At most %d plugins of %d characters can be "
+                      "sampled\n",
+                      COMPARE_MAX_PLUGINS,
+                      COMPARE_NAME_LEN - 1);
+            portable_free(f.entries);
+            return 1;
+        }
+        memcpy(cur.kernel[cur.kernels], plugins, n);
+        cur.kernel[cur.kernels++][n] = 0;
+        plugins += plugins[n] ? n + 1 : n;
+    }
+
+    ee_printf("Host             : %s\n", cur.host);
+    ee_printf("Configuration    : %s\n", cur.config);
+    ee_printf("Samples          : %u of %u ms per kernel\n", samples, sample_ms);
+    if (compare_sample(res, &cur, samples, sample_ms))
+    {
+        portable_free(f.entries);
+        return 1;
+    }
+    for (k = 0; k < cur.kernels; k++)
+    {
+        secs_ret v[COMPARE_MAX_SAMPLES];
+        for (i = 0; i < cur.num[k]; i++)
+            v[i] = cur.samples[k][i];
+        ee_printf("%-8s median  : %f iterations/sec\n",
+                  cur.kernel[k],
+                  compare_median(v, cur.num[k]));
+    }
+
+    if (baseline != NULL)
+    {
+        if (compare_load(baseline, &f) != 0)
+        {
+            ee_printf("ERROR! Cannot read baseline %s\n", baseline);
+            err = 1;
+        }
+        else if ((i = compare_find(&f, &cur)) == f.num)
+        {
+            ee_printf("ERROR! No baseline entry for this host and "
+                      "configuration in %s, entries are:\n",
+                      baseline);
+            for (i = 0; i < f.num; i++)
+                ee_printf("  %s / %s\n",
+                          f.entries[i].host,
+                          f.entries[i].config);
+            err = 1;
+        }
+        else
+        {
+            if (compare_report(&f.entries[i], &cur, slowdown) > 0)
+            {
+                ee_printf("Regression detected (threshold %.2f%%)\n",
+                          slowdown);
+                err = 2;
+            }
+        }
+    }
+    if (json_file != NULL)
+    {
+        if (compare_load(json_file, &f) == 2)
+            err = 1;
+        else
+        {
+            i = compare_find(&f, &cur);
+            if (i < COMPARE_MAX_ENTRIES)
+            {
+                f.entries[i] = cur;
+                if (i == f.num)
+                    f.num++;
+            }
+            if (compare_store(json_file, &f) == 0)
+                ee_printf("Results stored in %s\n", json_file);
+            else if (err == 0)
+                err = 1;
+        }
+    }
+    portable_free(f.entries);
+    return err;
+}
+#endif /* COMPARE_RUN */
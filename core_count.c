@@ -0,0 +1,248 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Instruction count mode.
+
+        Wall clock scores are too noisy to gate each commit on shared
+        machines. This mode runs each kernel exactly once between
+        <start_time> and <stop_time>, and reports what the port counts in
+        that section with <portable_counts>, the retired instructions. These
+        counts do not depend on the load of the machine. Cache misses are
+        only counted under callgrind, by the count_report target of the
+        Makefile.
+
+        The kernels are one iteration of the benchmark, checked against the
+        known crcs, then one run of the matrix and of the state
+        benchmark alone. Each kernel starts from freshly initialized data.
+
+        The counts can be stored as budgets (--count-save), and checked
+        against budgets stored before (--count=<file>). A kernel fails when
+        a count exceeds its budget by more than the tolerance.
+
+        When the counts are collected outside the process, e.g. by callgrind
+        (see the count_report target of the Makefile), the mode only runs
+        the kernels.
+*/
+#if COUNT_RUN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COUNT_KERNELS           3
+#define COUNT_DEFAULT_TOLERANCE 0.1 /* percent */
+
+static const char *count_names[COUNT_KERNELS] = { "all", "matrix", "state" };
+
+/* Function: count_kernel
+        Run one kernel once, as the timed section.
+
+        Returns:
+        Number of crcs of the iteration that differ from the known values.
+*/
+static ee_s16
+count_kernel(ee_u32 k, core_results *r, ee_u32 size, ee_u16 *crc)
+{
+    ee_u16 seedcrc;
+    ee_s16 known_id;
+
+    r->size = size;
+    core_init_data(r, 1);
+    r->iterations = 1;
+    start_time();
+    if (k == 0)
+        iterate(r);
+    else if (k == 1)
+        r->crc = core_bench_matrix(&r->mat, 0x22, 0);
+    else
+        r->crc = core_bench_state(
+            r->size, r->memblock[3], r->seed1, r->seed2, 0x22, 0);
+    stop_time();
+    *crc = r->crc;
+    if (k != 0)
+        return 0;
+    known_id = core_known_id(r, &seedcrc);
+    if (known_id < 0)
+        return 0; /* seeds that cannot be validated */
+    return core_check_crcs(r, 1, known_id);
+}
+
+/* Function: count_load
+        Load budgets, lines of kernel name and instructions. Further fields,
+   e.g. the misses of count_report, are ignored. Lines starting with '#' are
+   comments.
+
+        Returns:
+        0 on success, 1 if the file cannot be read.
+*/
+static ee_s16
+count_load(const char *filename, core_counts *budget, ee_u8 *found)
+{
+    FILE * fp = fopen(filename, "r");
+    char   line[256], name[64];
+    ee_u32 k;
+    if (fp == NULL)
+        return 1;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        unsigned long long instructions;
+        if (line[0] == '#'
+            || sscanf(line, "%63s %llu", name, &instructions) < 2)
+            continue;
+        for (k = 0; k < COUNT_KERNELS; k++)
+        {
+            if (strcmp(name, count_names[k]) == 0)
+            {
+                budget[k].instructions = instructions;
+                found[k]               = 1;
+            }
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* Function: count_over
+        Percentage by which a count exceeds its budget, 0 if it does not.
+*/
+static secs_ret
+count_over(ee_u64 count, ee_u64 budget)
+{
+    if (count <= budget || budget == 0)
+        return 0;
+    return 100 * (secs_ret)(count - budget) / (secs_ret)budget;
+}
+
+/* Function: core_count_run
+        Count each kernel, then store or check the budgets.
+
+        Parameters:
+        res - seeds and total size of the data block.
+        budget_file - budgets to check the counts against, or NULL.
+        save_file - file to store the counts in as budgets, or NULL.
+        tolerance - percent by which a count may exceed its budget, NULL
+   for <COUNT_DEFAULT_TOLERANCE>.
+
+        Returns:
+        0 on success, 1 on error, 2 if a count exceeds its budget.
+*/
+ee_s16
+core_count_run(core_results *res,
+               const char *  budget_file,
+               const char *  save_file,
+               const char *  tolerance)
+{
+    core_results r;
+    core_counts  counts[COUNT_KERNELS], budget[COUNT_KERNELS];
+    ee_u8        found[COUNT_KERNELS];
+    ee_u16       crc;
+    ee_u32       k;
+    ee_s16       err = 0, counted = 0;
+    secs_ret     tol = COUNT_DEFAULT_TOLERANCE;
+
+    if (tolerance != NULL && *tolerance)
+        tol = strtod(tolerance, NULL);
+    memset(&r, 0, sizeof(r));
+    memset(budget, 0, sizeof(budget));
+    memset(found, 0, sizeof(found));
+    r.seed1       = res->seed1;
+    r.seed2       = res->seed2;
+    r.seed3       = res->seed3;
+    r.execs       = ALL_ALGORITHMS_MASK;
+    r.memblock[0] = portable_malloc(res->size);
+    if (r.memblock[0] == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate %u bytes\n", res->size);
+        return 1;
+    }
+    if (portable_count_open() != 0)
+    {
+        ee_printf("ERROR! No instruction counter on this system\n");
+        portable_free(r.memblock[0]);
+        return 1;
+    }
+
+    for (k = 0; k < COUNT_KERNELS; k++)
+    {
+        /* the counts are still reported, as the scores of a regular run */
+        if (count_kernel(k, &r, res->size, &crc))
+            ee_printf("WARNING! Iteration of %s does not give the known crcs\n",
+                      count_names[k]);
+        counted = portable_counts(count_names[k], &counts[k]) == 0;
+        if (k == 0)
+            ee_printf("Counter source   : %s\n", counts[k].source);
+        if (!counted)
+            ee_printf("%-8s crc 0x%04x, counted outside the process\n",
+                      count_names[k],
+                      crc);
+    }
+    portable_free(r.memblock[0]);
+    if (!counted)
+        return 0;
+
+    if (budget_file != NULL && count_load(budget_file, budget, found) != 0)
+    {
+        ee_printf("ERROR! Cannot read budgets %s\n", budget_file);
+        return 1;
+    }
+    ee_printf("Kernel     Instructions        Budget  Status\n");
+    for (k = 0; k < COUNT_KERNELS; k++)
+    {
+        secs_ret over = count_over(counts[k].instructions,
+                                   budget[k].instructions);
+        ee_printf("%-8s %14llu",
+                  count_names[k],
+                  (unsigned long long)counts[k].instructions);
+        if (!found[k])
+        {
+            ee_printf("             -%s\n", budget_file ? "  no budget" : "");
+            continue;
+        }
+        ee_printf(" %13llu", (unsigned long long)budget[k].instructions);
+        if (over > tol)
+        {
+            ee_printf("  OVER BUDGET (+%.3f%% instructions)\n", over);
+            err = 2;
+        }
+        else
+            ee_printf("  ok\n");
+    }
+    if (err)
+        ee_printf("Budget exceeded (tolerance %.3f%%)\n", tol);
+
+    if (save_file != NULL)
+    {
+        FILE *fp = fopen(save_file, "w");
+        if (fp == NULL)
+        {
+            ee_printf("ERROR! Cannot write budgets %s\n", save_file);
+            return 1;
+        }
+        fprintf(fp, "# kernel instructions (%s)\n", counts[0].source);
+        for (k = 0; k < COUNT_KERNELS; k++)
+            fprintf(fp,
+                    "%s %llu\n",
+                    count_names[k],
+                    (unsigned long long)counts[k].instructions);
+        if (fclose(fp) != 0)
+            return 1;
+        ee_printf("Budgets stored in %s\n", save_file);
+    }
+    return err;
+}
+#endif /* COUNT_RUN */
@@ -0,0 +1,419 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Per cpu score map.
+
+        A score of several contexts hides a core that is throttled,
+        mis-clocked or has a broken cache way. This mode runs one context
+        pinned to each cpu of a list, with <portable_set_affinity>, either one
+        cpu at a time or in groups of cpus that run at the same time. Every
+        context has its own <core_results> and memory block, and runs the same
+        iterations, calibrated once with <core_run>.
+
+        Each cpu is measured <CPUMAP_DEFAULT_REPEATS> times, in rounds over
+        all the cpus so that drift affects all of them alike, and its score is
+        the median of its measurements. A cpu is an outlier when its modified
+        z-score, its deviation from the median of all cpus in units of their
+        median absolute deviation, exceeds <CPUMAP_OUTLIER_Z>, and it deviates
+        by more than <CPUMAP_MIN_DEVIATION> percent. A cpu whose final crc
+        differs from that of the majority of the cpus computes wrong results.
+
+        The table can also be written as CSV for scripts, one line per cpu.
+*/
+#if CPUMAP_RUN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define CPUMAP_MAX_CPUS        1024
+#define CPUMAP_MAX_REPEATS     16
+#define CPUMAP_DEFAULT_REPEATS 3
+#define CPUMAP_DEFAULT_MS      500 /* length of a measurement */
+#define CPUMAP_OUTLIER_Z       3.5
+#define CPUMAP_MIN_DEVIATION   3 /* percent */
+
+typedef struct CPUMAP_CPU_S
+{
+    core_results res;
+    ee_u32       cpu;
+    ee_u32       size; /* total size of the memory block */
+    ee_u8        pinned;
+    ee_u32       n;
+    secs_ret     ips[CPUMAP_MAX_REPEATS];
+    secs_ret     score;
+    secs_ret     dev; /* deviation from the median of all cpus, percent */
+    secs_ret     z;   /* modified z-score */
+    const char * status;
+    pthread_t    thread;
+} cpumap_cpu;
+
+/* Function: cpumap_parse
+        Parse a list of cpus such as "0-3,8,10-11".
+
+        Returns:
+        Number of cpus, 0 if the list is invalid.
+*/
+static ee_u32
+cpumap_parse(const char *list, ee_u32 *cpus)
+{
+    ee_u32 n = 0;
+    while (*list)
+    {
+        char * end;
+        ee_u32 first = (ee_u32)strtoul(list, &end, 0), last = first;
+        if (end == list)
+            return 0;
+        if (*end == '-')
+        {
+            list = end + 1;
+            last = (ee_u32)strtoul(list, &end, 0);
+            if (end == list || last < first)
+                return 0;
+        }
+        for (; first <= last && n < CPUMAP_MAX_CPUS; first++)
+            cpus[n++] = first;
+        list = end;
+        if (*list == ',')
+            list++;
+        else if (*list)
+            return 0;
+    }
+    return n;
+}
+
+/* Function: cpumap_median
+        Median of <n> values, sorted in place.
+*/
+static secs_ret
+cpumap_median(secs_ret *v, ee_u32 n)
+{
+    ee_u32 i, j;
+    for (i = 1; i < n; i++)
+    {
+        secs_ret x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+    if (n == 0)
+        return 0;
+    return (n & 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/* Function: cpumap_worker
+        Measure one cpu: pin the thread, initialize the data, then time the
+   iterations.
+*/
+static void *
+cpumap_worker(void *arg)
+{
+    cpumap_cpu *c = (cpumap_cpu *)arg;
+    secs_ret    t;
+    c->pinned   = portable_set_affinity(c->cpu);
+    c->res.size = c->size;
+    core_init_data(&c->res, 1);
+    t = portable_time();
+    iterate(&c->res);
+    t = portable_time() - t;
+    if (c->pinned && t > 0)
+        c->ips[c->n++] = c->res.iterations / t;
+    return NULL;
+}
+
+/* Function: cpumap_majority
+        Final crc computed by most cpus, by the Boyer-Moore majority vote.
+*/
+static ee_u16
+cpumap_majority(const cpumap_cpu *c, ee_u32 n)
+{
+    ee_u16 crc   = 0;
+    ee_u32 i, votes = 0;
+    for (i = 0; i < n; i++)
+    {
+        if (!c[i].pinned)
+            continue;
+        if (votes == 0)
+            crc = c[i].res.crc;
+        votes += c[i].res.crc == crc ? 1 : (ee_u32)-1;
+    }
+    return crc;
+}
+
+/* Function: core_cpumap_run
+        Measure each cpu of a list, and flag the outliers.
+
+        Parameters:
+        res - seeds, algorithms and total size of the data block.
+        list - cpus to measure, NULL or "" for all the cpus online.
+        group - cpus measured at the same time, 0 for 1.
+        ms - length of a measurement, 0 for <CPUMAP_DEFAULT_MS>.
+        repeats - measurements of each cpu, 0 for <CPUMAP_DEFAULT_REPEATS>.
+        csv_file - file to write the table to as CSV, or NULL.
+
+        Returns:
+        0 on success, 1 on error, 2 if a cpu is slow, fails or computes wrong
+   results.
+*/
+ee_s16
+core_cpumap_run(core_results *res,
+                const char *  list,
+                ee_u32        group,
+                ee_u32        ms,
+                ee_u32        repeats,
+                const char *  csv_file)
+{
+    static ee_u32   cpus[CPUMAP_MAX_CPUS];
+    cpumap_cpu *    c;
+    void **         blocks;
+    core_run_config cfg;
+    core_run_result out;
+    secs_ret *      v, median, mad;
+    ee_u32          n, i, g, r, m;
+    ee_u16          crc, seedcrc;
+    ee_s16          err = 0, known_id;
+
+    if (list != NULL && *list)
+        n = cpumap_parse(list, cpus);
+    else
+    {
+        n = portable_num_cpus();
+        if (n > CPUMAP_MAX_CPUS)
+            n = CPUMAP_MAX_CPUS;
+        for (i = 0; i < n; i++)
+            cpus[i] = i;
+    }
+    if (n == 0)
+    {
+        ee_printf("ERROR! Invalid list of cpus %s\n", list);
+        return 1;
+    }
+    if (group == 0)
+        group = 1;
+    if (group > n)
+        group = n;
+    if (ms == 0)
+        ms = CPUMAP_DEFAULT_MS;
+    if (repeats == 0)
+        repeats = CPUMAP_DEFAULT_REPEATS;
+    if (repeats > CPUMAP_MAX_REPEATS)
+        repeats = CPUMAP_MAX_REPEATS;
+
+    c      = (cpumap_cpu *)portable_malloc(n * sizeof(cpumap_cpu));
+    v      = (secs_ret *)portable_malloc(n * sizeof(secs_ret));
+    blocks = (void **)portable_malloc(group * sizeof(void *));
+    if (blocks != NULL)
+        memset(blocks, 0, group * sizeof(void *));
+    if (c == NULL || v == NULL || blocks == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate the cpu map\n");
+        err = 1;
+        goto out_free;
+    }
+    /* one memory block per cpu of a group, reused by the next groups */
+    for (g = 0; g < group; g++)
+    {
+        blocks[g] = portable_malloc(res->size);
+        if (blocks[g] == NULL)
+        {
+            ee_printf("ERROR! Cannot allocate %u bytes\n", res->size);
+            err = 1;
+            goto out_free;
+        }
+    }
+
+    cfg.seed1      = res->seed1;
+    cfg.seed2      = res->seed2;
+    cfg.seed3      = res->seed3;
+    cfg.iterations = 0;
+    cfg.target_ms  = ms;
+    cfg.execs      = res->execs;
+    cfg.size       = res->size;
+    cfg.memblock   = blocks[0];
+    if (core_run(&cfg, &out) < 0)
+    {
+        ee_printf("ERROR! Invalid configuration\n");
+        err = 1;
+        goto out_free;
+    }
+    memset(c, 0, n * sizeof(cpumap_cpu));
+    for (i = 0; i < n; i++)
+    {
+        c[i].cpu            = cpus[i];
+        c[i].size           = res->size;
+        c[i].res.seed1      = res->seed1;
+        c[i].res.seed2      = res->seed2;
+        c[i].res.seed3      = res->seed3;
+        c[i].res.execs      = res->execs;
+        c[i].res.iterations = out.iterations;
+        c[i].pinned         = 1;
+    }
+    ee_printf("CPU map          : %u cpus, %u at a time, %u x %lu iterations "
+              "each\n",
+              n,
+              group,
+              repeats,
+              (long unsigned)out.iterations);
+
+    for (r = 0; r < repeats; r++)
+    {
+        for (i = 0; i < n; i += group)
+        {
+            m = n - i < group ? n - i : group;
+            for (g = 0; g < m; g++)
+            {
+                c[i + g].res.memblock[0] = blocks[g];
+                pthread_create(
+                    &c[i + g].thread, NULL, cpumap_worker, &c[i + g]);
+            }
+            for (g = 0; g < m; g++)
+                pthread_join(c[i + g].thread, NULL);
+        }
+    }
+
+    /* scores, then the median and the median absolute deviation */
+    crc = cpumap_majority(c, n);
+    for (i = 0, m = 0; i < n; i++)
+    {
+        if (c[i].n == 0)
+            continue;
+        c[i].score = cpumap_median(c[i].ips, c[i].n);
+        if (c[i].res.crc == crc)
+            v[m++] = c[i].score;
+    }
+    if (m == 0)
+    {
+        ee_printf("ERROR! No cpu could be measured\n");
+        err = 1;
+        goto out_free;
+    }
+    median = cpumap_median(v, m);
+    for (i = 0, m = 0; i < n; i++)
+    {
+        if (c[i].n == 0 || c[i].res.crc != crc)
+            continue;
+        v[m++] = c[i].score > median ? c[i].score - median
+                                     : median - c[i].score;
+    }
+    mad = cpumap_median(v, m);
+
+    ee_printf("CPU   Iterations/Sec    Min/Max (%%)   Deviation  Z-score  "
+              "Status\n");
+    for (i = 0; i < n; i++)
+    {
+        cpumap_cpu *p = &c[i];
+        if (p->n == 0)
+        {
+            p->status = "unpinned";
+            err       = 2;
+            ee_printf("%4u %16s %14s %11s %8s  %s\n",
+                      p->cpu,
+                      "-",
+                      "-",
+                      "-",
+                      "-",
+                      p->status);
+            continue;
+        }
+        p->dev = 100 * (p->score - median) / median;
+        p->z   = mad > 0 ? 0.6745 * (p->score - median) / mad : 0;
+        if (p->res.crc != crc)
+        {
+            p->status = "WRONG CRC";
+            err       = 2;
+        }
+        else if ((p->z < -CPUMAP_OUTLIER_Z || mad == 0)
+                 && p->dev < -CPUMAP_MIN_DEVIATION)
+        {
+            p->status = "SLOW";
+            err       = 2;
+        }
+        else if ((p->z > CPUMAP_OUTLIER_Z || mad == 0)
+                 && p->dev > CPUMAP_MIN_DEVIATION)
+            p->status = "fast";
+        else
+            p->status = "ok";
+        ee_printf("%4u %16.3f %+6.1f/%+-7.1f %+10.2f%% %8.2f  %s\n",
+                  p->cpu,
+                  p->score,
+                  100 * (p->ips[0] - p->score) / p->score,
+                  100 * (p->ips[p->n - 1] - p->score) / p->score,
+                  p->dev,
+                  p->z,
+                  p->status);
+    }
+    ee_printf("Median           : %f iterations/sec, MAD %f (%.2f%%)\n",
+              median,
+              mad,
+              100 * mad / median);
+
+    /* validate the crcs of the majority once, as a regular run does */
+    for (i = 0; i < n && (c[i].n == 0 || c[i].res.crc != crc); i++)
+        ;
+    known_id = core_known_id(&c[i].res, &seedcrc);
+    if (known_id >= 0 && core_check_crcs(&c[i].res, 1, known_id) == 0)
+        ee_printf("Correct operation validated.\n");
+    else if (known_id >= 0)
+        ee_printf("Errors detected\n");
+    else
+        ee_printf("Cannot validate operation for these seed values.\n");
+
+    if (csv_file != NULL)
+    {
+        FILE *fp = fopen(csv_file, "w");
+        if (fp == NULL)
+        {
+            ee_printf("ERROR! Cannot write %s\n", csv_file);
+            err = 1;
+            goto out_free;
+        }
+        fprintf(fp,
+                "cpu,iterations_per_sec,deviation_percent,zscore,crcfinal,"
+                "status\n");
+        for (i = 0; i < n; i++)
+            fprintf(fp,
+                    "%u,%.3f,%.3f,%.3f,0x%04x,%s\n",
+                    c[i].cpu,
+                    c[i].score,
+                    c[i].dev,
+                    c[i].z,
+                    c[i].res.crc,
+                    c[i].status);
+        if (fclose(fp) != 0)
+            err = 1;
+        else
+            ee_printf("CPU map stored in %s\n", csv_file);
+    }
+out_free:
+    if (blocks != NULL)
+    {
+        for (g = 0; g < group; g++)
+        {
+            if (blocks[g] != NULL)
+                portable_free(blocks[g]);
+        }
+        portable_free(blocks);
+    }
+    if (v != NULL)
+        portable_free(v);
+    if (c != NULL)
+        portable_free(c);
+    return err;
+}
+#endif /* CPUMAP_RUN */
@@ -0,0 +1,619 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Metrics exporter daemon mode.
+
+        The process stays in the background at the lowest priority, see
+        <portable_background>, and runs a short probe of the benchmark every
+        interval. A probe calibrates <core_run> for a slice of the probe
+        length, then runs <DAEMON_SLICES> slices of that many iterations. The
+        score is the median of the slices; the spread of the slices gives the
+        noise of the host.
+
+        The metrics of the last probe are kept in the Prometheus text format,
+        served over HTTP on a loopback TCP port or a Unix domain socket, and
+        written to a file, e.g. for the textfile collector of the node
+        exporter. The file is written to <file>.tmp then renamed, so readers
+        never see a partial file.
+
+        Requests are served between probes from the same thread: a request
+        that arrives during a probe waits for its end. The daemon stops on
+        SIGTERM or SIGINT.
+*/
+#if DAEMON_RUN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define DAEMON_DEFAULT_PORT     9150
+#define DAEMON_DEFAULT_INTERVAL 300  /* seconds between probes */
+#define DAEMON_DEFAULT_PROBE_MS 1000 /* length of a probe */
+#define DAEMON_SLICES           5    /* timed slices of a probe */
+#define DAEMON_METRICS_SIZE     8192
+#define DAEMON_REQUEST_MS       1000 /* to wait for the request line */
+
+/* Results of the last probe */
+typedef struct DAEMON_PROBE_S
+{
+    secs_ret score;  /* median iterations per second of the slices */
+    secs_ret noise;  /* standard deviation of the slices, percent of mean */
+    secs_ret spread; /* max - min of the slices, percent of the median */
+    secs_ret mhz;    /* frequency of the cpu, 0 if unknown */
+    secs_ret secs;   /* length of the probe */
+    ee_u32   iterations;
+    ee_s16   known_id;
+    ee_s16   errors;
+    ee_u16   crcfinal;
+    long     time; /* wall clock time of the end of the probe */
+} daemon_probe;
+
+static volatile sig_atomic_t daemon_stop;
+
+static void
+daemon_signal(int sig)
+{
+    (void)sig;
+    daemon_stop = 1;
+}
+
+/* Function: daemon_sqrt
+        Square root by Newton iterations, to avoid a dependency on libm.
+*/
+static secs_ret
+daemon_sqrt(secs_ret x)
+{
+    secs_ret r = x > 1 ? x : 1;
+    int      i;
+    if (x <= 0)
+        return 0;
+    for (i = 0; i < 64; i++)
+        r = (r + x / r) / 2;
+    return r;
+}
+
+/* Function: daemon_probe_run
+        Run one probe of about <probe_ms> milliseconds.
+
+        Returns:
+        0 on success, 1 if a run failed.
+*/
+static ee_s16
+daemon_probe_run(core_run_config *cfg, ee_u32 probe_ms, daemon_probe *p)
+{
+    core_run_result out;
+    secs_ret        ips[DAEMON_SLICES], x, mean = 0, var = 0;
+    secs_ret        start = portable_time();
+    ee_u32          s, j;
+
+    /* the calibration also warms up the caches and the frequency */
+    cfg->iterations = 0;
+    cfg->target_ms  = probe_ms / (DAEMON_SLICES + 1);
+    if (cfg->target_ms == 0)
+        cfg->target_ms = 1;
+    if (core_run(cfg, &out) < 0)
+        return 1;
+    cfg->iterations = out.iterations;
+    p->errors       = 0;
+    for (s = 0; s < DAEMON_SLICES; s++)
+    {
+        if (s == DAEMON_SLICES / 2)
+            p->mhz = portable_cpu_mhz();
+        if (core_run(cfg, &out) < 0 || out.iterations_per_sec <= 0)
+            return 1;
+        if (out.errors > p->errors)
+            p->errors = out.errors;
+        /* insertion sort, for the median */
+        x = out.iterations_per_sec;
+        for (j = s; j > 0 && ips[j - 1] > x; j--)
+            ips[j] = ips[j - 1];
+        ips[j] = x;
+        mean += x;
+    }
+    mean /= DAEMON_SLICES;
+    for (s = 0; s < DAEMON_SLICES; s++)
+        var += (ips[s] - mean) * (ips[s] - mean);
+    var /= DAEMON_SLICES - 1;
+    p->score      = ips[DAEMON_SLICES / 2];
+    p->noise      = 100 * daemon_sqrt(var) / mean;
+    p->spread     = 100 * (ips[DAEMON_SLICES - 1] - ips[0]) / p->score;
+    p->iterations = out.iterations;
+    p->known_id   = out.known_id;
+    p->crcfinal   = out.crcfinal;
+    p->secs       = portable_time() - start;
+    p->time       = (long)time(NULL);
+    return 0;
+}
+
+/* Function: daemon_put
+        Append formatted text to the metrics, truncated to the buffer.
+*/
+static void
+daemon_put(char *buf, ee_u32 *pos, const char *fmt, ...)
+{
+    va_list ap;
+    int     n;
+    if (*pos >= DAEMON_METRICS_SIZE - 1)
+        return;
+    va_start(ap, fmt);
+    n = vsnprintf(buf + *pos, DAEMON_METRICS_SIZE - *pos, fmt, ap);
+    va_end(ap);
+    if (n > 0)
+        *pos += (ee_u32)n;
+    if (*pos > DAEMON_METRICS_SIZE - 1)
+        *pos = DAEMON_METRICS_SIZE - 1;
+}
+
+/* Function: daemon_metric
+        Append a metric without labels, with its help and type lines.
+*/
+static void
+daemon_metric(char *      buf,
+              ee_u32 *    pos,
+              const char *name,
+              const char *type,
+              const char *help,
+              secs_ret    value)
+{
+    daemon_put(buf, pos, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    daemon_put(buf, pos, "%s %.12g\n", name, value);
+}
+
+/* Function: daemon_escape
+        Copy a label value, escaping backslashes, quotes and newlines.
+*/
+static void
+daemon_escape(char *dst, ee_u32 len, const char *src)
+{
+    ee_u32 n = 0;
+    for (; *src && n + 2 < len; src++)
+    {
+        if (*src == '\\' || *src == '"' || *src == '\n')
+        {
+            dst[n++] = '\\';
+            dst[n++] = *src == '\n' ? 'n' : *src;
+        }
+        else
+            dst[n++] = *src;
+    }
+    dst[n] = 0;
+}
+
+/* Function: daemon_format
+        Format the metrics of the last probe, <p> is NULL before the first
+   probe completes.
+
+        Returns:
+        Length of the metrics.
+*/
+static ee_u32
+daemon_format(char *              buf,
+              const core_results *res,
+              const daemon_probe *p,
+              ee_u32              probes,
+              ee_u32              failures,
+              ee_u32              interval)
+{
+    char   compiler[256], flags[256];
+    ee_u32 pos = 0;
+
+    daemon_escape(compiler, sizeof(compiler), COMPILER_VERSION);
+    daemon_escape(flags, sizeof(flags), COMPILER_FLAGS);
+    daemon_put(buf,
+               &pos,
+               "# HELP coremark_info Build and configuration of the probe.\n"
+               "# TYPE coremark_info gauge\n"
+               "coremark_info{version=\"1.0\",compiler=\"%s\",flags=\"%s\","
+               "seeds=\"0x%x 0x%x 0x%x\",size=\"%u\"} 1\n",
+               compiler,
+               flags,
+               (ee_u16)res->seed1,
+               (ee_u16)res->seed2,
+               (ee_u16)res->seed3,
+               res->size);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_up",
+                  "gauge",
+                  "1 once a probe completed.",
+                  p != NULL);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_probes_total",
+                  "counter",
+                  "Probes run.",
+                  probes);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_probe_failures_total",
+                  "counter",
+                  "Probes that failed to run.",
+                  failures);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_probe_interval_seconds",
+                  "gauge",
+                  "Time between the start of two probes.",
+                  interval);
+    if (p == NULL)
+        return pos;
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_iterations_per_second",
+                  "gauge",
+                  "Score of the last probe, median of its slices.",
+                  p->score);
+    if (p->mhz > 0)
+    {
+        daemon_metric(buf,
+                      &pos,
+                      "coremark_cpu_frequency_mhz",
+                      "gauge",
+                      "Frequency of the cpu during the last probe.",
+                      p->mhz);
+        daemon_metric(buf,
+                      &pos,
+                      "coremark_iterations_per_second_per_mhz",
+                      "gauge",
+                      "Score of the last probe divided by the frequency.",
+                      p->score / p->mhz);
+    }
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_noise_percent",
+                  "gauge",
+                  "Standard deviation of the slices, percent of their mean.",
+                  p->noise);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_spread_percent",
+                  "gauge",
+                  "Fastest minus slowest slice, percent of the median.",
+                  p->spread);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_crc_validated",
+                  "gauge",
+                  "1 if the seeds have known crcs to validate against.",
+                  p->known_id >= 0);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_crc_errors",
+                  "gauge",
+                  "Crcs of the last probe that differ from the known values.",
+                  p->errors);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_crcfinal",
+                  "gauge",
+                  "Final crc of the last probe.",
+                  p->crcfinal);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_probe_iterations",
+                  "gauge",
+                  "Iterations of each slice of the last probe.",
+                  p->iterations);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_probe_duration_seconds",
+                  "gauge",
+                  "Length of the last probe.",
+                  p->secs);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_duty_cycle_ratio",
+                  "gauge",
+                  "Length of the last probe over the interval.",
+                  p->secs / interval);
+    daemon_metric(buf,
+                  &pos,
+                  "coremark_last_probe_timestamp_seconds",
+                  "gauge",
+                  "Time of the end of the last probe.",
+                  (secs_ret)p->time);
+    return pos;
+}
+
+/* Function: daemon_write
+        Write the metrics to <file> atomically.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+static ee_s16
+daemon_write(const char *file, const char *metrics, ee_u32 len)
+{
+    char  tmp[512];
+    FILE *fp;
+    int   err;
+    snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+    fp = fopen(tmp, "w");
+    if (fp == NULL)
+        return 1;
+    err = fwrite(metrics, 1, len, fp) != len;
+    err |= fflush(fp) != 0 || fsync(fileno(fp)) != 0;
+    err |= fclose(fp) != 0;
+    if (err || rename(tmp, file) != 0)
+    {
+        unlink(tmp);
+        return 1;
+    }
+    return 0;
+}
+
+/* Function: daemon_listen
+        Listen on a loopback TCP port if <addr> is a number, or else on a
+   Unix domain socket at the path <addr>.
+
+        Returns:
+        The listening socket, or -1 on error.
+*/
+static int
+daemon_listen(const char *addr)
+{
+    const char *c;
+    int         fd, one = 1;
+    for (c = addr; *c >= '0' && *c <= '9'; c++)
+        ;
+    if (*c == 0)
+    {
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family      = AF_INET;
+        sa.sin_port        = htons((ee_u16)atoi(addr));
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd                 = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    else
+    {
+        struct sockaddr_un sa;
+        if (strlen(addr) >= sizeof(sa.sun_path))
+            return -1;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        strcpy(sa.sun_path, addr);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        unlink(addr); /* left by a daemon that was killed */
+        if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, 8) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Function: daemon_path_is
+        Whether the request line asks for <path>, with or without a query.
+*/
+static ee_u8
+daemon_path_is(const char *req, const char *path)
+{
+    size_t n = strlen(path);
+    return strncmp(req, path, n) == 0
+           && (req[n] == ' ' || req[n] == '?' || req[n] == '\r'
+               || req[n] == '\n');
+}
+
+/* Function: daemon_serve
+        Answer one HTTP request on a new connection: the metrics for GET /
+   and GET /metrics, an error otherwise. The connection is closed after the
+   answer.
+*/
+static void
+daemon_serve(int lfd, const char *metrics, ee_u32 len)
+{
+    char          req[1024], head[256];
+    const char *  status = "200 OK", *body = metrics;
+    ee_u32        n = 0, body_len = len;
+    struct pollfd pfd;
+    int           fd = accept(lfd, NULL, NULL);
+    if (fd < 0)
+        return;
+    pfd.fd     = fd;
+    pfd.events = POLLIN;
+    /* only the request line matters */
+    while (n < sizeof(req) - 1 && memchr(req, '\n', n) == NULL
+           && poll(&pfd, 1, DAEMON_REQUEST_MS) > 0)
+    {
+        ssize_t r = read(fd, req + n, sizeof(req) - 1 - n);
+        if (r <= 0)
+            break;
+        n += (ee_u32)r;
+    }
+    req[n] = 0;
+    if (strncmp(req, "GET ", 4) != 0)
+    {
+        status   = "405 Method Not Allowed";
+        body     = "Method not allowed\n";
+        body_len = (ee_u32)strlen(body);
+    }
+    else if (!daemon_path_is(req + 4, "/")
+             && !daemon_path_is(req + 4, "/metrics"))
+    {
+        status   = "404 Not Found";
+        body     = "Not found, the metrics are at /metrics\n";
+        body_len = (ee_u32)strlen(body);
+    }
+    n = (ee_u32)snprintf(head,
+                         sizeof(head),
+                         "HTTP/1.0 %s\r\n"
+                         "Content-Type: text/plain; version=0.0.4\r\n"
+                         "Content-Length: %u\r\n"
+                         "Connection: close\r\n\r\n",
+                         status,
+                         body_len);
+    if (send(fd, head, n, MSG_NOSIGNAL) == (ssize_t)n)
+        send(fd, body, body_len, MSG_NOSIGNAL);
+    close(fd);
+}
+
+/* Function: core_daemon_run
+        Run the metrics exporter until SIGTERM or SIGINT.
+
+        Parameters:
+        res - seeds and total size of the data block.
+        addr - loopback TCP port or Unix domain socket path to serve the
+   metrics on, "" for <DAEMON_DEFAULT_PORT>, "0" to not serve them.
+        file - file to write the metrics to after each probe, or NULL.
+        interval - seconds between probes, 0 for <DAEMON_DEFAULT_INTERVAL>.
+        probe_ms - length of a probe, 0 for <DAEMON_DEFAULT_PROBE_MS>.
+        budget - percent of one cpu the process may use, 0 for no limit.
+        cgroup - cgroup to run in and to limit, NULL for the cgroup of the
+   process.
+
+        Returns:
+        0 on a clean stop, 1 on error.
+*/
+ee_s16
+core_daemon_run(core_results *res,
+                const char *  addr,
+                const char *  file,
+                ee_u32        interval,
+                ee_u32        probe_ms,
+                ee_u32        budget,
+                const char *  cgroup)
+{
+    static char      metrics[DAEMON_METRICS_SIZE];
+    struct sigaction sa;
+    core_run_config  cfg;
+    daemon_probe     probe;
+    ee_u32           len, probes = 0, failures = 0;
+    ee_u8            ok = 0;
+    int              lfd = -1;
+    secs_ret         next;
+
+    if (interval == 0)
+        interval = DAEMON_DEFAULT_INTERVAL;
+    if (probe_ms == 0)
+        probe_ms = DAEMON_DEFAULT_PROBE_MS;
+    if (addr == NULL || *addr == 0)
+    {
+        static char port[16];
+        snprintf(port, sizeof(port), "%u", DAEMON_DEFAULT_PORT);
+        addr = port;
+    }
+    if (strcmp(addr, "0") == 0 && file == NULL)
+    {
+        ee_printf("ERROR! The daemon needs a socket or a file (--daemon-file)\n");
+        return 1;
+    }
+    cfg.seed1    = res->seed1;
+    cfg.seed2    = res->seed2;
+    cfg.seed3    = res->seed3;
+    cfg.execs    = ALL_ALGORITHMS_MASK;
+    cfg.size     = res->size;
+    cfg.memblock = portable_malloc(res->size);
+    if (cfg.memblock == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate %u bytes\n", res->size);
+        return 1;
+    }
+    if (strcmp(addr, "0") != 0)
+    {
+        lfd = daemon_listen(addr);
+        if (lfd < 0)
+        {
+            ee_printf("ERROR! Cannot listen on %s: %s\n", addr, strerror(errno));
+            portable_free(cfg.memblock);
+            return 1;
+        }
+    }
+    if (portable_background(budget, cgroup) != 0)
+        ee_printf("WARNING! Cannot limit the daemon to %u%% of a cpu\n",
+                  budget);
+
+    /* no SA_RESTART, so that a signal interrupts the wait */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    daemon_stop = 0;
+
+    ee_printf("Daemon           : probe of %u ms every %u s, serving on %s\n",
+              probe_ms,
+              interval,
+              lfd >= 0 ? addr : "no socket");
+    if (file != NULL)
+        ee_printf("Metrics file     : %s\n", file);
+
+    len  = daemon_format(metrics, res, NULL, 0, 0, interval);
+    next = portable_time();
+    while (!daemon_stop)
+    {
+        secs_ret      wait = next - portable_time();
+        struct pollfd pfd;
+        if (wait <= 0)
+        {
+            probes++;
+            if (daemon_probe_run(&cfg, probe_ms, &probe) == 0)
+                ok = 1;
+            else
+                failures++;
+            len = daemon_format(
+                metrics, res, ok ? &probe : NULL, probes, failures, interval);
+            if (file != NULL && daemon_write(file, metrics, len) != 0)
+                ee_printf("WARNING! Cannot write %s\n", file);
+            /* keep the schedule, unless the probe overran it */
+            next += interval;
+            if (next < portable_time())
+                next = portable_time() + interval;
+            continue;
+        }
+        pfd.fd     = lfd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, lfd >= 0, (int)(wait * 1000) + 1) > 0)
+            daemon_serve(lfd, metrics, len);
+    }
+    ee_printf("Daemon stopped after %u probes\n", probes);
+    if (lfd >= 0)
+    {
+        close(lfd);
+        if (strspn(addr, "0123456789") != strlen(addr))
+            unlink(addr);
+    }
+    portable_free(cfg.memblock);
+    return 0;
+}
+#endif /* DAEMON_RUN */
@@ -0,0 +1,367 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Heterogeneous cores.
+
+        On hybrid processors (P and E cores, big.LITTLE), contexts run on
+        whichever cores the scheduler picks, so scores are not reproducible.
+        <portable_core_types> classifies the cpus, fastest class first.
+
+        The hybrid mode measures, with one pinned thread per cpu:
+        - for each class, the score of one cpu of the class, and of all the
+        cpus of the class at the same time.
+        - for all the cpus at the same time, the score with the same
+        iterations on every cpu (static), as the parallel contexts of a
+        regular run, where the slowest cpu sets the time. Then the score when
+        the cpus take chunks of iterations from a shared counter until all are
+        done (dynamic), so that faster cpus run proportionally more
+        iterations.
+
+        All threads run the iterations of one context, calibrated once. The
+        crcs of the first iterations of each thread are checked against those
+        of a reference run.
+
+        Without a hybrid topology, there is a single class, and regular runs
+        are not changed.
+*/
+#if HYBRID_RUN
+#include <string.h>
+#include <pthread.h>
+
+#define HYBRID_MAX_CPUS   1024
+#define HYBRID_DEFAULT_MS 1000 /* calibration of a context */
+#define HYBRID_CHUNKS     16   /* chunks of the iterations of a context */
+
+/* Shared work of a run */
+typedef struct HYBRID_WORK_S
+{
+    ee_u32 size;  /* total size of a memory block */
+    ee_u32 total; /* dynamic: iterations to run by all threads */
+    ee_u32 chunk; /* dynamic: iterations taken at a time, 0 for static */
+    ee_u32 next;  /* dynamic: first iteration not taken yet */
+} hybrid_work;
+
+typedef struct HYBRID_THREAD_S
+{
+    core_results res;
+    ee_u32       cpu;
+    ee_u32       done; /* iterations run */
+    ee_u8        pinned;
+    ee_u16       crclist, crcmatrix, crcstate; /* of the first chunk */
+    hybrid_work *work;
+    pthread_t    thread;
+} hybrid_thread;
+
+static ee_u8       hybrid_type[HYBRID_MAX_CPUS];
+static const char *hybrid_names[HYBRID_MAX_TYPES];
+static ee_u32      hybrid_num_cpus, hybrid_num_types;
+
+/* Function: hybrid_detect
+        Classify the cpus once.
+*/
+static void
+hybrid_detect(void)
+{
+    if (hybrid_num_types != 0)
+        return;
+    hybrid_num_cpus = portable_num_cpus();
+    if (hybrid_num_cpus > HYBRID_MAX_CPUS)
+        hybrid_num_cpus = HYBRID_MAX_CPUS;
+    hybrid_num_types
+        = portable_core_types(hybrid_type, hybrid_num_cpus, hybrid_names);
+}
+
+/* Function: hybrid_cpus
+        Print the cpus of a class as ranges, e.g. "0-7,16".
+*/
+static void
+hybrid_cpus(ee_u32 t)
+{
+    ee_u32 i, first, sep = 0;
+    for (i = 0; i < hybrid_num_cpus; i++)
+    {
+        if (hybrid_type[i] != t)
+            continue;
+        for (first = i; i + 1 < hybrid_num_cpus && hybrid_type[i + 1] == t;
+             i++)
+            ;
+        if (first == i)
+            ee_printf("%s%u", sep++ ? "," : "", i);
+        else
+            ee_printf("%s%u-%u", sep++ ? "," : "", first, i);
+    }
+}
+
+/* Function: core_hybrid_print
+        Report the core types of a hybrid processor, nothing otherwise.
+*/
+void
+core_hybrid_print(void)
+{
+    ee_u32 t;
+    hybrid_detect();
+    if (hybrid_num_types < 2)
+        return;
+    ee_printf("Core types       : ");
+    for (t = 0; t < hybrid_num_types; t++)
+    {
+        ee_printf("%s%s (", t ? ", " : "", hybrid_names[t]);
+        hybrid_cpus(t);
+        ee_printf(")");
+    }
+    ee_printf("\n");
+}
+
+/* Function: hybrid_worker
+        Run the iterations of one thread, pinned to its cpu.
+*/
+static void *
+hybrid_worker(void *arg)
+{
+    hybrid_thread *t = (hybrid_thread *)arg;
+    hybrid_work *  w = t->work;
+    ee_u32         n = t->res.iterations, start;
+
+    t->pinned   = portable_set_affinity(t->cpu);
+    t->res.size = w->size;
+    core_init_data(&t->res, 1);
+    t->done = 0;
+    for (;;)
+    {
+        if (w->chunk)
+        {
+            start = __sync_fetch_and_add(&w->next, w->chunk);
+            if (start >= w->total)
+                break;
+            n = w->total - start < w->chunk ? w->total - start : w->chunk;
+        }
+        else if (t->done)
+            break;
+        t->res.iterations = n;
+        iterate(&t->res);
+        /* later chunks start from data changed by the earlier ones */
+        if (t->done == 0)
+        {
+            t->crclist   = t->res.crclist;
+            t->crcmatrix = t->res.crcmatrix;
+            t->crcstate  = t->res.crcstate;
+        }
+        t->done += n;
+    }
+    return NULL;
+}
+
+/* Function: hybrid_run
+        Run a thread on each of the <n> cpus at the same time.
+
+        Returns:
+        Time of the run in seconds, 0 if a thread failed.
+*/
+static secs_ret
+hybrid_run(hybrid_thread *        t,
+           const ee_u32 *         cpus,
+           ee_u32                 n,
+           hybrid_work *          w,
+           const core_results *   res,
+           const core_run_result *ref)
+{
+    secs_ret start;
+    ee_u32   i;
+    ee_u8    ok = 1;
+
+    w->next = 0;
+    for (i = 0; i < n; i++)
+    {
+        t[i].cpu            = cpus[i];
+        t[i].work           = w;
+        t[i].res.seed1      = res->seed1;
+        t[i].res.seed2      = res->seed2;
+        t[i].res.seed3      = res->seed3;
+        t[i].res.execs      = res->execs;
+        t[i].res.iterations = ref->iterations;
+    }
+    start = portable_time();
+    for (i = 0; i < n; i++)
+        pthread_create(&t[i].thread, NULL, hybrid_worker, &t[i]);
+    for (i = 0; i < n; i++)
+        pthread_join(t[i].thread, NULL);
+    start = portable_time() - start;
+    for (i = 0; i < n; i++)
+    {
+        if (!t[i].pinned)
+        {
+            ee_printf("ERROR! Cannot run on cpu %u\n", t[i].cpu);
+            ok = 0;
+        }
+        else if (t[i].crclist != ref->crclist
+                 || t[i].crcmatrix != ref->crcmatrix
+                 || t[i].crcstate != ref->crcstate)
+        {
+            ee_printf("ERROR! Wrong crcs on cpu %u\n", t[i].cpu);
+            ok = 0;
+        }
+    }
+    return ok ? start : 0;
+}
+
+/* Function: core_hybrid_run
+        Measure each class of cpus, then all the cpus with the static and the
+   dynamic distribution of the iterations.
+
+        Parameters:
+        res - seeds, algorithms and total size of the data block.
+        ms - calibration of a context, 0 for <HYBRID_DEFAULT_MS>.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+ee_s16
+core_hybrid_run(core_results *res, ee_u32 ms)
+{
+    static ee_u32   cpus[HYBRID_MAX_CPUS];
+    hybrid_thread * t;
+    hybrid_work     w;
+    core_run_config cfg;
+    core_run_result ref;
+    secs_ret        secs, stat = 0, dyn = 0;
+    ee_u32          i, k, n, share[HYBRID_MAX_TYPES];
+    ee_s16          err = 0;
+
+    hybrid_detect();
+    if (ms == 0)
+        ms = HYBRID_DEFAULT_MS;
+    t = (hybrid_thread *)portable_malloc(hybrid_num_cpus
+                                         * sizeof(hybrid_thread));
+    if (t == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate the threads\n");
+        return 1;
+    }
+    memset(t, 0, hybrid_num_cpus * sizeof(hybrid_thread));
+    for (i = 0; i < hybrid_num_cpus; i++)
+    {
+        t[i].res.memblock[0] = portable_malloc(res->size);
+        if (t[i].res.memblock[0] == NULL)
+        {
+            ee_printf("ERROR! Cannot allocate %u bytes\n", res->size);
+            err = 1;
+            goto out_free;
+        }
+    }
+
+    /* reference run: the iterations of a context and its crcs */
+    cfg.seed1      = res->seed1;
+    cfg.seed2      = res->seed2;
+    cfg.seed3      = res->seed3;
+    cfg.iterations = 0;
+    cfg.target_ms  = ms;
+    cfg.execs      = res->execs;
+    cfg.size       = res->size;
+    cfg.memblock   = t[0].res.memblock[0];
+    if (core_run(&cfg, &ref) < 0)
+    {
+        ee_printf("ERROR! Invalid configuration\n");
+        err = 1;
+        goto out_free;
+    }
+    w.size  = res->size;
+    w.chunk = 0;
+    w.total = 0;
+
+    if (hybrid_num_types < 2)
+        ee_printf("Core types       : no hybrid topology found\n");
+    else
+        core_hybrid_print();
+    ee_printf("Iterations       : %lu per context\n",
+              (long unsigned)ref.iterations);
+    ee_printf("Class          CPUs    Single-core       All-core   "
+              "Per cpu\n");
+    for (k = 0; k < hybrid_num_types && !err; k++)
+    {
+        secs_ret one, all;
+        for (i = 0, n = 0; i < hybrid_num_cpus; i++)
+        {
+            if (hybrid_type[i] == k)
+                cpus[n++] = i;
+        }
+        one = hybrid_run(t, cpus, 1, &w, res, &ref);
+        all = hybrid_run(t, cpus, n, &w, res, &ref);
+        if (one == 0 || all == 0)
+        {
+            err = 1;
+            break;
+        }
+        ee_printf("%-14s %4u %14.3f %14.3f %9.3f\n",
+                  hybrid_names[k],
+                  n,
+                  ref.iterations / one,
+                  n * ref.iterations / all,
+                  ref.iterations / all);
+    }
+
+    /* all the cpus, static then dynamic distribution */
+    for (i = 0; i < hybrid_num_cpus; i++)
+        cpus[i] = i;
+    n = hybrid_num_cpus;
+    if (!err)
+    {
+        secs = hybrid_run(t, cpus, n, &w, res, &ref);
+        if (secs > 0)
+            stat = n * ref.iterations / secs;
+        w.total = n * ref.iterations;
+        w.chunk = ref.iterations / HYBRID_CHUNKS;
+        if (w.chunk == 0)
+            w.chunk = 1;
+        secs = hybrid_run(t, cpus, n, &w, res, &ref);
+        if (secs > 0)
+            dyn = w.total / secs;
+        if (stat == 0 || dyn == 0)
+            err = 1;
+    }
+    if (err)
+    {
+        ee_printf("Errors detected\n");
+        goto out_free;
+    }
+    ee_printf("All cpus static : %f iterations/sec\n", stat);
+    ee_printf("All cpus dynamic: %f iterations/sec (%+.2f%%)\n",
+              dyn,
+              100 * (dyn - stat) / stat);
+    if (hybrid_num_types > 1)
+    {
+        memset(share, 0, sizeof(share));
+        for (i = 0; i < n; i++)
+            share[hybrid_type[i]] += t[i].done;
+        ee_printf("Dynamic share   :");
+        for (k = 0; k < hybrid_num_types; k++)
+            ee_printf(" %s %.1f%%",
+                      hybrid_names[k],
+                      100 * (secs_ret)share[k] / w.total);
+        ee_printf("\n");
+    }
+out_free:
+    for (i = 0; i < hybrid_num_cpus; i++)
+    {
+        if (t[i].res.memblock[0] != NULL)
+            portable_free(t[i].res.memblock[0]);
+    }
+    portable_free(t);
+    return err;
+}
+#endif /* HYBRID_RUN */
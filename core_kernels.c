@@ -0,0 +1,709 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Kernel variant registry.
+
+        The benchmark calls its kernels through <core_kernel>, a table of
+        function pointers. Each kernel has a reference implementation (the
+        one in the kernel's own file) and may have named variants, listed in
+        <core_variants> with the instruction set extension they require.
+        Variants are selected with --kernel=<kernel>:<variant>[,...] and
+        listed with --list-kernels.
+
+        A variant must give the same results as the reference, including any
+        side effect the benchmark relies on: a mergesort variant must call the
+        compare function on the same pairs in the same order (cmp_complex
+        updates the crcs), and a matrix variant must sum each element in the
+        same order (MATRES may be a floating point type).
+
+        --verify-all checks this before the timed run: every variant, and the
+        selected combination, runs a few iterations on randomized seeds and
+        sizes, and the crcs are compared with those of the reference kernels.
+*/
+#if KERNEL_REGISTRY
+#include <string.h>
+
+core_kernels core_kernel = { core_list_find,
+                             core_list_mergesort,
+                             matrix_mul_matrix,
+                             core_state_transition,
+                             crcu16 };
+
+enum CORE_KERNEL_ID
+{
+    KERNEL_ID_LIST_FIND = 0,
+    KERNEL_ID_LIST_MERGESORT,
+    KERNEL_ID_MATRIX_MUL_MATRIX,
+    KERNEL_ID_STATE_TRANSITION,
+    KERNEL_ID_CRCU16,
+    NUM_KERNELS
+};
+
+static const char *kernel_names[NUM_KERNELS] = {
+    "list_find", "list_mergesort", "matrix_mul_matrix", "state_transition",
+    "crcu16"
+};
+
+typedef struct CORE_VARIANT_S
+{
+    ee_u8       kernel; /* CORE_KERNEL_ID */
+    const char *name;
+    const char *isa;          /* required extension, NULL if none */
+    ee_u8 (*supported)(void); /* run time check of isa, NULL if none */
+    void (*init)(void);       /* builds tables, NULL if none */
+    union
+    {
+        list_head *(*list_find)(list_head *list, list_data *info);
+        list_head *(*list_mergesort)(list_head *   list,
+                                     list_cmp      cmp,
+                                     core_results *res);
+        void (*matrix_mul_matrix)(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+        enum CORE_STATE (*state_transition)(ee_u8 **instr,
+                                            ee_u32 *transition_count);
+        ee_u16 (*crcu16)(ee_u16 newval, ee_u16 crc);
+    } fn;
+} core_variant;
+
+/* Function: list_find_unrolled
+        <core_list_find>, two nodes per loop step.
+*/
+static list_head *
+list_find_unrolled(list_head *list, list_data *info)
+{
+    if (info->idx >= 0)
+    {
+        ee_s16 idx = info->idx;
+        while (list && list->next)
+        {
+            if (list->info->idx == idx)
+                return list;
+            list = list->next;
+            if (list->info->idx == idx)
+                return list;
+            list = list->next;
+        }
+        return (list && list->info->idx == idx) ? list : NULL;
+    }
+    else
+    {
+        ee_s16 data = info->data16;
+        while (list && list->next)
+        {
+            if ((list->info->data16 & 0xff) == data)
+                return list;
+            list = list->next;
+            if ((list->info->data16 & 0xff) == data)
+                return list;
+            list = list->next;
+        }
+        return (list && (list->info->data16 & 0xff) == data) ? list : NULL;
+    }
+}
+
+/* Function: list_mergesort_tailptr
+        <core_list_mergesort>, appending through a pointer to the last next
+   field instead of testing for an empty output list. Compares the same
+   pairs in the same order.
+*/
+static list_head *
+list_mergesort_tailptr(list_head *list, list_cmp cmp, core_results *res)
+{
+    list_head * p, *q, *e, **tail;
+    ee_s32      insize = 1, nmerges, psize, qsize;
+
+    do
+    {
+        p       = list;
+        tail    = &list;
+        nmerges = 0;
+        while (p)
+        {
+            nmerges++;
+            q = p;
+            for (psize = 0; psize < insize && q; psize++)
+                q = q->next;
+            qsize = insize;
+            while (psize > 0 || (qsize > 0 && q))
+            {
+                if (psize == 0
+                    || (qsize > 0 && q && cmp(p->info, q->info, res) > 0))
+                {
+                    e = q;
+                    q = q->next;
+                    qsize--;
+                }
+                else
+                {
+                    e = p;
+                    p = p->next;
+                    psize--;
+                }
+                *tail = e;
+                tail  = &e->next;
+            }
+            p = q;
+        }
+        *tail = NULL;
+        insize *= 2;
+    } while (nmerges > 1);
+    return list;
+}
+
+/* Function: matrix_mul_matrix_ikj
+        <matrix_mul_matrix> with the loops ordered to stream through rows of B
+   and C. Each element is still summed in increasing k order.
+*/
+static void
+matrix_mul_matrix_ikj(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k;
+    for (i = 0; i < N; i++)
+    {
+        MATRES *c = C + i * N;
+        for (j = 0; j < N; j++)
+            c[j] = 0;
+        for (k = 0; k < N; k++)
+        {
+            MATRES  a = (MATRES)A[i * N + k];
+            MATDAT *b = B + k * N;
+            for (j = 0; j < N; j++)
+                c[j] += a * (MATRES)b[j];
+        }
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_HAS_X86 1
+static ee_u8
+has_avx2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}
+
+/* Function: matrix_mul_matrix_ikj_avx2
+        <matrix_mul_matrix_ikj> compiled for AVX2. Fused multiply-add is not
+   enabled, so the results are rounded as in the reference.
+*/
+__attribute__((target("avx2"))) static void
+matrix_mul_matrix_ikj_avx2(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
+{
+    ee_u32 i, j, k;
+    for (i = 0; i < N; i++)
+    {
+        MATRES *c = C + i * N;
+        for (j = 0; j < N; j++)
+            c[j] = 0;
+        for (k = 0; k < N; k++)
+        {
+            MATRES  a = (MATRES)A[i * N + k];
+            MATDAT *b = B + k * N;
+            for (j = 0; j < N; j++)
+                c[j] += a * (MATRES)b[j];
+        }
+    }
+}
+#endif
+
+/* transition table: next state in bits 0-3, then up to two transition
+ * counters to increment in bits 4-7 and 8-11 (0xf for none) */
+#define STATE_NO_COUNT 0xf
+static ee_u16 state_table[NUM_CORE_STATES][256];
+
+/* Function: state_table_init
+        Build the transition table from the rules of <core_state_transition>.
+*/
+static void
+state_table_init(void)
+{
+    ee_u32 s, c;
+    for (s = 0; s < NUM_CORE_STATES; s++)
+    {
+        for (c = 0; c < 256; c++)
+        {
+            ee_u32 digit = (c >= '0') && (c <= '9');
+            ee_u32 next  = s, cnt1 = STATE_NO_COUNT, cnt2 = STATE_NO_COUNT;
+            switch (s)
+            {
+                case CORE_START:
+                    if (digit)
+                        next = CORE_INT;
+                    else if (c == '+' || c == '-')
+                        next = CORE_S1;
+                    else if (c == '.')
+                        next = CORE_FLOAT;
+                    else
+                    {
+                        next = CORE_INVALID;
+                        cnt2 = CORE_INVALID;
+                    }
+                    cnt1 = CORE_START;
+                    break;
+                case CORE_S1:
+                    next = digit ? CORE_INT
+                                 : (c == '.') ? CORE_FLOAT : CORE_INVALID;
+                    cnt1 = CORE_S1;
+                    break;
+                case CORE_INT:
+                    if (c == '.' || !digit)
+                    {
+                        next = (c == '.') ? CORE_FLOAT : CORE_INVALID;
+                        cnt1 = CORE_INT;
+                    }
+                    break;
+                case CORE_FLOAT:
+                    if (c == 'E' || c == 'e' || !digit)
+                    {
+                        next = (c == 'E' || c == 'e') ? CORE_S2 : CORE_INVALID;
+                        cnt1 = CORE_FLOAT;
+                    }
+                    break;
+                case CORE_S2:
+                    next = (c == '+' || c == '-') ? CORE_EXPONENT
+                                                  : CORE_INVALID;
+                    cnt1 = CORE_S2;
+                    break;
+                case CORE_EXPONENT:
+                    next = digit ? CORE_SCIENTIFIC : CORE_INVALID;
+                    cnt1 = CORE_EXPONENT;
+                    break;
+                case CORE_SCIENTIFIC:
+                    if (!digit)
+                    {
+                        next = CORE_INVALID;
+                        cnt1 = CORE_INVALID;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            state_table[s][c] = (ee_u16)(next | (cnt1 << 4) | (cnt2 << 8));
+        }
+    }
+}
+
+/* Function: state_transition_table
+        <core_state_transition> driven by a transition table instead of a
+   switch.
+*/
+static enum CORE_STATE
+state_transition_table(ee_u8 **instr, ee_u32 *transition_count)
+{
+    ee_u8 *str   = *instr;
+    ee_u32 state = CORE_START;
+    for (; *str && state != CORE_INVALID; str++)
+    {
+        ee_u16 t;
+        if (*str == ',')
+        {
+            str++;
+            break;
+        }
+        t = state_table[state][*str];
+        if (((t >> 4) & 0xf) != STATE_NO_COUNT)
+            transition_count[(t >> 4) & 0xf]++;
+        if ((t >> 8) != STATE_NO_COUNT)
+            transition_count[t >> 8]++;
+        state = t & 0xf;
+    }
+    *instr = str;
+    return (enum CORE_STATE)state;
+}
+
+static ee_u16 crc_table[256];
+
+/* Function: crc_table_init
+        Table for <crcu16_table>. <crcu8> is the reflected CRC-16 with
+   polynomial 0xa001.
+*/
+static void
+crc_table_init(void)
+{
+    ee_u32 i;
+    for (i = 0; i < 256; i++)
+        crc_table[i] = crcu8((ee_u8)i, 0);
+}
+
+/* Function: crcu16_table
+        <crcu16>, a byte at a time.
+*/
+static ee_u16
+crcu16_table(ee_u16 newval, ee_u16 crc)
+{
+    crc = (crc >> 8) ^ crc_table[(crc ^ newval) & 0xff];
+    crc = (crc >> 8) ^ crc_table[(crc ^ (newval >> 8)) & 0xff];
+    return crc;
+}
+
+/* Variable: core_variants
+        All implementations of each kernel, the reference one first.
+*/
+static core_variant core_variants[] = {
+    { KERNEL_ID_LIST_FIND,
+      "ref",
+      NULL,
+      NULL,
+      NULL,
+      { .list_find = core_list_find } },
+    { KERNEL_ID_LIST_FIND,
+      "unrolled",
+      NULL,
+      NULL,
+      NULL,
+      { .list_find = list_find_unrolled } },
+    { KERNEL_ID_LIST_MERGESORT,
+      "ref",
+      NULL,
+      NULL,
+      NULL,
+      { .list_mergesort = core_list_mergesort } },
+    { KERNEL_ID_LIST_MERGESORT,
+      "tailptr",
+      NULL,
+      NULL,
+      NULL,
+      { .list_mergesort = list_mergesort_tailptr } },
+    { KERNEL_ID_MATRIX_MUL_MATRIX,
+      "ref",
+      NULL,
+      NULL,
+      NULL,
+      { .matrix_mul_matrix = matrix_mul_matrix } },
+    { KERNEL_ID_MATRIX_MUL_MATRIX,
+      "ikj",
+      NULL,
+      NULL,
+      NULL,
+      { .matrix_mul_matrix = matrix_mul_matrix_ikj } },
+#if KERNELS_HAS_X86
+    { KERNEL_ID_MATRIX_MUL_MATRIX,
+      "ikj-avx2",
+      "avx2",
+      has_avx2,
+      NULL,
+      { .matrix_mul_matrix = matrix_mul_matrix_ikj_avx2 } },
+#endif
+    { KERNEL_ID_STATE_TRANSITION,
+      "ref",
+      NULL,
+      NULL,
+      NULL,
+      { .state_transition = core_state_transition } },
+    { KERNEL_ID_STATE_TRANSITION,
+      "table",
+      NULL,
+      NULL,
+      state_table_init,
+      { .state_transition = state_transition_table } },
+    { KERNEL_ID_CRCU16,
+      "ref",
+      NULL,
+      NULL,
+      NULL,
+      { .crcu16 = crcu16 } },
+    { KERNEL_ID_CRCU16,
+      "table",
+      NULL,
+      NULL,
+      crc_table_init,
+      { .crcu16 = crcu16_table } },
+};
+#define NUM_VARIANTS (sizeof(core_variants) / sizeof(core_variants[0]))
+
+/* variant in use for each kernel */
+static core_variant *kernel_selected[NUM_KERNELS];
+
+/* Function: variant_supported
+        Check that the cpu supports the extension required by a variant.
+*/
+static ee_u8
+variant_supported(core_variant *v)
+{
+    return (v->supported == NULL) || v->supported();
+}
+
+/* Function: variant_install
+        Set a variant in <core_kernel>.
+*/
+static void
+variant_install(core_variant *v)
+{
+    if (v->init)
+        v->init();
+    switch (v->kernel)
+    {
+        case KERNEL_ID_LIST_FIND:
+            core_kernel.list_find = v->fn.list_find;
+            break;
+        case KERNEL_ID_LIST_MERGESORT:
+            core_kernel.list_mergesort = v->fn.list_mergesort;
+            break;
+        case KERNEL_ID_MATRIX_MUL_MATRIX:
+            core_kernel.matrix_mul_matrix = v->fn.matrix_mul_matrix;
+            break;
+        case KERNEL_ID_STATE_TRANSITION:
+            core_kernel.state_transition = v->fn.state_transition;
+            break;
+        case KERNEL_ID_CRCU16:
+            core_kernel.crcu16 = v->fn.crcu16;
+            break;
+        default:
+            break;
+    }
+    kernel_selected[v->kernel] = v;
+}
+
+/* Function: variant_reference
+        Reference implementation of a kernel.
+*/
+static core_variant *
+variant_reference(ee_u32 kernel)
+{
+    ee_u32 i;
+    for (i = 0; i < NUM_VARIANTS; i++)
+    {
+        if (core_variants[i].kernel == kernel)
+            return &core_variants[i];
+    }
+    return NULL;
+}
+
+/* Function: core_kernels_select
+        Select kernel variants from a list of <kernel>:<variant>, separated by
+   ','.
+
+        Returns:
+        0 on success, 1 if a kernel or variant is unknown, or not supported
+   by this cpu.
+*/
+ee_s16
+core_kernels_select(const char *spec)
+{
+    while (*spec)
+    {
+        const char *sep = spec, *end;
+        ee_u32      k, i, klen, vlen;
+        while (*sep && *sep != ':' && *sep != ',')
+            sep++;
+        end = sep;
+        while (*end && *end != ',')
+            end++;
+        if (*sep != ':')
+        {
+            ee_printf("ERROR! Expected <kernel>:<variant>, found %.*s\n",
+                      (int)(end - spec),
+                      spec);
+            return 1;
+        }
+        klen = (ee_u32)(sep - spec);
+        vlen = (ee_u32)(end - sep - 1);
+        for (k = 0; k < NUM_KERNELS; k++)
+        {
+            if (strlen(kernel_names[k]) == klen
+                && strncmp(kernel_names[k], spec, klen) == 0)
+                break;
+        }
+        for (i = 0; i < NUM_VARIANTS; i++)
+        {
+            if (core_variants[i].kernel == k
+                && strlen(core_variants[i].name) == vlen
+                && strncmp(core_variants[i].name, sep + 1, vlen) == 0)
+                break;
+        }
+        if (k == NUM_KERNELS || i == NUM_VARIANTS)
+        {
+            ee_printf(
+                "ERROR! Unknown kernel variant %.*s, see --list-kernels\n",
+                (int)(end - spec),
+                spec);
+            return 1;
+        }
+        if (!variant_supported(&core_variants[i]))
+        {
+            ee_printf("ERROR! Kernel variant %.*s requires %s\n",
+                      (int)(end - spec),
+                      spec,
+                      core_variants[i].isa);
+            return 1;
+        }
+        variant_install(&core_variants[i]);
+        spec = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
+/* Function: core_kernels_list
+        Print all kernel variants, and whether they can run on this cpu.
+*/
+void
+core_kernels_list(void)
+{
+    ee_u32 i;
+    ee_printf("kernel             variant    requires  status\n");
+    for (i = 0; i < NUM_VARIANTS; i++)
+    {
+        core_variant *v = &core_variants[i];
+        core_variant *s = kernel_selected[v->kernel];
+        if (s == NULL)
+            s = variant_reference(v->kernel);
+        ee_printf("%-18s %-10s %-9s %s%s\n",
+                  kernel_names[v->kernel],
+                  v->name,
+                  v->isa ? v->isa : "-",
+                  variant_supported(v) ? "available" : "unsupported",
+                  v == s ? ", selected" : "");
+    }
+}
+
+/* Function: core_kernels_print
+        Print the selected variants, if any is not the reference one.
+*/
+void
+core_kernels_print(void)
+{
+    ee_u32 k, n = 0;
+    for (k = 0; k < NUM_KERNELS; k++)
+    {
+        core_variant *v = kernel_selected[k];
+        if (v == NULL || v == variant_reference(k))
+            continue;
+        ee_printf("%s%s:%s",
+                  n++ ? "," : "Kernel variants  : ",
+                  kernel_names[k],
+                  v->name);
+    }
+    if (n)
+        ee_printf("\n");
+}
+
+/* Function: verify_run
+        Run a few iterations on freshly initialized data with the current
+   kernels.
+*/
+static void
+verify_run(core_results *res, ee_u32 size, ee_u16 *crcs)
+{
+    res->size       = size;
+    res->iterations = 2;
+    res->execs      = ALL_ALGORITHMS_MASK;
+    res->err        = 0;
+    core_init_data(res, 1);
+    iterate(res);
+    crcs[0] = res->crclist;
+    crcs[1] = res->crcmatrix;
+    crcs[2] = res->crcstate;
+    crcs[3] = res->crc;
+}
+
+/* Function: core_kernels_verify
+        Differential validation of all variants supported by this cpu, and of
+   the selected combination, against the reference kernels.
+
+        Each check runs two iterations of the whole benchmark on randomized
+   seeds and sizes, so that variants are exercised with the data and call
+   sequence of a real run. The selected variants are restored on return.
+
+        Returns:
+        Number of failed checks, or -1 if memory could not be allocated.
+*/
+ee_s16
+core_kernels_verify(ee_u32 trials)
+{
+    /* sizes from 1K to 16K, enough for all algorithms */
+    const ee_u32  max_size = 16 * 1024;
+    core_results  res;
+    core_kernels  selected = core_kernel;
+    core_variant *selected_v[NUM_KERNELS];
+    ee_u32        i, k, t, rnd = 0x2545f491, checked = 0;
+    ee_s16        failed = 0;
+
+    memset(&res, 0, sizeof(res));
+    res.memblock[0] = portable_malloc(max_size);
+    if (res.memblock[0] == NULL)
+        return -1;
+    for (k = 0; k < NUM_KERNELS; k++)
+        selected_v[k] = kernel_selected[k];
+    if (trials == 0)
+        trials = 8;
+
+    /* i == NUM_VARIANTS checks the selected combination */
+    for (i = 0; i <= NUM_VARIANTS; i++)
+    {
+        core_variant *v = i < NUM_VARIANTS ? &core_variants[i] : NULL;
+        if (v && (v == variant_reference(v->kernel) || !variant_supported(v)))
+            continue;
+        for (t = 0; t < trials; t++)
+        {
+            ee_u16 ref[4], got[4];
+            ee_u32 size;
+            /* xorshift, same sequence on every run */
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 17;
+            rnd ^= rnd << 5;
+            size      = 1024 + rnd % (max_size - 1024 + 1);
+            res.seed1 = (ee_s16)rnd;
+            res.seed2 = (ee_s16)(rnd >> 16);
+            res.seed3 = (ee_s16)(8 + (rnd >> 8) % 0x100);
+
+            for (k = 0; k < NUM_KERNELS; k++)
+                variant_install(variant_reference(k));
+            verify_run(&res, size, ref);
+            if (v)
+                variant_install(v);
+            else
+            {
+                core_kernel = selected;
+                for (k = 0; k < NUM_KERNELS; k++)
+                    kernel_selected[k] = selected_v[k];
+            }
+            verify_run(&res, size, got);
+            checked++;
+            if (memcmp(ref, got, sizeof(ref)) != 0)
+            {
+                ee_printf("ERROR! Kernel %s:%s differs from the reference "
+                          "with seeds 0x%x 0x%x 0x%x size %u: crcs "
+                          "0x%04x 0x%04x 0x%04x 0x%04x, expected 0x%04x "
+                          "0x%04x 0x%04x 0x%04x\n",
+                          v ? kernel_names[v->kernel] : "selected",
+                          v ? v->name : "combination",
+                          (ee_u16)res.seed1,
+                          (ee_u16)res.seed2,
+                          (ee_u16)res.seed3,
+                          size,
+                          got[0],
+                          got[1],
+                          got[2],
+                          got[3],
+                          ref[0],
+                          ref[1],
+                          ref[2],
+                          ref[3]);
+                failed++;
+                break;
+            }
+        }
+    }
+    core_kernel = selected;
+    for (k = 0; k < NUM_KERNELS; k++)
+        kernel_selected[k] = selected_v[k];
+    portable_free(res.memblock[0]);
+    ee_printf("Kernel verify    : %u checks, %d failed\n", checked, failed);
+    return failed;
+}
+#endif /* KERNEL_REGISTRY */
@@ -50,7 +50,6 @@ input for the operation.
 
 /* local functions */
 
-list_head *core_list_find(list_head *list, list_data *info);
 list_head *core_list_reverse(list_head *list);
 list_head *core_list_remove(list_head *item);
 list_head *core_list_undo_remove(list_head *item_removed,
@@ -61,10 +60,6 @@ list_head *core_list_insert_new(list_head * insert_point,
                                 list_data **datablock,
                                 list_head * memblock_end,
                                 list_data * datablock_end);
-typedef ee_s32 (*list_cmp)(list_data *a, list_data *b, core_results *res);
-list_head *core_list_mergesort(list_head *   list,
-                               list_cmp      cmp,
-                               core_results *res);
 
 ee_s16
 calc_func(ee_s16 *pdata, core_results *res)
@@ -106,7 +101,7 @@ calc_func(ee_s16 *pdata, core_results *res)
                 retval = data;
                 break;
         }
-        res->crc = crcu16(retval, res->crc);
+        res->crc = KERNEL_CRCU16(retval, res->crc);
         retval &= 0x007f;
         *pdata = (data & 0xff00) | 0x0080 | retval; /* cache the result */
         return retval;
@@ -173,7 +168,7 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
     for (i = 0; i < find_num; i++)
     {
         info.data16 = (i & 0xff);
-        this_find   = core_list_find(list, &info);
+        this_find   = KERNEL_LIST_FIND(list, &info);
         list        = core_list_reverse(list);
         if (this_find == NULL)
         {
@@ -203,15 +198,16 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
     retval += found * 4 - missed;
     /* sort the list by data content and remove one item*/
     if (finder_idx > 0)
-        list = core_list_mergesort(list, cmp_complex, res);
+        list = KERNEL_LIST_MERGESORT(list, cmp_complex, res);
     remover = core_list_remove(list->next);
     /* CRC data content of list from location of index N forward, and then undo
      * remove */
-    finder = core_list_find(list, &info);
+    finder = KERNEL_LIST_FIND(list, &info);
     if (!finder)
         finder = list->next;
     while (finder)
     {
+        TRACE_LIST(finder);
         retval = crc16(list->info->data16, retval);
         finder = finder->next;
     }
@@ -220,11 +216,12 @@ core_bench_list(core_results *res, ee_s16 finder_idx)
 #endif
     remover = core_list_undo_remove(remover, list->next);
     /* sort the list by index, in effect returning the list to original state */
-    list = core_list_mergesort(list, cmp_idx, NULL);
+    list = KERNEL_LIST_MERGESORT(list, cmp_idx, NULL);
     /* CRC data content of list */
     finder = list->next;
     while (finder)
     {
+        TRACE_LIST(finder);
         retval = crc16(list->info->data16, retval);
         finder = finder->next;
     }
@@ -303,7 +300,7 @@ core_list_init(ee_u32 blksize, list_head *memblock, ee_s16 seed)
         }
         finder = finder->next;
     }
-    list = core_list_mergesort(list, cmp_idx, NULL);
+    list = KERNEL_LIST_MERGESORT(list, cmp_idx, NULL);
 #if CORE_DEBUG
     ee_printf("Initialized list:\n");
     finder = list;
@@ -431,18 +428,25 @@ core_list_undo_remove(list_head *item_removed, list_head *item_modified)
         Returns:
         Found item, or NULL if not found.
 */
+CORE_CLONES
 list_head *
 core_list_find(list_head *list, list_data *info)
 {
     if (info->idx >= 0)
     {
-        while (list && (list->info->idx != info->idx))
+        while (list
+               && (TRACE_LIST(list),
+                   TRACE_LIST(list->info),
+                   list->info->idx != info->idx))
             list = list->next;
         return list;
     }
     else
     {
-        while (list && ((list->info->data16 & 0xff) != info->data16))
+        while (list
+               && (TRACE_LIST(list),
+                   TRACE_LIST(list->info),
+                   (list->info->data16 & 0xff) != info->data16))
             list = list->next;
         return list;
     }
@@ -461,12 +465,14 @@ core_list_find(list_head *list, list_data *info)
         Found item, or NULL if not found.
 */
 
+CORE_CLONES
 list_head *
 core_list_reverse(list_head *list)
 {
     list_head *next = NULL, *tmp;
     while (list)
     {
+        TRACE_LIST(list);
         tmp        = list->next;
         list->next = next;
         next       = list;
@@ -496,6 +502,7 @@ core_list_reverse(list_head *list)
         but the algorithm could theoretically modify where the list starts.
 
  */
+CORE_CLONES
 list_head *
 core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
 {
@@ -521,6 +528,7 @@ core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
             for (i = 0; i < insize; i++)
             {
                 psize++;
+                TRACE_LIST(q);
                 q = q->next;
                 if (!q)
                     break;
@@ -548,7 +556,10 @@ core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
                     p = p->next;
                     psize--;
                 }
-                else if (cmp(p->info, q->info, res) <= 0)
+                else if ((TRACE_LIST(p->info),
+                          TRACE_LIST(q->info),
+                          cmp(p->info, q->info, res))
+                         <= 0)
                 {
                     /* First element of p is lower (or same); e must come from
                      * p. */
@@ -565,6 +576,7 @@ core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
                 }
 
                 /* add the next element to the merged list */
+                TRACE_LIST(e);
                 if (tail)
                 {
                     tail->next = e;
@@ -22,56 +22,6 @@ Original Author: Shay Gal-on
 */
 #include "coremark.h"
 
-/* Function: iterate
-        Run the benchmark for a specified number of iterations.
-
-        Operation:
-        For each type of benchmarked algorithm:
-                a - Initialize the data block for the algorithm.
-                b - Execute the algorithm N times.
-
-        Returns:
-        NULL.
-*/
-static ee_u16 list_known_crc[]   = { (ee_u16)0xd4b0,
-                                   (ee_u16)0x3340,
-                                   (ee_u16)0x6a79,
-                                   (ee_u16)0xe714,
-                                   (ee_u16)0xe3c1 };
-static ee_u16 matrix_known_crc[] = { (ee_u16)0xbe52,
-                                     (ee_u16)0x1199,
-                                     (ee_u16)0x5608,
-                                     (ee_u16)0x1fd7,
-                                     (ee_u16)0x0747 };
-static ee_u16 state_known_crc[]  = { (ee_u16)0x5e47,
-                                    (ee_u16)0x39bf,
-                                    (ee_u16)0xe5a4,
-                                    (ee_u16)0x8e3a,
-                                    (ee_u16)0x8d84 };
-void *
-iterate(void *pres)
-{
-    ee_u32        i;
-    ee_u16        crc;
-    core_results *res        = (core_results *)pres;
-    ee_u32        iterations = res->iterations;
-    res->crc                 = 0;
-    res->crclist             = 0;
-    res->crcmatrix           = 0;
-    res->crcstate            = 0;
-
-    for (i = 0; i < iterations; i++)
-    {
-        crc      = core_bench_list(res, 1);
-        res->crc = crcu16(crc, res->crc);
-        crc      = core_bench_list(res, -1);
-        res->crc = crcu16(crc, res->crc);
-        if (i == 0)
-            res->crclist = res->crc;
-    }
-    return NULL;
-}
-
 #if (SEED_METHOD == SEED_ARG)
 ee_s32 get_seed_args(int i, int argc, char *argv[]);
 #define get_seed(x)    (ee_s16) get_seed_args(x, argc, argv)
@@ -85,6 +35,27 @@ ee_s32 get_seed_32(int i);
 ee_u8 static_memblk[TOTAL_DATA_SIZE];
 #endif
 char *mem_name[3] = { "Static", "Heap", "Stack" };
+
+/* Macro: MODE_SIZE
+        Total data size of a mode run: the 7th argument, <TOTAL_DATA_SIZE> if
+   it is 0.
+*/
+#define MODE_SIZE() \
+    (get_seed_32(7) ? (ee_u32)get_seed_32(7) : TOTAL_DATA_SIZE)
+
+/* Macro: MODE_RETURN
+        End <main> after a mode that replaces the benchmark run: release the
+   port, and fail if the mode returned an error.
+*/
+#define MODE_RETURN(err)                   \
+    do                                     \
+    {                                      \
+        ee_s16 mode_err = (err);           \
+        portable_fini(&(results[0].port)); \
+        if (mode_err)                      \
+            return MAIN_FAIL_VAL;          \
+        return MAIN_RETURN_VAL;            \
+    } while (0)
 /* Function: main
         Main entry routine for the benchmark.
         This function is responsible for the following steps:
@@ -115,22 +86,260 @@ MAIN_RETURN_TYPE
 main(int argc, char *argv[])
 {
 #endif
-    ee_u16       i, j = 0, num_algorithms = 0;
+    ee_u16       i;
     ee_s16       known_id = -1, total_errors = 0;
     ee_u16       seedcrc = 0;
     CORE_TICKS   total_time;
     core_results results[MULTITHREAD];
+    ee_u32       blksize;
+#if SNAPSHOT_RUN
+    char *snapshot_file;
+    ee_u8 restored = 0;
+#endif
+#if PIPELINE_RUN
+    char *pipeline_records, *pipeline_cpus;
+#endif
+#if CLUSTER_RUN
+    char *cluster_workers, *cluster_socket, *cluster_jobs, *cluster_outlier;
+    ee_u8 cluster_attach;
+#endif
+#if PLUGIN_RUN
+    char *plugin_names, *plugin_ms;
+    ee_u8 plugin_only;
+#endif
+#if ALIGN_SWEEP
+    char *align_repeats;
+#endif
+#if AB_RUN
+    char *ab_a, *ab_b, *ab_pairs, *ab_ms, *ab_cpu;
+#endif
+#if COMPARE_RUN
+    char *compare_samples, *compare_ms, *compare_json, *compare_base,
+        *compare_threshold;
+#endif
+#if COUNT_RUN
+    char *count_budget, *count_save, *count_tolerance;
+#endif
+#if TRACE_RUN
+    char *trace_file;
+#endif
+#if HYBRID_RUN
+    char *hybrid_ms;
+#endif
+#if CPUMAP_RUN
+    char *cpumap_list, *cpumap_group, *cpumap_ms, *cpumap_repeats,
+        *cpumap_csv;
+#endif
+#if DAEMON_RUN
+    char *daemon_addr, *daemon_file, *daemon_interval, *daemon_probe_ms,
+        *daemon_budget, *daemon_cgroup;
+#endif
+#if MIX_RUN
+    char *mix_weights, *mix_sizes, *mix_ms;
+#endif
+#if REFERENCE_RUN
+    char *reference_only, *reference_cache;
+#endif
+#if PREFLIGHT_RUN
+    char *preflight;
+#endif
+#if STARTUP_RUN
+    char *   startup_execs;
+    secs_ret startup_main, startup_init;
+#endif
 #if (MEM_METHOD == MEM_STACK)
     ee_u8 stack_memblock[TOTAL_DATA_SIZE * MULTITHREAD];
+#endif
+#if STARTUP_RUN
+    startup_main = portable_time();
 #endif
     /* first call any initializations needed */
     portable_init(&(results[0].port), &argc, argv);
+#if STARTUP_RUN
+    startup_init = portable_time();
+#endif
     /* First some checks to make sure benchmark will run ok */
     if (sizeof(struct list_head_s) > 128)
     {
         ee_printf("list_head structure too big for comparable data!\n");
         return MAIN_RETURN_VAL;
     }
+#if (MULTITHREAD > 1)
+    if (default_num_contexts > MULTITHREAD)
+    {
+        default_num_contexts = MULTITHREAD;
+    }
+#endif
+#if KERNEL_REGISTRY
+    {
+        char *kernels = get_option_arg("kernel", &argc, argv);
+        char *list    = get_option_arg("list-kernels", &argc, argv);
+        char *verify  = get_option_arg("verify-all", &argc, argv);
+        if (kernels != NULL && core_kernels_select(kernels) != 0)
+            total_errors++;
+        if (list != NULL)
+        {
+            core_kernels_list();
+            portable_fini(&(results[0].port));
+            return MAIN_RETURN_VAL;
+        }
+        /* check the variants before anything is timed */
+        if (total_errors == 0 && verify != NULL
+            && core_kernels_verify(*verify ? (ee_u32)parseval(verify) : 0))
+            total_errors++;
+        if (total_errors)
+        {
+            ee_printf("Errors detected\n");
+            portable_fini(&(results[0].port));
+            return MAIN_FAIL_VAL;
+        }
+    }
+#endif
+#if REFERENCE_RUN
+    reference_only = get_option_arg("reference", &argc, argv);
+    /* the cache is only written when asked for */
+    reference_cache = get_option_arg("reference-cache", &argc, argv);
+    if (reference_cache != NULL && *reference_cache == 0)
+        reference_cache = "coremark.ref";
+#endif
+#if BATCH_RUN
+    {
+        char *batch_file = get_option_arg("batch", &argc, argv);
+        if (batch_file != NULL)
+        {
+#if REFERENCE_RUN
+            const char *cache = reference_cache;
+#else
+            const char *cache = NULL;
+#endif
+            /* run all configurations listed in the file, and quit */
+            total_errors = core_batch_run(
+                batch_file, results, default_num_contexts, cache);
+            total_errors += check_data_types();
+            if (total_errors > 0)
+                ee_printf("Errors detected\n");
+            portable_fini(&(results[0].port));
+            if (total_errors)
+                return MAIN_FAIL_VAL;
+            return MAIN_RETURN_VAL;
+        }
+    }
+#endif
+#if SNAPSHOT_RUN
+    snapshot_file = get_option_arg("snapshot", &argc, argv);
+#endif
+#if STREAM_RUN
+    {
+        char *stream_file = get_option_arg("stream", &argc, argv);
+        if (stream_file != NULL)
+        {
+            char * chunk = get_option_arg("chunk", &argc, argv);
+            ee_s16 err   = core_stream_run(stream_file,
+                                         chunk ? (ee_u32)parseval(chunk) : 0);
+            if (err)
+                ee_printf("Errors detected\n");
+            portable_fini(&(results[0].port));
+            if (err)
+                return MAIN_FAIL_VAL;
+            return MAIN_RETURN_VAL;
+        }
+    }
+#endif
+#if CLUSTER_RUN
+    {
+        char *worker = get_option_arg("cluster-worker", &argc, argv);
+        if (worker != NULL)
+        {
+            /* run the jobs sent by a coordinator, and quit */
+            ee_s16 err = core_cluster_worker(worker);
+            if (err)
+                ee_printf("Errors detected\n");
+            portable_fini(&(results[0].port));
+            if (err)
+                return MAIN_FAIL_VAL;
+            return MAIN_RETURN_VAL;
+        }
+    }
+#endif
+    /* remove the remaining options before the seeds are parsed */
+#if PIPELINE_RUN
+    pipeline_records = get_option_arg("pipeline", &argc, argv);
+    pipeline_cpus    = get_option_arg("pipeline-cpus", &argc, argv);
+#endif
+#if CLUSTER_RUN
+    cluster_workers = get_option_arg("cluster", &argc, argv);
+    cluster_socket  = get_option_arg("cluster-socket", &argc, argv);
+    cluster_attach  = get_option_arg("cluster-attach", &argc, argv) != NULL;
+    cluster_jobs    = get_option_arg("cluster-jobs", &argc, argv);
+    cluster_outlier = get_option_arg("cluster-outlier", &argc, argv);
+#endif
+#if PLUGIN_RUN
+    if (get_option_arg("list-plugins", &argc, argv) != NULL)
+    {
+        core_plugins_list();
+        portable_fini(&(results[0].port));
+        return MAIN_RETURN_VAL;
+    }
+    plugin_names = get_option_arg("plugin", &argc, argv);
+    plugin_ms    = get_option_arg("plugin-ms", &argc, argv);
+    plugin_only  = get_option_arg("plugin-only", &argc, argv) != NULL;
+#endif
+#if ALIGN_SWEEP
+    align_repeats = get_option_arg("align-sweep", &argc, argv);
+#endif
+#if AB_RUN
+    ab_a     = get_option_arg("ab-a", &argc, argv);
+    ab_b     = get_option_arg("ab-b", &argc, argv);
+    ab_pairs = get_option_arg("ab-pairs", &argc, argv);
+    ab_ms    = get_option_arg("ab-ms", &argc, argv);
+    ab_cpu   = get_option_arg("ab-cpu", &argc, argv);
+#endif
+#if COMPARE_RUN
+    compare_samples   = get_option_arg("samples", &argc, argv);
+    compare_ms        = get_option_arg("sample-ms", &argc, argv);
+    compare_json      = get_option_arg("json", &argc, argv);
+    compare_base      = get_option_arg("compare", &argc, argv);
+    compare_threshold = get_option_arg("compare-threshold", &argc, argv);
+#endif
+#if COUNT_RUN
+    count_budget    = get_option_arg("count", &argc, argv);
+    count_save      = get_option_arg("count-save", &argc, argv);
+    count_tolerance = get_option_arg("count-tolerance", &argc, argv);
+#endif
+#if HYBRID_RUN
+    hybrid_ms = get_option_arg("hybrid", &argc, argv);
+#endif
+#if CPUMAP_RUN
+    cpumap_list    = get_option_arg("cpu-map", &argc, argv);
+    cpumap_group   = get_option_arg("cpu-map-group", &argc, argv);
+    cpumap_ms      = get_option_arg("cpu-map-ms", &argc, argv);
+    cpumap_repeats = get_option_arg("cpu-map-repeats", &argc, argv);
+    cpumap_csv     = get_option_arg("cpu-map-csv", &argc, argv);
+#endif
+#if DAEMON_RUN
+    daemon_addr     = get_option_arg("daemon", &argc, argv);
+    daemon_file     = get_option_arg("daemon-file", &argc, argv);
+    daemon_interval = get_option_arg("daemon-interval", &argc, argv);
+    daemon_probe_ms = get_option_arg("daemon-probe-ms", &argc, argv);
+    daemon_budget   = get_option_arg("daemon-budget", &argc, argv);
+    daemon_cgroup   = get_option_arg("daemon-cgroup", &argc, argv);
+#endif
+#if STARTUP_RUN
+    startup_execs = get_option_arg("startup", &argc, argv);
+#endif
+#if MIX_RUN
+    mix_weights = get_option_arg("mix", &argc, argv);
+    mix_sizes   = get_option_arg("mix-sizes", &argc, argv);
+    mix_ms      = get_option_arg("mix-ms", &argc, argv);
+#endif
+#if PREFLIGHT_RUN
+    preflight = get_option_arg("preflight", &argc, argv);
+#endif
+#if TRACE_RUN
+    trace_file = get_option_arg("trace", &argc, argv);
+    if (trace_file != NULL && *trace_file == 0)
+        trace_file = "coremark.trace";
+#endif
     results[0].seed1      = get_seed(1);
     results[0].seed2      = get_seed(2);
     results[0].seed3      = get_seed(3);
@@ -158,6 +367,185 @@ main(int argc, char *argv[])
         results[0].seed2 = 0x3415;
         results[0].seed3 = 0x66;
     }
+#if PIPELINE_RUN
+    if (pipeline_records != NULL)
+    {
+        ee_s16 err;
+        /* same size per algorithm as a regular run */
+        results[0].size = MODE_SIZE() / NUM_ALGORITHMS;
+        err             = core_pipeline_run(
+            &results[0],
+            *pipeline_records ? (ee_u32)parseval(pipeline_records) : 0,
+            pipeline_cpus);
+        if (err)
+            ee_printf("Errors detected\n");
+        MODE_RETURN(err);
+    }
+#endif
+#if ALIGN_SWEEP
+    if (align_repeats != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_align_sweep(
+            &results[0], *align_repeats ? (ee_u32)parseval(align_repeats) : 0));
+    }
+#endif
+#if AB_RUN
+    if (ab_a != NULL || ab_b != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_ab_run(&results[0],
+                                ab_a,
+                                ab_b,
+                                ab_pairs ? (ee_u32)parseval(ab_pairs) : 0,
+                                ab_ms ? (ee_u32)parseval(ab_ms) : 0,
+                                ab_cpu ? (ee_u32)parseval(ab_cpu) : 0));
+    }
+#endif
+#if COMPARE_RUN
+    if (compare_samples != NULL || compare_json != NULL
+        || compare_base != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        /* a regression fails the run, for use in scripts */
+        MODE_RETURN(core_compare_run(
+            &results[0],
+            (compare_json && *compare_json) ? compare_json : NULL,
+            (compare_base && *compare_base) ? compare_base : NULL,
+            (compare_samples && *compare_samples)
+                ? (ee_u32)parseval(compare_samples)
+                : 0,
+            compare_ms ? (ee_u32)parseval(compare_ms) : 0,
+            compare_threshold,
+#if PLUGIN_RUN
+            plugin_names));
+#else
+            NULL));
+#endif
+    }
+#endif
+#if COUNT_RUN
+    if (count_budget != NULL || count_save != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_count_run(
+            &results[0],
+            (count_budget && *count_budget) ? count_budget : NULL,
+            (count_save && *count_save) ? count_save : NULL,
+            count_tolerance));
+    }
+#endif
+#if HYBRID_RUN
+    if (hybrid_ms != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_hybrid_run(
+            &results[0], *hybrid_ms ? (ee_u32)parseval(hybrid_ms) : 0));
+    }
+#endif
+#if CPUMAP_RUN
+    if (cpumap_list != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        /* a slow or failing cpu fails the run, for use in scripts */
+        MODE_RETURN(core_cpumap_run(
+            &results[0],
+            cpumap_list,
+            cpumap_group ? (ee_u32)parseval(cpumap_group) : 0,
+            cpumap_ms ? (ee_u32)parseval(cpumap_ms) : 0,
+            cpumap_repeats ? (ee_u32)parseval(cpumap_repeats) : 0,
+            (cpumap_csv && *cpumap_csv) ? cpumap_csv : NULL));
+    }
+#endif
+#if DAEMON_RUN
+    if (daemon_addr != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_daemon_run(
+            &results[0],
+            daemon_addr,
+            (daemon_file && *daemon_file) ? daemon_file : NULL,
+            daemon_interval ? (ee_u32)parseval(daemon_interval) : 0,
+            daemon_probe_ms ? (ee_u32)parseval(daemon_probe_ms) : 0,
+            daemon_budget ? (ee_u32)parseval(daemon_budget) : 0,
+            daemon_cgroup));
+    }
+#endif
+#if STARTUP_RUN
+    if (startup_execs != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_startup_run(
+            &results[0],
+            startup_main,
+            startup_init,
+            *startup_execs ? (ee_u32)parseval(startup_execs) : 0,
+#if SNAPSHOT_RUN
+            snapshot_file,
+#else
+            NULL,
+#endif
+            argc,
+            argv));
+    }
+#endif
+#if MIX_RUN
+    if (mix_weights != NULL || mix_sizes != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_mix_run(&results[0],
+                                 mix_weights,
+                                 mix_sizes,
+                                 mix_ms ? (ee_u32)parseval(mix_ms) : 0));
+    }
+#endif
+#if PLUGIN_RUN
+    if (plugin_names != NULL && plugin_only)
+    {
+        ee_u32 num_algorithms = 0;
+        /* same size per algorithm as a regular run */
+        for (i = 0; i < NUM_ALGORITHMS; i++)
+        {
+            if (results[0].execs & (1 << i))
+                num_algorithms++;
+        }
+        if (num_algorithms == 0)
+        {
+            ee_printf("ERROR! No algorithm selected in 0x%x\n",
+                      results[0].execs);
+            MODE_RETURN(1);
+        }
+        results[0].size = MODE_SIZE() / num_algorithms;
+        MODE_RETURN(
+            core_plugins_run(plugin_names,
+                             &results[0],
+                             plugin_ms ? (ee_u32)parseval(plugin_ms) : 0));
+    }
+#endif
+#if REFERENCE_RUN
+    if (reference_only != NULL)
+    {
+        results[0].size = MODE_SIZE();
+        MODE_RETURN(core_reference_run(&results[0], reference_cache));
+    }
+#endif
+#if CLUSTER_RUN
+    if (cluster_workers != NULL)
+    {
+        ee_s16 err;
+        results[0].size = MODE_SIZE();
+        err             = core_cluster_run(
+            &results[0],
+            *cluster_workers ? (ee_u32)parseval(cluster_workers) : 0,
+            cluster_socket,
+            cluster_attach,
+            cluster_jobs,
+            cluster_outlier ? (ee_u32)parseval(cluster_outlier) : 0);
+        if (err)
+            ee_printf("Errors detected\n");
+        MODE_RETURN(err);
+    }
+#endif
 #if (MEM_METHOD == MEM_STATIC)
     results[0].memblock[0] = (void *)static_memblk;
     results[0].size        = TOTAL_DATA_SIZE;
@@ -168,7 +556,7 @@ main(int argc, char *argv[])
 #elif (MEM_METHOD == MEM_MALLOC)
     for (i = 0; i < MULTITHREAD; i++)
     {
-        ee_s32 malloc_override = get_seed(7);
+        ee_s32 malloc_override = get_seed_32(7);
         if (malloc_override != 0)
             results[i].size = malloc_override;
         else
@@ -195,123 +583,77 @@ for (i = 0; i < MULTITHREAD; i++)
 #error "Please define a way to initialize a memory block."
 #endif
     /* Data init */
-    /* Find out how space much we have based on number of algorithms */
-    for (i = 0; i < NUM_ALGORITHMS; i++)
+    blksize = results[0].size;
+#if SNAPSHOT_RUN
+    if (snapshot_file != NULL)
+        restored = core_snapshot_load(snapshot_file, results, MULTITHREAD);
+    if (!restored)
     {
-        if ((1 << (ee_u32)i) & results[0].execs)
-            num_algorithms++;
+        core_init_data(results, MULTITHREAD);
+        if (snapshot_file != NULL)
+            core_snapshot_save(snapshot_file, results, blksize);
     }
-    for (i = 0; i < MULTITHREAD; i++)
-        results[i].size = results[i].size / num_algorithms;
-    /* Assign pointers */
-    for (i = 0; i < NUM_ALGORITHMS; i++)
-    {
-        ee_u32 ctx;
-        if ((1 << (ee_u32)i) & results[0].execs)
-        {
-            for (ctx = 0; ctx < MULTITHREAD; ctx++)
-                results[ctx].memblock[i + 1]
-                    = (char *)(results[ctx].memblock[0]) + results[0].size * j;
-            j++;
-        }
-    }
-    /* call inits */
-    for (i = 0; i < MULTITHREAD; i++)
+#else
+    core_init_data(results, MULTITHREAD);
+#endif
+#if PREFLIGHT_RUN
+    if (preflight == NULL || parseval(preflight) > 0)
     {
-        if (results[i].execs & ID_LIST)
-        {
-            results[i].list = core_list_init(
-                results[0].size, results[i].memblock[1], results[i].seed1);
-        }
-        if (results[i].execs & ID_MATRIX)
-        {
-            core_init_matrix(results[0].size,
-                             results[i].memblock[2],
-                             (ee_s32)results[i].seed1
-                                 | (((ee_s32)results[i].seed2) << 16),
-                             &(results[i].mat));
-        }
-        if (results[i].execs & ID_STATE)
+#if REFERENCE_RUN
+        const char *cache = reference_cache;
+#else
+        const char *cache = NULL;
+#endif
+        if (core_preflight(results,
+                           default_num_contexts,
+                           preflight ? (ee_u32)parseval(preflight)
+                                     : PREFLIGHT_ITERATIONS,
+                           cache))
         {
-            core_init_state(
-                results[0].size, results[i].seed1, results[i].memblock[3]);
+            ee_printf("Errors detected\n");
+            portable_fini(&(results[0].port));
+            return MAIN_FAIL_VAL;
         }
     }
+#endif
 
     /* automatically determine number of iterations if not set */
     if (results[0].iterations == 0)
-    {
-        secs_ret secs_passed = 0;
-        ee_u32   divisor;
-        results[0].iterations = 1;
-        while (secs_passed < (secs_ret)1)
-        {
-            results[0].iterations *= 10;
-            start_time();
-            iterate(&results[0]);
-            stop_time();
-            secs_passed = time_in_secs(get_time());
-        }
-        /* now we know it executes for at least 1 sec, set actual run time at
-         * about 10 secs */
-        divisor = (ee_u32)secs_passed;
-        if (divisor == 0) /* some machines cast float to int as 0 since this
-                             conversion is not defined by ANSI, but we know at
-                             least one second passed */
-            divisor = 1;
-        results[0].iterations *= 1 + 10 / divisor;
-    }
+        core_calibrate(&results[0]);
     /* perform actual benchmark */
-    start_time();
-#if (MULTITHREAD > 1)
-    if (default_num_contexts > MULTITHREAD)
-    {
-        default_num_contexts = MULTITHREAD;
-    }
-    for (i = 0; i < default_num_contexts; i++)
-    {
-        results[i].iterations = results[0].iterations;
-        results[i].execs      = results[0].execs;
-        core_start_parallel(&results[i]);
-    }
-    for (i = 0; i < default_num_contexts; i++)
-    {
-        core_stop_parallel(&results[i]);
-    }
-#else
-    iterate(&results[0]);
+#if TRACE_RUN
+    /* trace the timed run only, and write the trace after it */
+    if (trace_file != NULL && core_trace_start() != 0)
+        trace_file = NULL;
+#endif
+#if CGROUP_AWARE
+    portable_cgroup_section(1);
+#endif
+    total_time = core_run_contexts(results, default_num_contexts);
+#if CGROUP_AWARE
+    portable_cgroup_section(0);
+#endif
+#if TRACE_RUN
+    if (trace_file != NULL)
+        core_trace_flush(trace_file);
 #endif
-    stop_time();
-    total_time = get_time();
     /* get a function of the input to report */
-    seedcrc = crc16(results[0].seed1, seedcrc);
-    seedcrc = crc16(results[0].seed2, seedcrc);
-    seedcrc = crc16(results[0].seed3, seedcrc);
-    seedcrc = crc16(results[0].size, seedcrc);
-
-    switch (seedcrc)
-    {                /* test known output for common seeds */
-        case 0x8a02: /* seed1=0, seed2=0, seed3=0x66, size 2000 per algorithm */
-            known_id = 0;
+    known_id = core_known_id(&results[0], &seedcrc);
+    switch (known_id)
+    {
+        case 0:
             ee_printf("6k performance run parameters for coremark.\n");
             break;
-        case 0x7b05: /*  seed1=0x3415, seed2=0x3415, seed3=0x66, size 2000 per
-                        algorithm */
-            known_id = 1;
+        case 1:
             ee_printf("6k validation run parameters for coremark.\n");
             break;
-        case 0x4eaf: /* seed1=0x8, seed2=0x8, seed3=0x8, size 400 per algorithm
-                      */
-            known_id = 2;
+        case 2:
             ee_printf("Profile generation run parameters for coremark.\n");
             break;
-        case 0xe9f5: /* seed1=0, seed2=0, seed3=0x66, size 666 per algorithm */
-            known_id = 3;
+        case 3:
             ee_printf("2K performance run parameters for coremark.\n");
             break;
-        case 0x18f2: /*  seed1=0x3415, seed2=0x3415, seed3=0x66, size 666 per
-                        algorithm */
-            known_id = 4;
+        case 4:
             ee_printf("2K validation run parameters for coremark.\n");
             break;
         default:
@@ -319,40 +661,12 @@ for (i = 0; i < MULTITHREAD; i++)
             break;
     }
     if (known_id >= 0)
-    {
-        for (i = 0; i < default_num_contexts; i++)
-        {
-            results[i].err = 0;
-            if ((results[i].execs & ID_LIST)
-                && (results[i].crclist != list_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! list crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crclist,
-                          list_known_crc[known_id]);
-                results[i].err++;
-            }
-            if ((results[i].execs & ID_MATRIX)
-                && (results[i].crcmatrix != matrix_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! matrix crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crcmatrix,
-                          matrix_known_crc[known_id]);
-                results[i].err++;
-            }
-            if ((results[i].execs & ID_STATE)
-                && (results[i].crcstate != state_known_crc[known_id]))
-            {
-                ee_printf("[%u]ERROR! state crc 0x%04x - should be 0x%04x\n",
-                          i,
-                          results[i].crcstate,
-                          state_known_crc[known_id]);
-                results[i].err++;
-            }
-            total_errors += results[i].err;
-        }
-    }
+        total_errors += core_check_crcs(results, default_num_contexts, known_id);
+#if REFERENCE_RUN
+    else
+        total_errors = core_reference_check(
+            results, default_num_contexts, reference_cache);
+#endif
     total_errors += check_data_types();
     /* and report results */
     ee_printf("CoreMark Size    : %lu\n", (long unsigned)results[0].size);
@@ -376,6 +690,10 @@ for (i = 0; i < MULTITHREAD; i++)
             "ERROR! Must execute for at least 10 secs for a valid result!\n");
         total_errors++;
     }
+#if CGROUP_AWARE
+    /* a throttled run measures the quota, not the cpus */
+    total_errors += portable_cgroup_check();
+#endif
 
     ee_printf("Iterations       : %lu\n",
               (long unsigned)default_num_contexts * results[0].iterations);
@@ -385,6 +703,24 @@ for (i = 0; i < MULTITHREAD; i++)
     ee_printf("Parallel %s : %d\n", PARALLEL_METHOD, default_num_contexts);
 #endif
     ee_printf("Memory location  : %s\n", MEM_LOCATION);
+#if HYBRID_RUN
+    core_hybrid_print();
+#endif
+#if KERNEL_REGISTRY
+    core_kernels_print();
+#endif
+#if MULTIVERSION
+    ee_printf("Kernel clones    : %s\n", portable_clone_name());
+#endif
+#if QUIET_SYSTEM
+    portable_quiet_print();
+#endif
+#if SNAPSHOT_RUN
+    if (snapshot_file != NULL)
+        ee_printf("Data snapshot    : %s (%s)\n",
+                  snapshot_file,
+                  restored ? "restored" : "saved");
+#endif
     /* output for verification */
     ee_printf("seedcrc          : 0x%04x\n", seedcrc);
     if (results[0].execs & ID_LIST)
@@ -398,6 +734,16 @@ for (i = 0; i < MULTITHREAD; i++)
             ee_printf("[%d]crcstate      : 0x%04x\n", i, results[i].crcstate);
     for (i = 0; i < default_num_contexts; i++)
         ee_printf("[%d]crcfinal      : 0x%04x\n", i, results[i].crc);
+#if PLUGIN_RUN
+    /* plugins are reported after the CoreMark results, a failed plugin
+     * counts as an error of the run */
+    if (plugin_names != NULL
+        && core_plugins_run(plugin_names,
+                            &results[0],
+                            plugin_ms ? (ee_u32)parseval(plugin_ms) : 0)
+        && total_errors >= 0)
+        total_errors++;
+#endif
     if (total_errors == 0)
     {
         ee_printf(
@@ -432,8 +778,13 @@ for (i = 0; i < MULTITHREAD; i++)
             "with results on a known platform.\n");
 
 #if (MEM_METHOD == MEM_MALLOC)
-    for (i = 0; i < MULTITHREAD; i++)
-        portable_free(results[i].memblock[0]);
+#if SNAPSHOT_RUN
+    if (!core_snapshot_release(results, MULTITHREAD))
+#endif
+        for (i = 0; i < MULTITHREAD; i++)
+            portable_free(results[i].memblock[0]);
+#elif SNAPSHOT_RUN
+    core_snapshot_release(results, MULTITHREAD);
 #endif
     /* And last call any target specific code for finalizing */
     portable_fini(&(results[0].port));
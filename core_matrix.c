@@ -39,7 +39,6 @@ ee_s16 matrix_test(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val);
 ee_s16 matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval);
 void   matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val);
 void   matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
-void   matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
 void   matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
 void   matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val);
 
@@ -152,7 +151,7 @@ matrix_test(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val)
 #if CORE_DEBUG
     printmatC(C, N, "matrix_mul_vect");
 #endif
-    matrix_mul_matrix(N, C, A, B);
+    KERNEL_MATRIX_MUL_MATRIX(N, C, A, B);
     crc = crc16(matrix_sum(N, C, clipval), crc);
 #if CORE_DEBUG
     printmatC(C, N, "matrix_mul_matrix");
@@ -240,6 +239,7 @@ core_init_matrix(ee_u32 blksize, void *memblk, ee_s32 seed, mat_params *p)
 
         Otherwise, reset the accumulator and add 10 to the result.
 */
+CORE_CLONES
 ee_s16
 matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval)
 {
@@ -250,6 +250,7 @@ matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval)
     {
         for (j = 0; j < N; j++)
         {
+            TRACE_MATRIX(&C[i * N + j]);
             cur = C[i * N + j];
             tmp += cur;
             if (tmp > clipval)
@@ -271,6 +272,7 @@ matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval)
         Multiply a matrix by a constant.
         This could be used as a scaler for instance.
 */
+CORE_CLONES
 void
 matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val)
 {
@@ -279,6 +281,8 @@ matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val)
     {
         for (j = 0; j < N; j++)
         {
+            TRACE_MATRIX(&A[i * N + j]);
+            TRACE_MATRIX(&C[i * N + j]);
             C[i * N + j] = (MATRES)A[i * N + j] * (MATRES)val;
         }
     }
@@ -287,6 +291,7 @@ matrix_mul_const(ee_u32 N, MATRES *C, MATDAT *A, MATDAT val)
 /* Function: matrix_add_const
         Add a constant value to all elements of a matrix.
 */
+CORE_CLONES
 void
 matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val)
 {
@@ -295,6 +300,7 @@ matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val)
     {
         for (j = 0; j < N; j++)
         {
+            TRACE_MATRIX(&A[i * N + j]);
             A[i * N + j] += val;
         }
     }
@@ -305,15 +311,19 @@ matrix_add_const(ee_u32 N, MATDAT *A, MATDAT val)
         This is common in many simple filters (e.g. fir where a vector of
    coefficients is applied to the matrix.)
 */
+CORE_CLONES
 void
 matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
 {
     ee_u32 i, j;
     for (i = 0; i < N; i++)
     {
+        TRACE_MATRIX(&C[i]);
         C[i] = 0;
         for (j = 0; j < N; j++)
         {
+            TRACE_MATRIX(&A[i * N + j]);
+            TRACE_MATRIX(&B[j]);
             C[i] += (MATRES)A[i * N + j] * (MATRES)B[j];
         }
     }
@@ -324,6 +334,7 @@ matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
         Basic code is used in many algorithms, mostly with minor changes such as
    scaling.
 */
+CORE_CLONES
 void
 matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
 {
@@ -332,9 +343,12 @@ matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
     {
         for (j = 0; j < N; j++)
         {
+            TRACE_MATRIX(&C[i * N + j]);
             C[i * N + j] = 0;
             for (k = 0; k < N; k++)
             {
+                TRACE_MATRIX(&A[i * N + k]);
+                TRACE_MATRIX(&B[k * N + j]);
                 C[i * N + j] += (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
             }
         }
@@ -346,6 +360,7 @@ matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
         Basic code is used in many algorithms, mostly with minor changes such as
    scaling.
 */
+CORE_CLONES
 void
 matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
 {
@@ -354,10 +369,14 @@ matrix_mul_matrix_bitextract(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B)
     {
         for (j = 0; j < N; j++)
         {
+            TRACE_MATRIX(&C[i * N + j]);
             C[i * N + j] = 0;
             for (k = 0; k < N; k++)
             {
-                MATRES tmp = (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+                MATRES tmp;
+                TRACE_MATRIX(&A[i * N + k]);
+                TRACE_MATRIX(&B[k * N + j]);
+                tmp = (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
                 // C[i * N + j] += bit_extract(tmp, 2, 4) * bit_extract(tmp, 5, 7);
             }
         }
@@ -0,0 +1,464 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Work mix.
+
+        In a regular run, the memory block is split evenly between the
+        algorithms, and the matrix and state work is whatever <calc_func>
+        triggers from the data of the list. The work mix sets each of them
+        explicitly, to match the profile of a service:
+        - the size of each algorithm: list nodes, matrix N and state bytes.
+        - the share of the time of each algorithm (e.g. 30:10:60 for 30%
+        pointer chasing, 10% multiply-accumulate and 60% parsing).
+
+        The work is made of units: a list unit is the two <core_bench_list>
+        calls of an iteration, including the matrix and state work that
+        <calc_func> runs on the data of the mix, as in a regular iteration; a
+        matrix unit is one <core_bench_matrix>, and a state unit one
+        <core_bench_state>, with the parameters <calc_func> would give them.
+        The matrix and state data are set up even when their weight is 0, as
+        long as the list runs. The time of a unit of each algorithm is measured, and the
+        number of units of each algorithm in a mix iteration is set so that
+        their times follow the weights. The units of an iteration are
+        interleaved.
+
+        The crcs of the first mix iteration depend on the whole
+        configuration, so they are computed for each run: one iteration runs
+        with the reference implementation of <REFERENCE_RUN> on its own data,
+        or else with the reference kernels on freshly initialized data, then
+        the data is initialized again for the timed run, whose first
+        iteration must give the same crcs.
+*/
+#if MIX_RUN
+#include <string.h>
+
+#define MIX_DEFAULT_MS 2000
+#define MIX_MIN_UNITS  4    /* units of the algorithm with the fewest */
+#define MIX_MAX_UNITS  4096 /* units of an algorithm per mix iteration */
+
+typedef struct MIX_S
+{
+    core_results res;
+    ee_u32       bytes[NUM_ALGORITHMS];  /* size given to each init */
+    ee_u32       space[NUM_ALGORITHMS];  /* bytes used by each algorithm */
+    ee_u32       weight[NUM_ALGORITHMS]; /* relative share of the time */
+    ee_u32       units[NUM_ALGORITHMS];  /* per mix iteration */
+    secs_ret     unit_secs[NUM_ALGORITHMS];
+    ee_u32       max_units;
+    ee_u32       step; /* units run, varies the matrix and state inputs */
+    ee_u16       crc[NUM_ALGORITHMS]; /* of each algorithm, first iteration */
+    ee_u16       crcfinal;            /* of all the units, first iteration */
+#if REFERENCE_RUN
+    core_ref *ref; /* runs the units instead of the kernels if set */
+#endif
+} core_mix;
+
+static const char *mix_names[NUM_ALGORITHMS] = { "list", "matrix", "state" };
+
+#if KERNEL_REGISTRY
+static const core_kernels mix_reference = { core_list_find,
+                                            core_list_mergesort,
+                                            matrix_mul_matrix,
+                                            core_state_transition,
+                                            crcu16 };
+#endif
+
+/* Function: mix_parse
+        Parse up to <NUM_ALGORITHMS> values separated by colons, in the order
+   list, matrix, state. Empty values are left unchanged.
+
+        Returns:
+        0 on success, 1 on a syntax error.
+*/
+static ee_s16
+mix_parse(char *spec, ee_u32 *v)
+{
+    ee_u32 k;
+    for (k = 0; k < NUM_ALGORITHMS && *spec; k++)
+    {
+        if (*spec != ':')
+        {
+            if (*spec < '0' || *spec > '9')
+                return 1;
+            v[k] = (ee_u32)parseval(spec);
+        }
+        spec = strchr(spec, ':');
+        if (spec == NULL)
+            return 0;
+        spec++;
+    }
+    return *spec ? 1 : 0;
+}
+
+/* Function: mix_matrix_space
+        Bytes used by the matrices that <core_init_matrix> sets up in
+   <blksize> bytes. It derives N as if MATDAT and MATRES were 16 and 32 bit,
+   so wider types take more than <blksize>.
+*/
+static ee_u32
+mix_matrix_space(ee_u32 blksize)
+{
+    ee_u32 i = 0;
+    while (i * i * 2 * 4 < blksize)
+        i++;
+    i = i ? i - 1 : 0;
+    /* A, B and C, each aligned by align_mem */
+    return i * i * (2 * sizeof(MATDAT) + sizeof(MATRES)) + 2 * 8;
+}
+
+/* Function: mix_init
+        Initialize the data of each algorithm in its part of the block: of
+   each algorithm that runs, and of the matrix and state whenever the list
+   runs, as <calc_func> uses them.
+*/
+static void
+mix_init(core_mix *m)
+{
+    core_results *res = &m->res;
+    char *        p   = (char *)res->memblock[0];
+    ee_u32        k;
+
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        res->memblock[k + 1] = p;
+        p += m->space[k];
+    }
+    if (m->weight[0])
+        res->list = core_list_init(m->bytes[0], res->memblock[1], res->seed1);
+    if (m->weight[1] || m->weight[0])
+        core_init_matrix(m->bytes[1],
+                         res->memblock[2],
+                         (ee_s32)res->seed1 | (((ee_s32)res->seed2) << 16),
+                         &(res->mat));
+    if (m->weight[2] || m->weight[0])
+        core_init_state(m->bytes[2], res->seed1, res->memblock[3]);
+    /* <calc_func> chains its work on these, as <iterate> starts them */
+    res->crc       = 0;
+    res->crcmatrix = 0;
+    res->crcstate  = 0;
+    m->step        = 0;
+}
+
+/* Function: mix_unit
+        Run one unit of algorithm <k>.
+
+        Returns:
+        The crc of the unit.
+*/
+static ee_u16
+mix_unit(core_mix *m, ee_u32 k)
+{
+    core_results *res   = &m->res;
+    ee_s16        dtype = (ee_s16)(m->step++ & 0xf);
+    ee_u16        crc   = 0;
+
+    dtype |= dtype << 4; /* as <calc_func> does */
+#if REFERENCE_RUN
+    if (m->ref != NULL)
+    {
+        switch (k)
+        {
+            case 0:
+                crc = core_ref_crcu16(core_ref_list(m->ref, 1), crc);
+                return core_ref_crcu16(core_ref_list(m->ref, -1), crc);
+            case 1:
+                return core_ref_matrix(m->ref, dtype, crc);
+            default:
+                if (dtype < 0x22)
+                    dtype = 0x22;
+                return core_ref_state(m->ref, dtype, crc);
+        }
+    }
+#endif
+    switch (k)
+    {
+        case 0:
+            crc = KERNEL_CRCU16(core_bench_list(res, 1), crc);
+            crc = KERNEL_CRCU16(core_bench_list(res, -1), crc);
+            break;
+        case 1:
+            crc = core_bench_matrix(&(res->mat), dtype, crc);
+            break;
+        default:
+            if (dtype < 0x22) /* same min period as <calc_func> */
+                dtype = 0x22;
+            crc = core_bench_state(m->bytes[2],
+                                   res->memblock[3],
+                                   res->seed1,
+                                   res->seed2,
+                                   dtype,
+                                   crc);
+            break;
+    }
+    return crc;
+}
+
+/* Function: mix_iterate
+        Run <iterations> mix iterations, keeping the crcs of the first one.
+*/
+static void
+mix_iterate(core_mix *m, ee_u32 iterations)
+{
+    ee_u32 i, j, k;
+    ee_u16 crc = 0, v;
+
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+        m->crc[k] = 0;
+    for (i = 0; i < iterations; i++)
+    {
+        /* spread the units of each algorithm over the iteration */
+        for (j = 0; j < m->max_units; j++)
+        {
+            for (k = 0; k < NUM_ALGORITHMS; k++)
+            {
+                if ((j + 1) * m->units[k] / m->max_units
+                    == j * m->units[k] / m->max_units)
+                    continue;
+                v   = mix_unit(m, k);
+                crc = KERNEL_CRCU16(v, crc);
+                if (i == 0)
+                    m->crc[k] = KERNEL_CRCU16(v, m->crc[k]);
+            }
+        }
+        if (i == 0)
+            m->crcfinal = crc;
+    }
+}
+
+/* Function: mix_unit_time
+        Measure the time of a unit of algorithm <k>, over at least <secs>.
+
+        Returns:
+        The time of a unit in seconds.
+*/
+static secs_ret
+mix_unit_time(core_mix *m, ee_u32 k, secs_ret secs)
+{
+    secs_ret start, t = 0;
+    ee_u32   n = 1, i;
+
+    for (;;)
+    {
+        start = portable_time();
+        for (i = 0; i < n; i++)
+            mix_unit(m, k);
+        t = portable_time() - start;
+        if (t >= secs || n >= 0x40000000)
+            break;
+        n *= 2;
+    }
+    return t / n;
+}
+
+/* Function: core_mix_run
+        Run the benchmark with the given sizes and weights of the algorithms.
+
+        Parameters:
+        res - seeds, and total size of the data block, split evenly between
+   the algorithms whose size is not given.
+        weights - list:matrix:state shares of the time, NULL for equal
+   shares. A weight of 0 disables the algorithm.
+        sizes - list nodes:matrix N:state bytes, NULL or empty values for an
+   even split.
+        ms - length of the timed run, 0 for <MIX_DEFAULT_MS>.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+ee_s16
+core_mix_run(core_results *res, char *weights, char *sizes, ee_u32 ms)
+{
+    core_mix m;
+    ee_u32   size[NUM_ALGORITHMS] = { 0, 0, 0 };
+    ee_u32   k, total = 0, iterations;
+    ee_u16   ref[NUM_ALGORITHMS], ref_final;
+#if REFERENCE_RUN
+    ee_u32 bytes[NUM_ALGORITHMS], offset[NUM_ALGORITHMS];
+#endif
+    secs_ret secs, it_secs = 0, least = 0;
+    ee_s16   err = 0;
+    /* bytes of a list node and its data, as in <core_list_init> */
+    const ee_u32 per_item = 16 + sizeof(struct list_data_s);
+
+    memset(&m, 0, sizeof(m));
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+        m.weight[k] = 1;
+    if ((weights != NULL && *weights && mix_parse(weights, m.weight))
+        || (sizes != NULL && mix_parse(sizes, size)))
+    {
+        ee_printf("ERROR! Invalid mix, expected <list>:<matrix>:<state>\n");
+        return 1;
+    }
+    if (m.weight[0] + m.weight[1] + m.weight[2] == 0)
+    {
+        ee_printf("ERROR! All the weights of the mix are 0\n");
+        return 1;
+    }
+    if (ms == 0)
+        ms = MIX_DEFAULT_MS;
+
+    /* the bytes each init turns into the given number of items */
+    m.bytes[0] = size[0] ? (size[0] + 2) * per_item : res->size / 3;
+    m.bytes[1] = size[1] ? (size[1] + 1) * (size[1] + 1) * 2 * 4
+                         : res->size / 3;
+    m.bytes[2] = size[2] ? size[2] : res->size / 3;
+    if (m.bytes[0] < 6 * per_item || m.bytes[1] < 8 || m.bytes[2] < 8)
+    {
+        ee_printf("ERROR! Mix sizes too small\n");
+        return 1;
+    }
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        m.space[k] = m.bytes[k];
+        if (k == 1 && mix_matrix_space(m.bytes[k]) > m.space[k])
+            m.space[k] = mix_matrix_space(m.bytes[k]);
+        /* keep each part aligned for the list pointers */
+        m.space[k] = (m.space[k] + 7) & ~7u;
+        total += m.space[k];
+    }
+    m.res.seed1       = res->seed1;
+    m.res.seed2       = res->seed2;
+    m.res.seed3       = res->seed3;
+    m.res.execs       = ALL_ALGORITHMS_MASK;
+    m.res.size        = m.bytes[2]; /* of the state, for <calc_func> */
+    m.res.memblock[0] = portable_malloc(total);
+    if (m.res.memblock[0] == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate %u bytes\n", total);
+        return 1;
+    }
+
+    /* units per iteration from the time of a unit and the weights */
+    mix_init(&m);
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        if (m.weight[k] == 0)
+            continue;
+        m.unit_secs[k] = mix_unit_time(&m, k, (secs_ret)ms / 1000 / 50);
+        secs           = m.weight[k] / m.unit_secs[k];
+        if (least == 0 || secs < least)
+            least = secs;
+    }
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        if (m.weight[k] == 0)
+            continue;
+        secs       = MIX_MIN_UNITS * (m.weight[k] / m.unit_secs[k]) / least;
+        m.units[k] = secs < MIX_MAX_UNITS ? (ee_u32)(secs + 0.5)
+                                          : MIX_MAX_UNITS;
+        if (m.units[k] > m.max_units)
+            m.max_units = m.units[k];
+        it_secs += m.units[k] * m.unit_secs[k];
+    }
+    iterations = (ee_u32)((secs_ret)ms / 1000 / it_secs) + 1;
+
+    /* reference crcs of this configuration */
+    {
+#if KERNEL_REGISTRY
+        core_kernels selected = core_kernel;
+        core_kernel           = mix_reference;
+#endif
+#if REFERENCE_RUN
+        for (k = 0, total = 0; k < NUM_ALGORITHMS; k++)
+        {
+            bytes[k]  = (m.weight[k] || m.weight[0]) ? m.bytes[k] : 0;
+            offset[k] = total;
+            total += m.space[k];
+        }
+        m.ref = core_ref_new(&m.res, bytes, offset, total);
+        if (m.ref == NULL)
+        {
+            ee_printf("ERROR! Cannot set up the reference of the mix\n");
+            portable_free(m.res.memblock[0]);
+            return 1;
+        }
+#endif
+        mix_init(&m);
+        mix_iterate(&m, 1);
+#if REFERENCE_RUN
+        core_ref_free(m.ref);
+        m.ref = NULL;
+#endif
+#if KERNEL_REGISTRY
+        core_kernel = selected;
+#endif
+        memcpy(ref, m.crc, sizeof(ref));
+        ref_final = m.crcfinal;
+    }
+
+    mix_init(&m);
+    secs = portable_time();
+    mix_iterate(&m, iterations);
+    secs = portable_time() - secs;
+
+    ee_printf("Mix sizes        : list %u nodes, matrix N=%u, state %u "
+              "bytes\n",
+              m.weight[0] ? m.bytes[0] / per_item - 2 : 0,
+              m.weight[1] ? m.res.mat.N : 0,
+              m.weight[2] ? m.bytes[2] : 0);
+    ee_printf("Algorithm  Weight   Units   Unit (us)    Share\n");
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+        ee_printf("%-10s %6u %7u %11.3f %7.1f%%\n",
+                  mix_names[k],
+                  m.weight[k],
+                  m.units[k],
+                  m.unit_secs[k] * 1000000,
+                  100 * m.units[k] * m.unit_secs[k] / it_secs);
+    ee_printf("Iterations       : %u\n", iterations);
+    ee_printf("Total time (secs): %f\n", secs);
+    if (secs > 0)
+        ee_printf("Iterations/Sec   : %f\n", iterations / secs);
+    ee_printf("Mix crcs         : list 0x%04x, matrix 0x%04x, state 0x%04x, "
+              "final 0x%04x\n",
+              m.crc[0],
+              m.crc[1],
+              m.crc[2],
+              m.crcfinal);
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        if (m.crc[k] != ref[k])
+        {
+            ee_printf("ERROR! %s crc 0x%04x - should be 0x%04x\n",
+                      mix_names[k],
+                      m.crc[k],
+                      ref[k]);
+            err = 1;
+        }
+    }
+    if (!err && m.crcfinal != ref_final)
+    {
+        ee_printf("ERROR! final crc 0x%04x - should be 0x%04x\n",
+                  m.crcfinal,
+                  ref_final);
+        err = 1;
+    }
+    if (err)
+        ee_printf("Errors detected\n");
+    else
+#if REFERENCE_RUN
+        ee_printf("Correct operation validated against the reference "
+                  "implementation.\n");
+#else
+        ee_printf("Correct operation validated against the reference "
+                  "kernels.\n");
+#endif
+    portable_free(m.res.memblock[0]);
+    return err;
+}
+#endif /* MIX_RUN */
@@ -0,0 +1,418 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Pipelined execution of the state, list and matrix kernels.
+
+        Instead of running all kernels of a context on one core, each kernel
+        is a stage of a producer/consumer pipeline, running on its own pinned
+        core:
+
+        state - parses the state machine input token by token, and emits a
+        classified token record (final state and a hash of the token).
+
+        list - collects records in batches of N, inserts them in a list and
+        sorts it with <core_list_mergesort>, then emits the sorted batch as a
+        vector of N values.
+
+        matrix - multiplies the NxN matrix by each vector with
+        <matrix_mul_vect>.
+
+        Stages are connected by single producer, single consumer rings. A
+        stage waits when its output ring is full (backpressure) or its input
+        ring is empty. The time spent waiting gives the utilization of each
+        stage, and the most utilized stage is the bottleneck.
+
+        Each stage also keeps a crc of its output. Since the rings preserve
+        order, the crcs do not depend on timing or on the cpus used.
+*/
+#if PIPELINE_RUN
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define PIPE_STAGES         3
+#define PIPE_RING_SLOTS     256 /* power of 2 */
+#define PIPE_DEFAULT_RECORDS (1024 * 1024)
+#define PIPE_CACHELINE      64
+
+/* Type: pipe_ring
+        Single producer, single consumer ring of fixed size slots.
+        Head is only written by the producer, tail only by the consumer.
+*/
+typedef struct PIPE_RING_S
+{
+    ee_u8 *slots;
+    ee_u32 slot_size;
+    ee_u8  pad0[PIPE_CACHELINE];
+    ee_u32 head;
+    ee_u8  pad1[PIPE_CACHELINE];
+    ee_u32 tail;
+    ee_u8  pad2[PIPE_CACHELINE];
+} pipe_ring;
+
+/* classified token, emitted by the state stage */
+typedef struct PIPE_RECORD_S
+{
+    ee_s16 data16; /* final state << 8 | token hash, -1 at end of stream */
+    ee_s16 idx;    /* sequence number */
+} pipe_record;
+
+typedef struct PIPE_STAGE_S
+{
+    const char *name;
+    ee_u32      cpu;
+    ee_u8       pinned;
+    pthread_t   thread;
+    secs_ret    start, stop, wait;
+    ee_u32      items; /* items produced */
+    ee_u16      crc;   /* crc of the items produced */
+} pipe_stage;
+
+typedef struct PIPE_CTX_S
+{
+    pipe_stage stage[PIPE_STAGES];
+    pipe_ring  ring[PIPE_STAGES - 1];
+    ee_u32     records;
+    ee_u32     N;
+    ee_u8 *    state_mem;
+    ee_u32     state_size;
+    mat_params mat;
+    list_head *nodes;
+    list_data *infos;
+} pipe_ctx;
+
+/* Function: ring_reserve
+        Wait for a free slot in the ring (backpressure), and return it.
+*/
+static void *
+ring_reserve(pipe_ring *r, pipe_stage *s)
+{
+    ee_u32 head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == PIPE_RING_SLOTS)
+    {
+        secs_ret t0 = portable_time();
+        while (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE)
+               == PIPE_RING_SLOTS)
+            sched_yield();
+        s->wait += portable_time() - t0;
+    }
+    return r->slots + (head & (PIPE_RING_SLOTS - 1)) * r->slot_size;
+}
+
+static void
+ring_commit(pipe_ring *r)
+{
+    __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+/* Function: ring_peek
+        Wait for an item in the ring, and return it.
+*/
+static void *
+ring_peek(pipe_ring *r, pipe_stage *s)
+{
+    ee_u32 tail = r->tail;
+    if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        secs_ret t0 = portable_time();
+        while (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail)
+            sched_yield();
+        s->wait += portable_time() - t0;
+    }
+    return r->slots + (tail & (PIPE_RING_SLOTS - 1)) * r->slot_size;
+}
+
+static void
+ring_release(pipe_ring *r)
+{
+    __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+}
+
+static void
+stage_begin(pipe_stage *s)
+{
+    s->pinned = portable_set_affinity(s->cpu);
+    s->start  = portable_time();
+}
+
+/* Function: pipe_state_stage
+        Parse the state input over and over, emitting one record per token.
+*/
+static void *
+pipe_state_stage(void *arg)
+{
+    pipe_ctx *   ctx = (pipe_ctx *)arg;
+    pipe_stage * s   = &ctx->stage[0];
+    ee_u32       counts[NUM_CORE_STATES];
+    ee_u8 *      p = ctx->state_mem;
+    pipe_record *rec;
+    ee_u32       i;
+
+    for (i = 0; i < NUM_CORE_STATES; i++)
+        counts[i] = 0;
+    stage_begin(s);
+    for (i = 0; i < ctx->records; i++)
+    {
+        ee_u8 *         tok;
+        enum CORE_STATE fstate;
+        ee_u8           hash = 0;
+
+        if (*p == 0)
+            p = ctx->state_mem; /* wrap around the input */
+        tok    = p;
+        fstate = KERNEL_STATE_TRANSITION(&p, counts);
+        while (tok < p)
+            hash = (ee_u8)((hash << 1) ^ (hash >> 7) ^ *tok++);
+        rec         = (pipe_record *)ring_reserve(&ctx->ring[0], s);
+        rec->data16 = (ee_s16)((fstate << 8) | hash);
+        rec->idx    = (ee_s16)(i & 0x7fff);
+        ring_commit(&ctx->ring[0]);
+        s->crc = crc16(rec->data16, s->crc);
+    }
+    rec         = (pipe_record *)ring_reserve(&ctx->ring[0], s);
+    rec->data16 = -1;
+    ring_commit(&ctx->ring[0]);
+    s->items = ctx->records;
+    s->stop  = portable_time();
+    return NULL;
+}
+
+/* Function: pipe_cmp
+        Order records by content, then by arrival.
+*/
+static ee_s32
+pipe_cmp(list_data *a, list_data *b, core_results *res)
+{
+    (void)res; /* no calc_func, the records are compared as they are */
+    if (a->data16 != b->data16)
+        return a->data16 - b->data16;
+    return a->idx - b->idx;
+}
+
+/* Function: pipe_list_stage
+        Insert batches of N records in a list, sort them, and emit each sorted
+   batch as a vector.
+*/
+static void *
+pipe_list_stage(void *arg)
+{
+    pipe_ctx *  ctx = (pipe_ctx *)arg;
+    pipe_stage *s   = &ctx->stage[1];
+    ee_u32      N   = ctx->N;
+    MATDAT *    end;
+    int         done = 0;
+
+    stage_begin(s);
+    while (!done)
+    {
+        list_head *memblock  = ctx->nodes + 1;
+        list_data *datablock = ctx->infos + 1;
+        list_head *list      = ctx->nodes;
+        list_head *finder;
+        MATDAT *   vect;
+        ee_u32     n;
+
+        list->next = NULL;
+        list->info = ctx->infos;
+        for (n = 0; n < N; n++)
+        {
+            pipe_record *rec = (pipe_record *)ring_peek(&ctx->ring[0], s);
+            list_data    info;
+            if (rec->data16 == -1)
+            {
+                done = 1; /* keep the end marker, nothing more will come */
+                break;
+            }
+            info.data16 = rec->data16;
+            info.idx    = rec->idx;
+            ring_release(&ctx->ring[0]);
+            core_list_insert_new(list,
+                                 &info,
+                                 &memblock,
+                                 &datablock,
+                                 ctx->nodes + N + 2,
+                                 ctx->infos + N + 2);
+        }
+        if (n == 0)
+            break;
+        list->next = KERNEL_LIST_MERGESORT(list->next, pipe_cmp, NULL);
+
+        vect = (MATDAT *)ring_reserve(&ctx->ring[1], s);
+        for (n = 0, finder = list->next; finder; finder = finder->next)
+        {
+            s->crc    = crc16(finder->info->data16, s->crc);
+            vect[n++] = (MATDAT)(finder->info->data16 & 0xff);
+        }
+        while (n < N) /* pad the last batch */
+            vect[n++] = 0;
+        ring_commit(&ctx->ring[1]);
+        s->items++;
+    }
+    /* end marker for the matrix stage: a vector starting with -1 */
+    end = (MATDAT *)ring_reserve(&ctx->ring[1], s);
+    end[0] = (MATDAT)-1;
+    ring_commit(&ctx->ring[1]);
+    s->stop = portable_time();
+    return NULL;
+}
+
+/* Function: pipe_matrix_stage
+        Multiply the matrix by each vector.
+*/
+static void *
+pipe_matrix_stage(void *arg)
+{
+    pipe_ctx *  ctx = (pipe_ctx *)arg;
+    pipe_stage *s   = &ctx->stage[2];
+
+    stage_begin(s);
+    for (;;)
+    {
+        MATDAT *vect = (MATDAT *)ring_peek(&ctx->ring[1], s);
+        if (vect[0] == (MATDAT)-1)
+            break;
+        matrix_mul_vect(ctx->N, ctx->mat.C, ctx->mat.A, vect);
+        ring_release(&ctx->ring[1]);
+        s->crc = crc16(matrix_sum(ctx->N, ctx->mat.C, (MATDAT)0x7fff), s->crc);
+        s->items++;
+    }
+    s->stop = portable_time();
+    return NULL;
+}
+
+/* Function: core_pipeline_run
+        Run the pipelined benchmark.
+
+        Parameters:
+        res - seeds and size per algorithm to use.
+        records - number of token records to push through the pipeline, 0 for
+   the default.
+        cpus - list of cpus to pin the stages to, NULL to use cpus 0, 1 and 2.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+ee_s16
+core_pipeline_run(core_results *res, ee_u32 records, const char *cpus)
+{
+    pipe_ctx ctx;
+    ee_u8 *  mem;
+    ee_u32   i, size = res->size, ncpu = portable_num_cpus();
+    secs_ret start, stop, total, best = 0;
+    ee_u32   bottleneck = 0;
+    void *(*stage_func[PIPE_STAGES])(void *)
+        = { pipe_state_stage, pipe_list_stage, pipe_matrix_stage };
+    static const char *names[PIPE_STAGES] = { "state", "list", "matrix" };
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.records = records ? records : PIPE_DEFAULT_RECORDS;
+    for (i = 0; i < PIPE_STAGES; i++)
+    {
+        ctx.stage[i].name = names[i];
+        ctx.stage[i].cpu  = i % ncpu;
+    }
+    /* parse "a,b,c" */
+    for (i = 0; cpus && *cpus && i < PIPE_STAGES; i++)
+    {
+        ctx.stage[i].cpu = (ee_u32)parseval((char *)cpus);
+        while (*cpus && *cpus != ',')
+            cpus++;
+        if (*cpus == ',')
+            cpus++;
+    }
+
+    /* one block for the state input, one for the matrix. The matrix block
+     * is sized for the widest MATDAT/MATRES types, since core_init_matrix
+     * only accounts for 16b/32b elements. */
+    mem = (ee_u8 *)portable_malloc(3 * size + 16);
+    if (mem == NULL)
+        return 1;
+    ctx.state_mem  = mem;
+    ctx.state_size = size;
+    core_init_state(size, res->seed1, ctx.state_mem);
+    ctx.N = core_init_matrix(size,
+                             mem + size,
+                             (ee_s32)res->seed1 | (((ee_s32)res->seed2) << 16),
+                             &ctx.mat);
+    ctx.nodes = (list_head *)portable_malloc((ctx.N + 2) * sizeof(list_head));
+    ctx.infos = (list_data *)portable_malloc((ctx.N + 2) * sizeof(list_data));
+    ctx.ring[0].slot_size = sizeof(pipe_record);
+    ctx.ring[1].slot_size = ctx.N * sizeof(MATDAT);
+    for (i = 0; i < PIPE_STAGES - 1; i++)
+        ctx.ring[i].slots = (ee_u8 *)portable_malloc(PIPE_RING_SLOTS
+                                                     * ctx.ring[i].slot_size);
+    if (!ctx.nodes || !ctx.infos || !ctx.ring[0].slots || !ctx.ring[1].slots
+        || ctx.N == 0)
+    {
+        ee_printf("ERROR! Cannot allocate the pipeline\n");
+        portable_free(ctx.ring[1].slots);
+        portable_free(ctx.ring[0].slots);
+        portable_free(ctx.infos);
+        portable_free(ctx.nodes);
+        portable_free(mem);
+        return 1;
+    }
+    /* matrix_mul_vect only writes the first N entries of C, but matrix_sum
+     * reads all of them, so clear the rest once to keep the crc defined. */
+    memset(ctx.mat.C, 0, ctx.N * ctx.N * sizeof(MATRES));
+
+    start = portable_time();
+    for (i = 0; i < PIPE_STAGES; i++)
+        pthread_create(&ctx.stage[i].thread, NULL, stage_func[i], &ctx);
+    for (i = 0; i < PIPE_STAGES; i++)
+        pthread_join(ctx.stage[i].thread, NULL);
+    stop  = portable_time();
+    total = stop - start;
+
+    ee_printf("Pipeline records : %lu (batch %lu)\n",
+              (long unsigned)ctx.records,
+              (long unsigned)ctx.N);
+    ee_printf("Total time (secs): %f\n", total);
+    if (total > 0)
+        ee_printf("Records/sec      : %f\n", ctx.records / total);
+    for (i = 0; i < PIPE_STAGES; i++)
+    {
+        pipe_stage *s    = &ctx.stage[i];
+        secs_ret    run  = s->stop - s->start;
+        secs_ret    util = run > 0 ? (run - s->wait) / run : 0;
+        ee_printf("[%-6s] cpu %2lu%s  items %8lu  wait %9.6f  utilization "
+                  "%5.1f%%  crc 0x%04x\n",
+                  s->name,
+                  (long unsigned)s->cpu,
+                  s->pinned ? "" : "?",
+                  (long unsigned)s->items,
+                  s->wait,
+                  100 * util,
+                  s->crc);
+        if (util > best)
+        {
+            best       = util;
+            bottleneck = i;
+        }
+    }
+    ee_printf("Bottleneck stage : %s\n", ctx.stage[bottleneck].name);
+
+    for (i = 0; i < PIPE_STAGES - 1; i++)
+        portable_free(ctx.ring[i].slots);
+    portable_free(ctx.infos);
+    portable_free(ctx.nodes);
+    portable_free(mem);
+    return 0;
+}
+#endif /* PIPELINE_RUN */
@@ -0,0 +1,435 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Workload plugins.
+
+        A plugin adds a workload to the harness without changes to the
+        benchmark itself. It is described by a <core_plugin> structure of
+        callbacks:
+
+        describe - one line description for the report.
+        sizing - bytes of memory the plugin needs, given the size per
+        algorithm of the run.
+        init - initialize the memory from the seeds.
+        bench - run one iteration, returns a 16b value that the harness folds
+        into the plugin crc, as <iterate> does for the list benchmark.
+        validate - check the value returned by the first iteration.
+
+        Plugins are registered statically (the built-in ones in
+        <plugin_builtin>, or <core_plugin_register> from a program linked
+        with the library), or loaded with dlopen from a shared object that
+        exports a core_plugin named "coremark_plugin".
+
+        For each plugin selected with --plugin, the harness allocates the
+        memory, initializes it with the seeds of the run, calibrates and
+        times the iterations, validates the result and reports it after the
+        CoreMark score, or instead of the CoreMark run with --plugin-only.
+
+        Plugins are not part of the score. Result files sample them as
+        kernels next to the CoreMark ones with <core_plugin_sample>, see
+        core_compare.c; batch and cluster reports leave them out. The list,
+        matrix and state benchmarks are not plugins, and are still wired
+        into <core_init_data> and <calc_func>.
+*/
+#if PLUGIN_RUN
+#include <string.h>
+#if PLUGIN_DLOPEN
+#include <dlfcn.h>
+#endif
+
+#define MAX_PLUGINS 32
+/* calibrate plugins to run for about this time, unless set with
+ * --plugin-ms */
+#define PLUGIN_DEFAULT_MS 2000
+
+/* Plugin: crcblock
+        CRC of a pseudo random block, one byte at a time with <crcu8>. The
+   first result is checked against a CRC computed at init with the bitwise
+   reference algorithm, independent of <crcu8>.
+*/
+typedef struct CRCBLOCK_S
+{
+    ee_u32 len;
+    ee_u16 expect;
+    ee_u8  data[1];
+} crcblock;
+
+static const char *
+crcblock_describe(void)
+{
+    return "CRC-16 of a pseudo random block, one byte at a time";
+}
+
+static ee_u32
+crcblock_sizing(ee_u32 size)
+{
+    return size;
+}
+
+static ee_s16
+crcblock_init(void *mem, ee_u32 bytes, ee_s16 seed1, ee_s16 seed2, ee_s16 seed3)
+{
+    crcblock *b = (crcblock *)mem;
+    ee_u32    x = ((ee_u32)(ee_u16)seed1 << 16) | (ee_u16)seed2, i, k;
+    ee_u16    crc = 0;
+    if (bytes < sizeof(crcblock))
+        return 1;
+    b->len = bytes - (ee_u32)sizeof(crcblock) + 1;
+    for (i = 0; i < b->len; i++)
+    {
+        x          = x * 1103515245 + 12345 + (ee_u16)seed3;
+        b->data[i] = (ee_u8)(x >> 16);
+    }
+    /* reflected CRC-16, polynomial 0xa001 */
+    for (i = 0; i < b->len; i++)
+    {
+        crc ^= b->data[i];
+        for (k = 0; k < 8; k++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : crc >> 1;
+    }
+    b->expect = crc;
+    return 0;
+}
+
+static ee_u16
+crcblock_bench(void *mem, ee_u32 bytes)
+{
+    crcblock *b   = (crcblock *)mem;
+    ee_u16    crc = 0;
+    ee_u32    i;
+    (void)bytes;
+    for (i = 0; i < b->len; i++)
+        crc = crcu8(b->data[i], crc);
+    return crc;
+}
+
+static ee_s16
+crcblock_validate(void *mem, ee_u32 bytes, ee_u16 first)
+{
+    (void)bytes;
+    return first == ((crcblock *)mem)->expect ? 1 : -1;
+}
+
+static const core_plugin plugin_crcblock = {
+    CORE_PLUGIN_ABI, "crcblock",    crcblock_describe, crcblock_sizing,
+    crcblock_init,   crcblock_bench, crcblock_validate
+};
+
+/* Variable: plugin_builtin
+        Plugins built into the harness.
+*/
+static const core_plugin *plugin_builtin[] = { &plugin_crcblock };
+
+static const core_plugin *plugins[MAX_PLUGINS];
+static ee_u32             num_plugins;
+
+/* Function: plugin_check
+        Check that a plugin has the expected ABI and all its callbacks.
+*/
+static ee_u8
+plugin_check(const core_plugin *p)
+{
+    return (p->abi == CORE_PLUGIN_ABI) && p->name && p->describe && p->sizing
+           && p->init && p->bench && p->validate;
+}
+
+/* Function: core_plugin_register
+        Register a plugin, e.g. from a program linked with the library.
+
+        Returns:
+        0 on success, 1 if the plugin is invalid or the registry is full.
+*/
+ee_s16
+core_plugin_register(const core_plugin *p)
+{
+    if (!plugin_check(p))
+    {
+        ee_printf("ERROR! Plugin %s does not match ABI version %d\n",
+                  p->name ? p->name : "(null)",
+                  CORE_PLUGIN_ABI);
+        return 1;
+    }
+    if (num_plugins == MAX_PLUGINS)
+        return 1;
+    plugins[num_plugins++] = p;
+    return 0;
+}
+
+/* Function: plugin_register_builtin
+        Register the built-in plugins, once.
+*/
+static void
+plugin_register_builtin(void)
+{
+    static ee_u8 done;
+    ee_u32       i;
+    if (done)
+        return;
+    done = 1;
+    for (i = 0; i < sizeof(plugin_builtin) / sizeof(plugin_builtin[0]); i++)
+        core_plugin_register(plugin_builtin[i]);
+}
+
+/* Function: plugin_find
+        Find a registered plugin by name, or load it if the name is the path
+   of a shared object.
+*/
+static const core_plugin *
+plugin_find(const char *name)
+{
+    ee_u32 i;
+    plugin_register_builtin();
+    for (i = 0; i < num_plugins; i++)
+    {
+        if (strcmp(plugins[i]->name, name) == 0)
+            return plugins[i];
+    }
+#if PLUGIN_DLOPEN
+    if (strchr(name, '/') != NULL)
+    {
+        void *             lib = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+        const core_plugin *p;
+        if (lib == NULL)
+        {
+            ee_printf("ERROR! Cannot load plugin %s: %s\n", name, dlerror());
+            return NULL;
+        }
+        /* the library stays loaded until exit */
+        p = (const core_plugin *)dlsym(lib, "coremark_plugin");
+        if (p == NULL)
+        {
+            ee_printf("ERROR! %s does not export coremark_plugin\n", name);
+            dlclose(lib);
+            return NULL;
+        }
+        if (core_plugin_register(p) != 0)
+        {
+            dlclose(lib);
+            return NULL;
+        }
+        return p;
+    }
+#endif
+    ee_printf("ERROR! Unknown plugin %s, see --list-plugins\n", name);
+    return NULL;
+}
+
+/* Function: core_plugins_list
+        Print the registered plugins.
+*/
+void
+core_plugins_list(void)
+{
+    ee_u32 i;
+    plugin_register_builtin();
+    for (i = 0; i < num_plugins; i++)
+        ee_printf("%-16s %s\n", plugins[i]->name, plugins[i]->describe());
+}
+
+/* Function: plugin_iterate
+        Run iterations of a plugin.
+
+        Returns:
+        Crc of the results, the result of the first iteration in <first>.
+*/
+static ee_u16
+plugin_iterate(const core_plugin *p,
+               void *             mem,
+               ee_u32             bytes,
+               ee_u32             iterations,
+               ee_u16 *           first)
+{
+    ee_u16 crc = 0;
+    ee_u32 i;
+    for (i = 0; i < iterations; i++)
+    {
+        ee_u16 r = p->bench(mem, bytes);
+        if (i == 0)
+            *first = r;
+        crc = crcu16(r, crc);
+    }
+    return crc;
+}
+
+/* Structure: core_plugin_ctx
+        A plugin with its memory, initialized for a run.
+*/
+struct CORE_PLUGIN_CTX_S
+{
+    const core_plugin *p;
+    void *             mem;
+    ee_u32             bytes;
+};
+
+/* Function: core_plugin_open
+        Find a plugin, allocate its memory and initialize it with the seeds
+   and size per algorithm of the run in <res>.
+
+        Returns:
+        The plugin, NULL on error.
+*/
+core_plugin_ctx *
+core_plugin_open(const char *name, const core_results *res)
+{
+    const core_plugin *p = plugin_find(name);
+    core_plugin_ctx *  c;
+    if (p == NULL)
+        return NULL;
+    c = (core_plugin_ctx *)portable_malloc(sizeof(core_plugin_ctx));
+    if (c == NULL)
+        return NULL;
+    c->p     = p;
+    c->bytes = p->sizing(res->size);
+    c->mem   = portable_malloc(c->bytes);
+    if (c->mem == NULL)
+    {
+        ee_printf("ERROR! Plugin %s: cannot allocate %u bytes\n",
+                  p->name,
+                  c->bytes);
+        portable_free(c);
+        return NULL;
+    }
+    if (p->init(c->mem, c->bytes, res->seed1, res->seed2, res->seed3) != 0)
+    {
+        ee_printf("ERROR! Plugin %s: init failed\n", p->name);
+        core_plugin_close(c);
+        return NULL;
+    }
+    return c;
+}
+
+/* Function: core_plugin_close
+        Free a plugin opened with <core_plugin_open>.
+*/
+void
+core_plugin_close(core_plugin_ctx *c)
+{
+    portable_free(c->mem);
+    portable_free(c);
+}
+
+/* Function: core_plugin_sample
+        Time <n> iterations of a plugin, for the samples of result files.
+
+        Returns:
+        Iterations per second, 0 if the first result fails validation.
+*/
+secs_ret
+core_plugin_sample(core_plugin_ctx *c, ee_u32 n)
+{
+    secs_ret start = portable_time(), secs;
+    ee_u16   first = 0;
+    plugin_iterate(c->p, c->mem, c->bytes, n, &first);
+    secs = portable_time() - start;
+    if (c->p->validate(c->mem, c->bytes, first) < 0)
+    {
+        ee_printf("ERROR! Plugin %s failed validation\n", c->p->name);
+        return 0;
+    }
+    return n / secs;
+}
+
+/* Function: plugin_run
+        Calibrate, time and validate one plugin.
+
+        Returns:
+        1 if validation failed, 0 otherwise.
+*/
+static ee_s16
+plugin_run(core_plugin_ctx *c, ee_u32 target_ms)
+{
+    const core_plugin *p          = c->p;
+    ee_u32             iterations = 1;
+    ee_u16             first      = 0, crc;
+    ee_s16             valid;
+    secs_ret           t, secs = 0;
+    const char *       status;
+
+    /* grow the iterations until a run takes a tenth of the target */
+    for (;;)
+    {
+        t = portable_time();
+        plugin_iterate(p, c->mem, c->bytes, iterations, &first);
+        secs = portable_time() - t;
+        if ((secs * 10000 >= target_ms) || (iterations >= 0x40000000))
+            break;
+        iterations *= 2;
+    }
+    if (secs > 0)
+    {
+        secs_ret n = iterations * ((secs_ret)target_ms / 1000) / secs;
+        iterations = n < (secs_ret)0x40000000 ? (ee_u32)n + 1 : 0x40000000;
+    }
+    t    = portable_time();
+    crc  = plugin_iterate(p, c->mem, c->bytes, iterations, &first);
+    secs = portable_time() - t;
+
+    valid  = p->validate(c->mem, c->bytes, first);
+    status = valid > 0 ? "valid" : valid < 0 ? "ERROR" : "unknown";
+    ee_printf("Plugin %-10s: %lu iterations, %f secs, %f iter/sec, "
+              "crc 0x%04x, %s\n",
+              p->name,
+              (long unsigned)iterations,
+              secs,
+              secs > 0 ? iterations / secs : 0,
+              crc,
+              status);
+    return valid < 0;
+}
+
+/* Function: core_plugins_run
+        Run the plugins listed in <names>, separated by ',', with the seeds
+   and size per algorithm of the run in <res>.
+
+        Returns:
+        Number of plugins that failed.
+*/
+ee_s16
+core_plugins_run(const char *names, core_results *res, ee_u32 target_ms)
+{
+    char   name[256];
+    ee_s16 failed = 0;
+    if (target_ms == 0)
+        target_ms = PLUGIN_DEFAULT_MS;
+    while (*names)
+    {
+        core_plugin_ctx *c;
+        ee_u32           n = 0;
+        while (names[n] && names[n] != ',')
+            n++;
+        if (n < sizeof(name))
+        {
+            memcpy(name, names, n);
+            name[n] = 0;
+            c       = core_plugin_open(name, res);
+            if (c == NULL)
+                failed++;
+            else
+            {
+                failed += plugin_run(c, target_ms);
+                core_plugin_close(c);
+            }
+        }
+        else
+            failed++;
+        names += names[n] ? n + 1 : n;
+    }
+    return failed;
+}
+#endif /* PLUGIN_RUN */
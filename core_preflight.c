@@ -0,0 +1,252 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Pre-flight check.
+
+        A miscompiled kernel or a faulty core only shows as "Errors detected"
+        at the end of a run, after the calibration and the timed run. The
+        pre-flight runs untimed iterations (one by default) on all the
+        contexts at the same time, as the timed run does, right after the data is
+        initialized, and checks:
+        - the crcs of the first iteration of each context, against the same
+        crcs as the final check: the known crcs, or for other seeds the
+        reference crcs of <REFERENCE_RUN> if they are in its cache. Computing
+        them takes far longer than the pre-flight at large sizes. Without
+        either, only the next check is made.
+        - the crc of all the iterations, the same on all the contexts. With
+        a single context and neither of the above, nothing is checked, and
+        the pre-flight says so.
+
+        On an error, the diagnosis lists the wrong crcs of each context, then
+        runs each kernel alone on fresh data against the reference
+        implementation, to tell a wrong kernel from a wrong context, and the
+        run stops. Otherwise the data of each context is put back as it was,
+        see <core_restore_data>.
+*/
+#if PREFLIGHT_RUN
+#include <string.h>
+
+static const char *preflight_names[NUM_ALGORITHMS]
+    = { "list", "matrix", "state" };
+
+/* Function: preflight_contexts
+        Run <iterations> on each context, all at the same time.
+*/
+static void
+preflight_contexts(core_results *res, ee_u32 num_ctx, ee_u32 iterations)
+{
+    ee_u32 i;
+    for (i = 0; i < num_ctx; i++)
+    {
+        res[i].iterations = iterations;
+        res[i].execs      = res[0].execs;
+    }
+#if (MULTITHREAD > 1)
+    for (i = 0; i < num_ctx; i++)
+        core_start_parallel(&res[i]);
+    for (i = 0; i < num_ctx; i++)
+        core_stop_parallel(&res[i]);
+#else
+    iterate(&res[0]);
+#endif
+}
+
+#if REFERENCE_RUN
+/* Function: preflight_kernels
+        Run each kernel alone on fresh data, with <res> as the configuration
+        of the run, and compare with the reference implementation.
+*/
+static void
+preflight_kernels(const core_results *res)
+{
+    core_results t;
+    core_ref *   r;
+    ee_u32       bytes[NUM_ALGORITHMS], offset[NUM_ALGORITHMS] = { 0, 0, 0 };
+    ee_u32       k, i;
+    ee_u16       crc = 0, ref = 0;
+    ee_u8        wrong;
+
+    ee_printf("Kernel check     :");
+    for (i = 0; i < 0x1000; i++)
+    {
+        crc = KERNEL_CRCU16((ee_u16)(i * 0x9e37), crc);
+        ref = core_ref_crcu16((ee_u16)(i * 0x9e37), ref);
+    }
+    ee_printf(" crc %s", crc == ref ? "ok" : "WRONG");
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        if (!(res->execs & (1 << k)))
+            continue;
+        memset(&t, 0, sizeof(t));
+        memset(bytes, 0, sizeof(bytes));
+        t.seed1 = res->seed1;
+        t.seed2 = res->seed2;
+        t.seed3 = res->seed3;
+        t.execs = 1 << k; /* the kernel alone */
+        t.size  = res->size;
+        bytes[k] = res->size;
+        r        = core_ref_new(&t, bytes, offset, res->size);
+        /* wider matrix types take up to twice their size */
+        t.memblock[k + 1] = portable_malloc(2 * res->size + 64);
+        if (r == NULL || t.memblock[k + 1] == NULL)
+        {
+            ee_printf(", %s n/a", preflight_names[k]);
+            if (r != NULL)
+                core_ref_free(r);
+            if (t.memblock[k + 1] != NULL)
+                portable_free(t.memblock[k + 1]);
+            continue;
+        }
+        /* zeros after the data, as the reference has */
+        memset(t.memblock[k + 1], 0, 2 * res->size + 64);
+        wrong = 0;
+        switch (k)
+        {
+            case 0:
+                /* the sort by <cmp_complex> would run the other kernels
+                 * through <calc_func>, so only the sort by index runs */
+                t.list = core_list_init(res->size, t.memblock[1], t.seed1);
+                for (i = 0; i < 4 && !wrong; i++)
+                    wrong = core_bench_list(&t, -1) != core_ref_list(r, -1);
+                break;
+            case 1:
+                core_init_matrix(res->size,
+                                 t.memblock[2],
+                                 (ee_s32)t.seed1 | (((ee_s32)t.seed2) << 16),
+                                 &t.mat);
+                for (i = 0; i < 16 && !wrong; i++)
+                    wrong = core_bench_matrix(&t.mat, (ee_s16)(i * 0x11), 0)
+                            != core_ref_matrix(r, (ee_s16)(i * 0x11), 0);
+                break;
+            default:
+                core_init_state(res->size, t.seed1, t.memblock[3]);
+                for (i = 2; i < 16 && !wrong; i++)
+                    wrong = core_bench_state(res->size,
+                                             t.memblock[3],
+                                             t.seed1,
+                                             t.seed2,
+                                             (ee_s16)(i * 0x11),
+                                             0)
+                            != core_ref_state(r, (ee_s16)(i * 0x11), 0);
+                break;
+        }
+        ee_printf(", %s %s", preflight_names[k], wrong ? "WRONG" : "ok");
+        core_ref_free(r);
+        portable_free(t.memblock[k + 1]);
+    }
+    ee_printf("\n");
+}
+#endif
+
+/* Function: core_preflight
+        Check a few untimed iterations on all the contexts before a run.
+
+        Parameters:
+        res - contexts, with their data initialized.
+        num_ctx - number of contexts.
+        iterations - iterations of each context.
+        cache - reference cache file, see <core_reference_crcs>.
+
+        Returns:
+        0 if the contexts are correct, the number of errors otherwise.
+*/
+ee_s16
+core_preflight(core_results *res,
+               ee_u32        num_ctx,
+               ee_u32        iterations,
+               const char *  cache)
+{
+    ee_u16      want[NUM_ALGORITHMS], got[NUM_ALGORITHMS], seedcrc;
+    ee_s16      known_id, errors = 0;
+    ee_u32      i, k, saved = res[0].iterations;
+    void *      data[MULTITHREAD];
+    const char *source = NULL;
+    secs_ret    start  = portable_time();
+
+    known_id = core_known_id(&res[0], &seedcrc);
+    if (known_id >= 0)
+    {
+        core_known_crcs(known_id, want);
+        source = "the known crcs";
+    }
+#if REFERENCE_RUN
+    else if (core_reference_cached(&res[0], cache, want))
+        source = "the reference crcs";
+#else
+    (void)cache;
+#endif
+    for (i = 0; i < num_ctx; i++)
+        data[i] = core_save_data(&res[i]);
+    preflight_contexts(res, num_ctx, iterations);
+    for (i = 0; i < num_ctx; i++)
+    {
+        got[0] = res[i].crclist;
+        got[1] = res[i].crcmatrix;
+        got[2] = res[i].crcstate;
+        for (k = 0; k < NUM_ALGORITHMS && source != NULL; k++)
+        {
+            if ((res[0].execs & (1 << k)) && got[k] != want[k])
+            {
+                ee_printf("[%u]ERROR! Pre-flight %s crc 0x%04x - should be "
+                          "0x%04x from %s\n",
+                          i,
+                          preflight_names[k],
+                          got[k],
+                          want[k],
+                          source);
+                errors++;
+            }
+        }
+        if (res[i].crc != res[0].crc)
+        {
+            ee_printf("[%u]ERROR! Pre-flight crc of %u iterations 0x%04x - "
+                      "context 0 has 0x%04x\n",
+                      i,
+                      iterations,
+                      res[i].crc,
+                      res[0].crc);
+            errors++;
+        }
+    }
+    for (i = 0; i < num_ctx; i++)
+    {
+        res[i].iterations = saved;
+        core_restore_data(&res[i], data[i]);
+    }
+    if (errors)
+    {
+#if REFERENCE_RUN
+        preflight_kernels(&res[0]);
+#endif
+        ee_printf("Pre-flight failed, the run is not started.\n");
+        return errors;
+    }
+    if (source == NULL && num_ctx > 1)
+        source = "context 0";
+    ee_printf("Pre-flight       : %u contexts x %u iterations in %.1f ms, ",
+              num_ctx,
+              iterations,
+              (portable_time() - start) * 1000);
+    if (source != NULL)
+        ee_printf("checked against %s\n", source);
+    else
+        ee_printf("nothing checked (no known or cached crcs)\n");
+    return 0;
+}
+#endif /* PREFLIGHT_RUN */
@@ -0,0 +1,874 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Reference results.
+
+        The crcs of a run are only known for the five configurations of
+        <core_known_id>. For any other seeds, size or algorithms, they are
+        computed by a reference implementation of the algorithms, written to
+        be easy to check rather than fast, that shares no code with the
+        benchmarked kernels:
+        - the list is an array of the data items in list order, so finding,
+        reversing, moving and removing items are array operations, and the
+        sort is a bottom-up merge of runs of the array. The comparisons are
+        made in the order of <core_list_mergesort>, as those of <calc_func>
+        have side effects.
+        - the state machine is a function from a state and an input character
+        to the next state, and the transitions are counted from the states
+        before and after.
+        - the crc is computed bit by bit with the reflected polynomial 0xA001.
+
+        The matrix and state data are laid out in a block at the same offsets
+        as in the block of a run, as the algorithms share that block.
+
+        One iteration gives the crcs of a configuration. They are kept in a
+        cache file, one configuration per line, so a configuration is only
+        computed once.
+*/
+#if REFERENCE_RUN
+#include <stdio.h>
+#include <string.h>
+
+#define REFERENCE_LINE_LEN 160
+#define REFERENCE_SLACK    64 /* zero bytes after the block */
+
+#ifndef HAS_FLOAT
+#define ref_clip(x, y) ((y) ? (x)&0x0ff : (x)&0x0ffff)
+#define ref_big(x)     (0xf000 | (x))
+#else
+#define ref_clip(x, y) (x)
+#define ref_big(x)     (x)
+#endif
+
+struct CORE_REF_S
+{
+    ee_s16  seed1, seed2, seed3;
+    ee_u32  execs;   /* algorithms the list may run through <ref_calc> */
+    ee_u32  n;       /* items of the list, head and tail included */
+    ee_u32 *order;   /* item at each position of the list */
+    ee_u32 *merged;  /* merge buffer */
+    ee_s16 *idx;     /* of each item */
+    ee_s16 *data16;  /* of each item */
+    ee_u8 * block;   /* matrix and state data */
+    ee_u32  N;       /* matrix dimension */
+    MATDAT *A, *B;
+    MATRES *C;
+    ee_u8 * state;   /* state machine input */
+    ee_u32  state_size;
+    ee_u16  crc, crcmatrix, crcstate;
+};
+
+/* Function: core_ref_crcu16
+        Reference crc of a 16 bit value, computed bit by bit.
+*/
+ee_u16
+core_ref_crcu16(ee_u16 val, ee_u16 crc)
+{
+    ee_u32 bit;
+    for (bit = 0; bit < 16; bit++)
+    {
+        crc = (crc >> 1) ^ (((crc ^ val) & 1) ? 0xA001 : 0);
+        val >>= 1;
+    }
+    return crc;
+}
+
+static ee_u16
+ref_crcu32(ee_u32 val, ee_u16 crc)
+{
+    crc = core_ref_crcu16((ee_u16)val, crc);
+    return core_ref_crcu16((ee_u16)(val >> 16), crc);
+}
+
+/* Function: ref_next
+        Next state of the state machine on input <c>.
+*/
+static ee_u8
+ref_next(ee_u8 state, ee_u8 c)
+{
+    ee_u8 digit = c >= '0' && c <= '9';
+    ee_u8 sign  = c == '+' || c == '-';
+    switch (state)
+    {
+        case CORE_START:
+            return digit  ? CORE_INT
+                   : sign ? CORE_S1
+                   : c == '.' ? CORE_FLOAT
+                              : CORE_INVALID;
+        case CORE_S1:
+            return digit ? CORE_INT : c == '.' ? CORE_FLOAT : CORE_INVALID;
+        case CORE_INT:
+            return digit ? CORE_INT : c == '.' ? CORE_FLOAT : CORE_INVALID;
+        case CORE_FLOAT:
+            return digit                  ? CORE_FLOAT
+                   : c == 'e' || c == 'E' ? CORE_S2
+                                          : CORE_INVALID;
+        case CORE_S2:
+            return sign ? CORE_EXPONENT : CORE_INVALID;
+        case CORE_EXPONENT:
+        case CORE_SCIENTIFIC:
+            return digit ? CORE_SCIENTIFIC : CORE_INVALID;
+        default:
+            return CORE_INVALID;
+    }
+}
+
+/* Function: ref_scan
+        Run the state machine over the comma separated tokens of <s>.
+
+        Operation:
+        A token ends at a comma, which is consumed, at the end of the input,
+        or right after the character that makes it invalid. The start state
+        counts every character, and an invalid one also as invalid. Other
+        states count the characters that change the state, the scientific
+        state counting as invalid.
+*/
+static void
+ref_scan(const ee_u8 *s, ee_u32 *final, ee_u32 *track)
+{
+    while (*s)
+    {
+        ee_u8 state = CORE_START, next;
+        while (*s && state != CORE_INVALID)
+        {
+            ee_u8 c = *s++;
+            if (c == ',')
+                break;
+            next = ref_next(state, c);
+            if (state == CORE_START)
+            {
+                track[CORE_START]++;
+                if (next == CORE_INVALID)
+                    track[CORE_INVALID]++;
+            }
+            else if (next != state)
+                track[state == CORE_SCIENTIFIC ? CORE_INVALID : state]++;
+            state = next;
+        }
+        final[state]++;
+    }
+}
+
+/* Function: core_ref_state
+        Reference of <core_bench_state>.
+*/
+ee_u16
+core_ref_state(core_ref *r, ee_s16 step, ee_u16 crc)
+{
+    ee_u32 final[NUM_CORE_STATES], track[NUM_CORE_STATES], i;
+
+    memset(final, 0, sizeof(final));
+    memset(track, 0, sizeof(track));
+    ref_scan(r->state, final, track);
+    for (i = 0; i < r->state_size; i += step)
+    {
+        if (r->state[i] != ',')
+            r->state[i] ^= (ee_u8)r->seed1;
+    }
+    ref_scan(r->state, final, track);
+    for (i = 0; i < r->state_size; i += step)
+    {
+        if (r->state[i] != ',')
+            r->state[i] ^= (ee_u8)r->seed2;
+    }
+    for (i = 0; i < NUM_CORE_STATES; i++)
+    {
+        crc = ref_crcu32(final[i], crc);
+        crc = ref_crcu32(track[i], crc);
+    }
+    return crc;
+}
+
+/* Function: ref_init_state
+        Comma separated tokens chosen from the seed, as <core_init_state>,
+   then zeros up to <size>.
+*/
+static void
+ref_init_state(ee_u8 *p, ee_u32 size, ee_s16 seed)
+{
+    static const char *pat[4][4]
+        = { { "5012", "1234", "-874", "+122" },
+            { "35.54400", ".1234500", "-110.700", "+0.64400" },
+            { "5.500e+3", "-.123e-2", "-87e+832", "+0.6e-12" },
+            { "T0.3e-1F", "-T.T++Tq", "1T3.4e4z", "34.0e-T^" } };
+    /* kind of token for each value of the low 3 bits of the seed */
+    static const ee_u8 kind[8] = { 0, 0, 0, 1, 1, 2, 2, 3 };
+    ee_u32      total = 0, len;
+    const char *tok;
+
+    memset(p, 0, size);
+    for (;;)
+    {
+        seed++;
+        tok = pat[kind[seed & 7]][(seed >> 3) & 3];
+        len = (ee_u32)strlen(tok);
+        /* a token and its comma must leave the last byte free */
+        if (total + len + 1 >= size - 1)
+            break;
+        memcpy(p + total, tok, len);
+        p[total + len] = ',';
+        total += len + 1;
+    }
+}
+
+/* Function: ref_init_matrix
+        Matrices A and B from the seed, as <core_init_matrix>.
+*/
+static void
+ref_init_matrix(core_ref *r, void *memblk, ee_u32 blksize)
+{
+    ee_s32 seed  = (ee_s32)r->seed1 | (((ee_s32)r->seed2) << 16);
+    ee_s32 order = 1;
+    ee_u32 i;
+    MATDAT val;
+
+    /* largest N with 8 N^2 under the size */
+    r->N = 0;
+    while (8 * (r->N + 1) * (r->N + 1) < blksize)
+        r->N++;
+    r->A = (MATDAT *)align_mem(memblk);
+    r->B = r->A + r->N * r->N;
+    r->C = (MATRES *)align_mem(r->B + r->N * r->N);
+    if (seed == 0)
+        seed = 1;
+    for (i = 0; i < r->N * r->N; i++, order++)
+    {
+        seed    = (order * seed) % 65536;
+        val     = ref_clip((MATDAT)(seed + order), 0);
+        r->B[i] = val;
+        r->A[i] = ref_clip((MATDAT)(val + order), 1);
+    }
+}
+
+/* Function: ref_sum
+        Reference of <matrix_sum>.
+*/
+static ee_s16
+ref_sum(core_ref *r, MATDAT clipval)
+{
+    MATRES tmp = 0, prev = 0;
+    ee_s16 ret = 0;
+    ee_u32 i;
+    for (i = 0; i < r->N * r->N; i++)
+    {
+        tmp += r->C[i];
+        if (tmp > clipval)
+        {
+            ret += 10;
+            tmp = 0;
+        }
+        else if (r->C[i] > prev)
+            ret += 1;
+        prev = r->C[i];
+    }
+    return ret;
+}
+
+/* Function: core_ref_matrix
+        Reference of <core_bench_matrix>.
+*/
+ee_u16
+core_ref_matrix(core_ref *r, ee_s16 seed, ee_u16 crc)
+{
+    ee_u32  N = r->N, i, j, k;
+    MATDAT  val = (MATDAT)seed, clipval = ref_big(val);
+    MATDAT *A = r->A, *B = r->B;
+    MATRES *C = r->C;
+    ee_u16  sums = 0;
+
+    for (i = 0; i < N * N; i++)
+        A[i] += val;
+    /* A times val */
+    for (i = 0; i < N * N; i++)
+        C[i] = (MATRES)A[i] * (MATRES)val;
+    sums = core_ref_crcu16((ee_u16)ref_sum(r, clipval), sums);
+    /* A times the first row of B, the rest of C is kept */
+    for (i = 0; i < N; i++)
+    {
+        C[i] = 0;
+        for (j = 0; j < N; j++)
+            C[i] += (MATRES)A[i * N + j] * (MATRES)B[j];
+    }
+    sums = core_ref_crcu16((ee_u16)ref_sum(r, clipval), sums);
+    /* A times B */
+    for (i = 0; i < N; i++)
+    {
+        for (j = 0; j < N; j++)
+        {
+            C[i * N + j] = 0;
+            for (k = 0; k < N; k++)
+                C[i * N + j] += (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+        }
+    }
+    sums = core_ref_crcu16((ee_u16)ref_sum(r, clipval), sums);
+    /* the bit extraction product is not accumulated: C is cleared */
+    for (i = 0; i < N * N; i++)
+        C[i] = 0;
+    sums = core_ref_crcu16((ee_u16)ref_sum(r, clipval), sums);
+    for (i = 0; i < N * N; i++)
+        A[i] -= val;
+    return core_ref_crcu16(sums, crc);
+}
+
+/* Function: ref_calc
+        Reference of <calc_func> on item <k>: the cached value, or the value
+   computed by the algorithm its data selects, then cached.
+*/
+static ee_s16
+ref_calc(core_ref *r, ee_u32 k)
+{
+    ee_s16 data  = r->data16[k];
+    ee_s16 dtype = (data >> 3) & 0xf;
+    ee_s16 v;
+
+    if (data & 0x80)
+        return data & 0x7f;
+    dtype |= dtype << 4;
+    if ((data & 7) == 0 && (r->execs & ID_STATE))
+    {
+        v = (ee_s16)core_ref_state(r, dtype < 0x22 ? 0x22 : dtype, r->crc);
+        if (r->crcstate == 0)
+            r->crcstate = v;
+    }
+    else if ((data & 7) == 1 && (r->execs & ID_MATRIX))
+    {
+        v = (ee_s16)core_ref_matrix(r, dtype, r->crc);
+        if (r->crcmatrix == 0)
+            r->crcmatrix = v;
+    }
+    else
+        v = data;
+    r->crc = core_ref_crcu16((ee_u16)v, r->crc);
+    v &= 0x7f;
+    r->data16[k] = (data & 0xff00) | 0x80 | v;
+    return v;
+}
+
+/* Function: ref_cmp
+        Compare items <a> and <b>, by index, regenerating their data, or by
+   the value of <ref_calc>.
+*/
+static ee_s32
+ref_cmp(core_ref *r, ee_u32 a, ee_u32 b, ee_u8 by_idx)
+{
+    ee_s16 va, vb;
+    if (by_idx)
+    {
+        r->data16[a] = (r->data16[a] & 0xff00) | ((r->data16[a] >> 8) & 0xff);
+        r->data16[b] = (r->data16[b] & 0xff00) | ((r->data16[b] >> 8) & 0xff);
+        return r->idx[a] - r->idx[b];
+    }
+    va = ref_calc(r, a);
+    vb = ref_calc(r, b);
+    return va - vb;
+}
+
+/* Function: ref_sort
+        Stable bottom-up merge sort of the list, merging runs of 1, 2, 4...
+   items until a single merge covers the list.
+*/
+static void
+ref_sort(core_ref *r, ee_u8 by_idx)
+{
+    ee_u32 *o = r->order, width, lo, mid, hi, i, j, k;
+    for (width = 1;; width *= 2)
+    {
+        for (lo = 0; lo < r->n; lo += 2 * width)
+        {
+            mid = lo + width < r->n ? lo + width : r->n;
+            hi  = mid + width < r->n ? mid + width : r->n;
+            for (i = lo, j = mid, k = lo; k < hi; k++)
+            {
+                if (j == hi
+                    || (i < mid && ref_cmp(r, o[i], o[j], by_idx) <= 0))
+                    r->merged[k] = o[i++];
+                else
+                    r->merged[k] = o[j++];
+            }
+        }
+        memcpy(o, r->merged, r->n * sizeof(ee_u32));
+        if (2 * width >= r->n)
+            break;
+    }
+}
+
+/* Function: ref_find
+        Position of the first item with index <idx> if it is not negative,
+   else with the low byte of the data equal to <data>, -1 if none.
+*/
+static ee_s32
+ref_find(core_ref *r, ee_s16 idx, ee_s16 data)
+{
+    ee_u32 p;
+    for (p = 0; p < r->n; p++)
+    {
+        if (idx >= 0 ? r->idx[r->order[p]] == idx
+                     : (r->data16[r->order[p]] & 0xff) == data)
+            return (ee_s32)p;
+    }
+    return -1;
+}
+
+/* Function: ref_move
+        Move the item at position <from> to position <to>.
+*/
+static void
+ref_move(core_ref *r, ee_u32 from, ee_u32 to)
+{
+    ee_u32 item = r->order[from];
+    if (from > to)
+        memmove(r->order + to + 1,
+                r->order + to,
+                (from - to) * sizeof(ee_u32));
+    else
+        memmove(r->order + from,
+                r->order + from + 1,
+                (to - from) * sizeof(ee_u32));
+    r->order[to] = item;
+}
+
+/* Function: core_ref_list
+        Reference of <core_bench_list>.
+*/
+ee_u16
+core_ref_list(core_ref *r, ee_s16 finder_idx)
+{
+    ee_u16 retval = 0, found = 0, missed = 0;
+    ee_s16 i, idx = finder_idx, data = 0;
+    ee_s32 at;
+    ee_u32 p, removed;
+
+    for (i = 0; i < r->seed3; i++)
+    {
+        data = i & 0xff;
+        at   = ref_find(r, idx, data);
+        /* reverse the list */
+        for (p = 0; p < r->n / 2; p++)
+        {
+            ee_u32 t               = r->order[p];
+            r->order[p]            = r->order[r->n - 1 - p];
+            r->order[r->n - 1 - p] = t;
+        }
+        if (at < 0)
+        {
+            missed++;
+            retval += (r->data16[r->order[1]] >> 8) & 1;
+        }
+        else
+        {
+            found++;
+            p = r->n - 1 - (ee_u32)at; /* where the reverse put it */
+            if (r->data16[r->order[p]] & 1)
+                retval += (r->data16[r->order[p]] >> 9) & 1;
+            /* the item after the found one moves right after the first */
+            if (p + 1 < r->n)
+                ref_move(r, p + 1, 1);
+        }
+        if (idx >= 0)
+            idx++;
+    }
+    retval += found * 4 - missed;
+    if (finder_idx > 0)
+        ref_sort(r, 0);
+    /* take out the second item, crc from the found item to the end */
+    removed = r->order[1];
+    ref_move(r, 1, r->n - 1);
+    r->n--;
+    at = ref_find(r, idx, data);
+    for (p = at < 0 ? 1 : (ee_u32)at; p < r->n; p++)
+        retval = core_ref_crcu16((ee_u16)r->data16[r->order[0]], retval);
+    /* put it back, and sort by index to restore the list */
+    r->order[r->n++] = removed;
+    ref_move(r, r->n - 1, 1);
+    ref_sort(r, 1);
+    for (p = 1; p < r->n; p++)
+        retval = core_ref_crcu16((ee_u16)r->data16[r->order[0]], retval);
+    return retval;
+}
+
+/* Function: ref_init_list
+        The list of <core_list_init>: a head, the items that fit in
+   <blksize>, a tail, indexed and sorted by index.
+*/
+static void
+ref_init_list(core_ref *r, ee_u32 blksize)
+{
+    ee_u32 size  = blksize / (16 + sizeof(struct list_data_s)) - 2;
+    ee_u32 items = size - 3, i, p;
+
+    r->n         = items + 2;
+    r->idx[0]    = 0x0000;
+    r->data16[0] = (ee_s16)0x8080;
+    r->idx[1]    = 0x7fff;
+    r->data16[1] = (ee_s16)0xffff;
+    for (i = 0; i < items; i++)
+    {
+        ee_u16 dat = (((ee_u16)(r->seed1 ^ i) & 0xf) << 3) | (i & 7);
+        r->data16[i + 2] = (ee_s16)((dat << 8) | dat);
+    }
+    /* each item is inserted right after the head */
+    r->order[0]        = 0;
+    r->order[r->n - 1] = 1;
+    for (p = 1; p <= items; p++)
+        r->order[p] = items + 2 - p;
+    /* the first fifth of the list in order, the rest pseudo random */
+    for (p = 1, i = 1; p < r->n - 1; p++, i++)
+    {
+        if (i < size / 5)
+            r->idx[r->order[p]] = (ee_s16)i;
+        else
+            r->idx[r->order[p]] = 0x3fff
+                                  & ((((i + 1) & 7) << 8)
+                                     | (ee_u16)(i ^ r->seed1));
+    }
+    ref_sort(r, 1);
+}
+
+/* Function: core_ref_new
+        Initialize the reference data of a configuration.
+
+        Parameters:
+        res - seeds, and algorithms the list runs through <calc_func>.
+        bytes - size given to the init of each algorithm, 0 if not used.
+        offset - offset of the data of each algorithm in the block.
+        total - size of the block.
+
+        Returns:
+        The reference data, NULL if it cannot be allocated or the list is
+   too small.
+*/
+core_ref *
+core_ref_new(const core_results *res,
+             const ee_u32 *      bytes,
+             const ee_u32 *      offset,
+             ee_u32              total)
+{
+    core_ref *r;
+    ee_u32    n = 2, end = total;
+
+    if (bytes[0])
+    {
+        /* an item besides the head and tail, for <core_list_remove> */
+        if (bytes[0] < 6 * (16 + sizeof(struct list_data_s)))
+            return NULL;
+        n = bytes[0] / (16 + sizeof(struct list_data_s)) - 3;
+    }
+    r = (core_ref *)portable_malloc(sizeof(core_ref));
+    if (r == NULL)
+        return NULL;
+    memset(r, 0, sizeof(core_ref));
+    r->seed1  = res->seed1;
+    r->seed2  = res->seed2;
+    r->seed3  = res->seed3;
+    r->execs  = res->execs;
+    r->order  = (ee_u32 *)portable_malloc(2 * n * sizeof(ee_u32));
+    r->idx    = (ee_s16 *)portable_malloc(2 * n * sizeof(ee_s16));
+    /* the matrices may take more than their part of the block */
+    if (bytes[1])
+    {
+        ee_u32 N = 0;
+        while (8 * (N + 1) * (N + 1) < bytes[1])
+            N++;
+        if (offset[1] + N * N * (2 * sizeof(MATDAT) + sizeof(MATRES)) + 8
+            > end)
+            end = offset[1] + N * N * (2 * sizeof(MATDAT) + sizeof(MATRES))
+                  + 8;
+    }
+    r->block = (ee_u8 *)portable_malloc(end + REFERENCE_SLACK);
+    if (r->order == NULL || r->idx == NULL || r->block == NULL)
+    {
+        core_ref_free(r);
+        return NULL;
+    }
+    r->merged = r->order + n;
+    r->data16 = r->idx + n;
+    memset(r->block, 0, end + REFERENCE_SLACK);
+    if (bytes[0])
+        ref_init_list(r, bytes[0]);
+    if (bytes[1])
+        ref_init_matrix(r, r->block + offset[1], bytes[1]);
+    if (bytes[2])
+    {
+        r->state      = r->block + offset[2];
+        r->state_size = bytes[2];
+        ref_init_state(r->state, bytes[2], r->seed1);
+    }
+    return r;
+}
+
+/* Function: core_ref_free
+        Free the reference data.
+*/
+void
+core_ref_free(core_ref *r)
+{
+    if (r->order != NULL)
+        portable_free(r->order);
+    if (r->idx != NULL)
+        portable_free(r->idx);
+    if (r->block != NULL)
+        portable_free(r->block);
+    portable_free(r);
+}
+
+/* Function: ref_cache_key
+        Fields identifying a configuration in the cache: the seeds, the size
+   of each algorithm, the algorithms and the sizes of the matrix types.
+*/
+static void
+ref_cache_key(const core_results *res, ee_u32 *key)
+{
+    key[0] = (ee_u16)res->seed1;
+    key[1] = (ee_u16)res->seed2;
+    key[2] = (ee_u16)res->seed3;
+    key[3] = res->size;
+    key[4] = res->execs;
+    key[5] = sizeof(MATDAT);
+    key[6] = sizeof(MATRES);
+}
+
+/* Function: ref_cache_find
+        Look up the crcs of a configuration in the cache file.
+
+        Returns:
+        1 if found, 0 otherwise.
+*/
+static ee_s16
+ref_cache_find(const char *file, const ee_u32 *key, ee_u16 *crcs)
+{
+    FILE *       f = fopen(file, "r");
+    char         line[REFERENCE_LINE_LEN];
+    unsigned int v[10];
+    ee_u32       k;
+
+    if (f == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line,
+                   "%x %x %x %u %u %u:%u %x %x %x",
+                   &v[0],
+                   &v[1],
+                   &v[2],
+                   &v[3],
+                   &v[4],
+                   &v[5],
+                   &v[6],
+                   &v[7],
+                   &v[8],
+                   &v[9])
+            != 10)
+            continue;
+        for (k = 0; k < 7 && v[k] == key[k]; k++)
+            ;
+        if (k == 7)
+        {
+            crcs[0] = (ee_u16)v[7];
+            crcs[1] = (ee_u16)v[8];
+            crcs[2] = (ee_u16)v[9];
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Function: ref_cache_add
+        Append the crcs of a configuration to the cache file, with a header
+   line if the file is new.
+*/
+static void
+ref_cache_add(const char *file, const ee_u32 *key, const ee_u16 *crcs)
+{
+    FILE *f = fopen(file, "a");
+    if (f == NULL)
+    {
+        ee_printf("WARNING: Cannot write the reference cache %s\n", file);
+        return;
+    }
+    if (ftell(f) == 0)
+        fprintf(f,
+                "# seed1 seed2 seed3 size execs matdat:matres crclist "
+                "crcmatrix crcstate\n");
+    fprintf(f,
+            "%04x %04x %04x %u %u %u:%u %04x %04x %04x\n",
+            key[0],
+            key[1],
+            key[2],
+            key[3],
+            key[4],
+            key[5],
+            key[6],
+            crcs[0],
+            crcs[1],
+            crcs[2]);
+    fclose(f);
+}
+
+/* Function: core_reference_crcs
+        Reference crcs of a run: crclist, crcmatrix and crcstate of its first
+   iteration.
+
+        Parameters:
+        res - seeds, algorithms, and size of each algorithm, as set by
+   <core_init_data>.
+        cache - cache file, NULL or empty for none.
+        crcs - crclist, crcmatrix and crcstate.
+
+        Returns:
+        1 if found in the cache, 0 if computed, -1 if the configuration cannot
+   be computed (without the list, or a list too small).
+*/
+ee_s16
+core_reference_crcs(const core_results *res, const char *cache, ee_u16 *crcs)
+{
+    ee_u32    key[7], bytes[NUM_ALGORITHMS], offset[NUM_ALGORITHMS];
+    ee_u32    k, j = 0;
+    ee_u16    crc;
+    core_ref *r;
+
+    if (!(res->execs & ID_LIST))
+        return -1;
+    ref_cache_key(res, key);
+    if (cache != NULL && *cache && ref_cache_find(cache, key, crcs))
+        return 1;
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        bytes[k]  = (res->execs & (1 << k)) ? res->size : 0;
+        offset[k] = bytes[k] ? res->size * j++ : 0;
+    }
+    r = core_ref_new(res, bytes, offset, res->size * j);
+    if (r == NULL)
+        return -1;
+    /* one iteration of <iterate>, the list updates the crc as it runs */
+    crc     = core_ref_list(r, 1);
+    r->crc  = core_ref_crcu16(crc, r->crc);
+    crc     = core_ref_list(r, -1);
+    r->crc  = core_ref_crcu16(crc, r->crc);
+    crcs[0] = r->crc;
+    crcs[1] = r->crcmatrix;
+    crcs[2] = r->crcstate;
+    core_ref_free(r);
+    if (cache != NULL && *cache)
+        ref_cache_add(cache, key, crcs);
+    return 0;
+}
+
+/* Function: core_reference_cached
+        Reference crcs of a run from the cache only, without computing them,
+   see <core_reference_crcs>.
+
+        Returns:
+        1 if found in the cache, 0 otherwise.
+*/
+ee_s16
+core_reference_cached(const core_results *res, const char *cache, ee_u16 *crcs)
+{
+    ee_u32 key[7];
+    if (cache == NULL || *cache == 0)
+        return 0;
+    ref_cache_key(res, key);
+    return ref_cache_find(cache, key, crcs);
+}
+
+/* Function: core_reference_check
+        Compare the crcs of each context against the reference crcs.
+
+        Returns:
+        Number of errors found, -1 if the reference crcs cannot be computed.
+*/
+ee_s16
+core_reference_check(core_results *res, ee_u32 num_ctx, const char *cache)
+{
+    static const char *names[NUM_ALGORITHMS] = { "list", "matrix", "state" };
+    ee_u16             crcs[NUM_ALGORITHMS], got[NUM_ALGORITHMS];
+    ee_u32             i, k;
+    ee_s16             found, total_errors = 0;
+
+    found = core_reference_crcs(&res[0], cache, crcs);
+    if (found < 0)
+        return -1;
+    ee_printf("Reference crcs %s for these parameters.\n",
+              found ? "from the cache" : "computed");
+    for (i = 0; i < num_ctx; i++)
+    {
+        got[0]     = res[i].crclist;
+        got[1]     = res[i].crcmatrix;
+        got[2]     = res[i].crcstate;
+        res[i].err = 0;
+        for (k = 0; k < NUM_ALGORITHMS; k++)
+        {
+            if ((res[i].execs & (1 << k)) && got[k] != crcs[k])
+            {
+                ee_printf("[%u]ERROR! %s crc 0x%04x - should be 0x%04x\n",
+                          i,
+                          names[k],
+                          got[k],
+                          crcs[k]);
+                res[i].err++;
+            }
+        }
+        total_errors += res[i].err;
+    }
+    return total_errors;
+}
+
+/* Function: core_reference_run
+        Print the reference crcs of a configuration, without running the
+   benchmark.
+
+        Parameters:
+        res - seeds, algorithms and total size of the data block.
+        cache - cache file, NULL or empty for none.
+
+        Returns:
+        0 on success, 1 if the crcs cannot be computed.
+*/
+ee_s16
+core_reference_run(core_results *res, const char *cache)
+{
+    ee_u16 crcs[NUM_ALGORITHMS];
+    ee_u32 k, num_algorithms = 0;
+    ee_s16 found;
+
+    for (k = 0; k < NUM_ALGORITHMS; k++)
+    {
+        if (res->execs & (1 << k))
+            num_algorithms++;
+    }
+    res->size /= num_algorithms;
+    found = core_reference_crcs(res, cache, crcs);
+    if (found < 0)
+    {
+        ee_printf("ERROR! Cannot compute the reference crcs, the list is "
+                  "required\n");
+        return 1;
+    }
+    ee_printf("CoreMark Size    : %lu\n", (long unsigned)res->size);
+    ee_printf("Reference crcs   : %s\n", found ? "from the cache" : "computed");
+    if (res->execs & ID_LIST)
+        ee_printf("crclist          : 0x%04x\n", crcs[0]);
+    if (res->execs & ID_MATRIX)
+        ee_printf("crcmatrix        : 0x%04x\n", crcs[1]);
+    if (res->execs & ID_STATE)
+        ee_printf("crcstate         : 0x%04x\n", crcs[2]);
+    return 0;
+}
+#endif /* REFERENCE_RUN */
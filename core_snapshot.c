@@ -0,0 +1,311 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Snapshot and restore of the initialized data blocks.
+
+        At large sizes, <core_list_init> (with its full mergesort),
+        <core_init_matrix> and <core_init_state> take a noticeable time. With
+        --snapshot=<file>, the initialized memory block is written to a file
+        the first time, and mapped back by later runs with the same
+        configuration instead of being initialized again.
+
+        The snapshot is position independent: list pointers are stored as
+        offsets from the start of the memory block (plus one, so that NULL is
+        0), and are relocated when the file is mapped. The file is mapped
+        private, so the benchmark never writes back to it, and prefaulted
+        where supported, so that the page faults are taken by the load and
+        not by the first iteration. A checksum over
+        the data detects truncated or corrupted files, in which case the data
+        is initialized as usual and the snapshot is written again.
+*/
+#if SNAPSHOT_RUN
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SNAPSHOT_MAGIC   0x53534d43 /* "CMSS" */
+#define SNAPSHOT_VERSION 1
+/* data starts at this offset in the file, keeps the block aligned */
+#define SNAPSHOT_DATA_OFFSET 64
+#ifdef MAP_POPULATE
+#define SNAPSHOT_PREFAULT MAP_POPULATE
+#else
+#define SNAPSHOT_PREFAULT 0
+#endif
+
+typedef struct SNAPSHOT_HEADER_S
+{
+    ee_u32 magic;
+    ee_u32 version;
+    ee_u32 ptr_size;  /* sizeof(list_head) */
+    ee_u32 mat_size;  /* sizeof(MATDAT) | sizeof(MATRES) << 8 */
+    ee_s32 seed1;     /* configuration the data was initialized with */
+    ee_s32 seed2;
+    ee_u32 execs;
+    ee_u32 blksize;   /* size of the whole memory block */
+    ee_u32 size;      /* size per algorithm */
+    ee_u32 list;      /* offsets of the initialized structures */
+    ee_u32 mat_A;
+    ee_u32 mat_B;
+    ee_u32 mat_C;
+    ee_u32 mat_N;
+    ee_u32 checksum;  /* over the data following the header */
+} snapshot_header;
+
+/* mappings made by <core_snapshot_load>, released by <core_snapshot_release>
+ */
+static void * snapshot_map[MULTITHREAD];
+static size_t snapshot_map_len;
+
+/* Function: snapshot_checksum
+        FNV-1a hash of the data, cheap enough to be checked on every load.
+*/
+static ee_u32
+snapshot_checksum(const ee_u8 *p, ee_u32 len)
+{
+    ee_u32 h = 0x811c9dc5;
+    while (len--)
+    {
+        h ^= *p++;
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+/* Function: snapshot_fill_header
+        Fill in the configuration part of a snapshot header.
+*/
+static void
+snapshot_fill_header(snapshot_header *h, core_results *res, ee_u32 blksize)
+{
+    memset(h, 0, sizeof(*h));
+    h->magic    = SNAPSHOT_MAGIC;
+    h->version  = SNAPSHOT_VERSION;
+    h->ptr_size = sizeof(list_head);
+    h->mat_size = sizeof(MATDAT) | (sizeof(MATRES) << 8);
+    h->seed1    = res->seed1;
+    h->seed2    = res->seed2;
+    h->execs    = res->execs;
+    h->blksize  = blksize;
+}
+
+/* Function: core_snapshot_save
+        Write the initialized memory block of the first context to a snapshot
+   file. Must be called right after <core_init_data>, before the data is
+   modified by any iteration.
+
+        The file is written under a temporary name and renamed, so concurrent
+   runs never map a partial snapshot.
+
+        Returns:
+        1 on success, 0 otherwise.
+*/
+ee_u8
+core_snapshot_save(const char *filename, core_results *res, ee_u32 blksize)
+{
+    snapshot_header h;
+    char            tmpname[1024];
+    char *          base = (char *)res->memblock[0];
+    ee_u8 *         data;
+    list_head *     node;
+    FILE *          f;
+    size_t          ok;
+
+    data = (ee_u8 *)portable_malloc(blksize);
+    if (data == NULL)
+        return 0;
+    memcpy(data, base, blksize);
+    /* store list pointers as offsets in the copy */
+    if (res->execs & ID_LIST)
+    {
+        for (node = res->list; node; node = node->next)
+        {
+            list_head *copy
+                = (list_head *)(data + ((char *)node - base));
+            copy->next = (list_head *)(ee_ptr_int)(
+                node->next ? (char *)node->next - base + 1 : 0);
+            copy->info = (list_data *)(ee_ptr_int)(
+                (char *)node->info - base + 1);
+        }
+    }
+    snapshot_fill_header(&h, res, blksize);
+    h.size = res->size;
+    if (res->execs & ID_LIST)
+        h.list = (ee_u32)((char *)res->list - base);
+    if (res->execs & ID_MATRIX)
+    {
+        h.mat_A = (ee_u32)((char *)res->mat.A - base);
+        h.mat_B = (ee_u32)((char *)res->mat.B - base);
+        h.mat_C = (ee_u32)((char *)res->mat.C - base);
+        h.mat_N = res->mat.N;
+    }
+    h.checksum = snapshot_checksum(data, blksize);
+
+    snprintf(tmpname, sizeof(tmpname), "%s.%ld.tmp", filename, (long)getpid());
+    f = fopen(tmpname, "wb");
+    if (f == NULL)
+    {
+        ee_printf("ERROR! Cannot write snapshot %s\n", tmpname);
+        portable_free(data);
+        return 0;
+    }
+    ok = fwrite(&h, sizeof(h), 1, f);
+    ok = ok && (fseek(f, SNAPSHOT_DATA_OFFSET, SEEK_SET) == 0);
+    ok = ok && (fwrite(data, 1, blksize, f) == blksize);
+    ok = (fclose(f) == 0) && ok;
+    portable_free(data);
+    if (!ok || rename(tmpname, filename) != 0)
+    {
+        ee_printf("ERROR! Cannot write snapshot %s\n", filename);
+        remove(tmpname);
+        return 0;
+    }
+    return 1;
+}
+
+/* Function: core_snapshot_load
+        Map a snapshot file as the memory block of each context, instead of
+   initializing the data.
+
+        The configuration (seeds, sizes and algorithms) must already be set in
+   <res>, and must match the one stored in the file. On success, the memory
+   block allocated by the caller is freed and replaced by the mapping, and the
+   data pointers are set up as <core_init_data> would.
+
+        Returns:
+        1 if the data was restored, 0 if the caller must initialize it.
+*/
+ee_u8
+core_snapshot_load(const char *filename, core_results *res, ee_u32 num_ctx)
+{
+    snapshot_header want, *h;
+    struct stat     st;
+    ee_u32          blksize = res[0].size, i;
+    int             fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    if ((fstat(fd, &st) != 0)
+        || (st.st_size != (off_t)SNAPSHOT_DATA_OFFSET + blksize))
+    {
+        close(fd);
+        return 0;
+    }
+    snapshot_map_len = (size_t)st.st_size;
+    for (i = 0; i < num_ctx; i++)
+    {
+        /* private mapping, the benchmark modifies the data in place */
+        snapshot_map[i] = mmap(NULL,
+                               snapshot_map_len,
+                               PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | SNAPSHOT_PREFAULT,
+                               fd,
+                               0);
+        if (snapshot_map[i] == MAP_FAILED)
+        {
+            snapshot_map[i] = NULL;
+            break;
+        }
+    }
+    close(fd);
+    if (i < num_ctx)
+    {
+        core_snapshot_release(res, num_ctx);
+        return 0;
+    }
+
+    h = (snapshot_header *)snapshot_map[0];
+    snapshot_fill_header(&want, res, blksize);
+    if ((h->magic != want.magic) || (h->version != want.version)
+        || (h->ptr_size != want.ptr_size) || (h->mat_size != want.mat_size)
+        || (h->seed1 != want.seed1) || (h->seed2 != want.seed2)
+        || (h->execs != want.execs) || (h->blksize != want.blksize)
+        || (h->checksum
+            != snapshot_checksum((ee_u8 *)h + SNAPSHOT_DATA_OFFSET, blksize)))
+    {
+        core_snapshot_release(res, num_ctx);
+        return 0;
+    }
+
+    for (i = 0; i < num_ctx; i++)
+    {
+        char *     base = (char *)snapshot_map[i] + SNAPSHOT_DATA_OFFSET;
+        list_head *node;
+        ee_u32     algo, j = 0;
+
+        portable_free(res[i].memblock[0]);
+        res[i].memblock[0] = base;
+        res[i].size        = h->size;
+        for (algo = 0; algo < NUM_ALGORITHMS; algo++)
+        {
+            if ((1 << algo) & h->execs)
+                res[i].memblock[algo + 1] = base + h->size * j++;
+        }
+        if (h->execs & ID_LIST)
+        {
+            /* relocate the list */
+            res[i].list = (list_head *)(base + h->list);
+            for (node = res[i].list; node; node = node->next)
+            {
+                ee_ptr_int next = (ee_ptr_int)node->next;
+                node->info = (list_data *)(base + (ee_ptr_int)node->info - 1);
+                node->next = next ? (list_head *)(base + next - 1) : NULL;
+            }
+        }
+        if (h->execs & ID_MATRIX)
+        {
+            res[i].mat.A = (MATDAT *)(base + h->mat_A);
+            res[i].mat.B = (MATDAT *)(base + h->mat_B);
+            res[i].mat.C = (MATRES *)(base + h->mat_C);
+            res[i].mat.N = h->mat_N;
+        }
+    }
+    return 1;
+}
+
+/* Function: core_snapshot_release
+        Unmap the snapshot of each context.
+
+        Returns:
+        1 if the memory blocks were mapped from a snapshot (and must not be
+   freed by the caller), 0 otherwise.
+*/
+ee_u8
+core_snapshot_release(core_results *res, ee_u32 num_ctx)
+{
+    ee_u32 i;
+    ee_u8  mapped = 0;
+    for (i = 0; i < num_ctx; i++)
+    {
+        if (snapshot_map[i] != NULL)
+        {
+            if (res[i].memblock[0]
+                == (char *)snapshot_map[i] + SNAPSHOT_DATA_OFFSET)
+                mapped = 1;
+            munmap(snapshot_map[i], snapshot_map_len);
+            snapshot_map[i] = NULL;
+        }
+    }
+    return mapped;
+}
+#endif /* SNAPSHOT_RUN */
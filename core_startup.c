@@ -0,0 +1,485 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Startup latency.
+
+        With --startup, the time from exec to the first validated result is
+        broken down into phases: exec to main (loader, C library), then
+        <portable_init>, option parsing, memory allocation, the snapshot
+        load (with --snapshot), <core_list_init>, <core_init_matrix>,
+        <core_init_state>, <core_calibrate> (only when the iterations are
+        not given) and the first iteration, whose crcs are checked against
+        the known values.
+
+        The start of the process is the exec timestamp passed by the parent
+        in the environment (COREMARK_EXEC_TIME, in <portable_time> seconds),
+        or else <portable_process_age>, which is much coarser.
+
+        With --startup=<execs>, the program executes itself that many times
+        with --startup and the same seeds, after one warm-up exec that loads
+        the binary into the page cache and writes the snapshot if needed.
+        Each child writes its phases to a pipe (COREMARK_STARTUP_FD), and
+        the median, 90th percentile and maximum of each phase are reported.
+
+        The fast start path is a static build, a prefaulted snapshot of the
+        data and no calibration (iterations given), see startup_report in
+        the Makefile.
+*/
+#if STARTUP_RUN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define STARTUP_ENV_TIME  "COREMARK_EXEC_TIME"
+#define STARTUP_ENV_FD    "COREMARK_STARTUP_FD"
+#define STARTUP_MAX_EXECS 100000
+#define STARTUP_MAX_ARGS  64
+
+#define STARTUP_EXEC      0
+#define STARTUP_INIT      1
+#define STARTUP_OPTIONS   2
+#define STARTUP_MEMORY    3
+#define STARTUP_SNAPSHOT  4
+#define STARTUP_LIST      5
+#define STARTUP_MATRIX    6
+#define STARTUP_STATE     7
+#define STARTUP_CALIBRATE 8
+#define STARTUP_FIRST     9
+#define STARTUP_PHASES    10
+/* samples of an exec: the phases, the total and the time seen by the parent */
+#define STARTUP_TOTAL     STARTUP_PHASES
+#define STARTUP_WALL      (STARTUP_PHASES + 1)
+#define STARTUP_SAMPLES   (STARTUP_PHASES + 2)
+
+static const char *startup_names[STARTUP_SAMPLES]
+    = { "exec to main",     "portable_init",   "options",
+        "memory",           "snapshot",        "core_list_init",
+        "core_init_matrix", "core_init_state", "calibration",
+        "first iteration",  "exec to result",  "fork to exit" };
+
+/* Function: startup_init_data
+        Same as <core_init_data> for one context, with each init timed.
+*/
+static void
+startup_init_data(core_results *res, secs_ret *t)
+{
+    ee_u32   i, j = 0, num_algorithms = 0;
+    secs_ret start;
+
+    for (i = 0; i < NUM_ALGORITHMS; i++)
+    {
+        if ((1 << i) & res->execs)
+            num_algorithms++;
+    }
+    res->size = res->size / num_algorithms;
+    for (i = 0; i < NUM_ALGORITHMS; i++)
+    {
+        if ((1 << i) & res->execs)
+            res->memblock[i + 1] = (char *)res->memblock[0] + res->size * j++;
+    }
+    if (res->execs & ID_LIST)
+    {
+        start = portable_time();
+        res->list = core_list_init(res->size, res->memblock[1], res->seed1);
+        t[STARTUP_LIST] = portable_time() - start;
+    }
+    if (res->execs & ID_MATRIX)
+    {
+        start = portable_time();
+        core_init_matrix(res->size,
+                         res->memblock[2],
+                         (ee_s32)res->seed1 | (((ee_s32)res->seed2) << 16),
+                         &(res->mat));
+        t[STARTUP_MATRIX] = portable_time() - start;
+    }
+    if (res->execs & ID_STATE)
+    {
+        start = portable_time();
+        core_init_state(res->size, res->seed1, res->memblock[3]);
+        t[STARTUP_STATE] = portable_time() - start;
+    }
+}
+
+/* Function: startup_age
+        Time since the exec of the process, and where it comes from.
+
+        Returns:
+        The time in seconds, 0 if unknown.
+*/
+static secs_ret
+startup_age(const char **source)
+{
+    const char *exec_time = getenv(STARTUP_ENV_TIME);
+    secs_ret    age;
+
+    if (exec_time != NULL)
+    {
+        *source = "timestamp of the parent";
+        return portable_time() - (secs_ret)strtod(exec_time, NULL);
+    }
+    age     = portable_process_age();
+    *source = age > 0 ? "process start time (clock tick resolution)"
+                      : "unknown, from main";
+    return age;
+}
+
+/* Function: startup_once
+        Measure the startup of this process, report it, and write it to the
+   pipe of the parent if any.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+static ee_s16
+startup_once(core_results *res,
+             secs_ret      main_time,
+             secs_ret      init_time,
+             const char *  snapshot_file)
+{
+    secs_ret    t[STARTUP_SAMPLES], now = portable_time(), age, start,
+                                    total = 0;
+    const char *source, *fd = getenv(STARTUP_ENV_FD);
+    ee_u32      i, iterations = res->iterations;
+    ee_u16      seedcrc = 0;
+    ee_s16      known_id = -1, err = 0;
+    ee_u8       restored = 0;
+#if SNAPSHOT_RUN
+    ee_u32 blksize = res->size;
+#endif
+
+    for (i = 0; i < STARTUP_SAMPLES; i++)
+        t[i] = -1;
+    age = startup_age(&source);
+    if (age > 0)
+    {
+        /* the age was read now, main started earlier */
+        t[STARTUP_EXEC] = age - (now - main_time);
+        if (t[STARTUP_EXEC] < 0)
+            t[STARTUP_EXEC] = 0;
+    }
+    t[STARTUP_INIT]    = init_time - main_time;
+    t[STARTUP_OPTIONS] = now - init_time;
+
+    start             = portable_time();
+    res->memblock[0]  = portable_malloc(res->size);
+    t[STARTUP_MEMORY] = portable_time() - start;
+    if (res->memblock[0] == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate %u bytes\n", res->size);
+        return 1;
+    }
+#if SNAPSHOT_RUN
+    if (snapshot_file != NULL)
+    {
+        start               = portable_time();
+        restored            = core_snapshot_load(snapshot_file, res, 1);
+        t[STARTUP_SNAPSHOT] = portable_time() - start;
+    }
+#else
+    (void)snapshot_file;
+#endif
+    if (!restored)
+    {
+        startup_init_data(res, t);
+#if SNAPSHOT_RUN
+        /* first run: the snapshot is written for the next ones */
+        if (snapshot_file != NULL)
+        {
+            start = portable_time();
+            core_snapshot_save(snapshot_file, res, blksize);
+            t[STARTUP_SNAPSHOT] += portable_time() - start;
+        }
+#endif
+    }
+    if (iterations == 0)
+    {
+        start = portable_time();
+        core_calibrate(res);
+        t[STARTUP_CALIBRATE] = portable_time() - start;
+    }
+
+    start           = portable_time();
+    res->iterations = 1;
+    iterate(res);
+    known_id = core_known_id(res, &seedcrc);
+    if (known_id >= 0)
+        err = core_check_crcs(res, 1, known_id);
+    t[STARTUP_FIRST] = portable_time() - start;
+    res->iterations  = iterations;
+
+#if SNAPSHOT_RUN
+    if (!core_snapshot_release(res, 1))
+        portable_free(res->memblock[0]);
+#else
+    portable_free(res->memblock[0]);
+#endif
+
+    for (i = 0; i < STARTUP_PHASES; i++)
+    {
+        if (t[i] >= 0)
+            total += t[i];
+    }
+    t[STARTUP_TOTAL] = total;
+    if (fd != NULL)
+    {
+        char   line[STARTUP_SAMPLES * 24];
+        size_t len = 0;
+        for (i = 0; i < STARTUP_TOTAL + 1; i++)
+            len += snprintf(line + len, sizeof(line) - len, "%.9f ", t[i]);
+        len += snprintf(line + len, sizeof(line) - len, "%d\n", err);
+        if (write(atoi(fd), line, len) != (ssize_t)len)
+            err++;
+    }
+
+    ee_printf("Startup phase        Time (ms)  Since exec (ms)\n");
+    for (i = 0, total = 0; i < STARTUP_PHASES; i++)
+    {
+        if (t[i] < 0)
+        {
+            ee_printf("%-18s %11s\n", startup_names[i], "-");
+            continue;
+        }
+        total += t[i];
+        ee_printf("%-18s %11.3f %16.3f\n",
+                  startup_names[i],
+                  t[i] * 1000,
+                  total * 1000);
+    }
+    ee_printf("Process start    : %s\n", source);
+    ee_printf("First result     : %.3f ms, %s\n",
+              total * 1000,
+              err                ? "crc errors"
+              : (known_id < 0) ? "crcs cannot be validated"
+                                 : "crcs valid");
+    return err ? 1 : 0;
+}
+
+/* Function: startup_sort
+        Sort <n> values in place.
+*/
+static void
+startup_sort(secs_ret *v, ee_u32 n)
+{
+    ee_u32 i, j;
+    for (i = 1; i < n; i++)
+    {
+        secs_ret x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+}
+
+/* Function: startup_exec
+        Execute the program once with --startup, its output discarded.
+
+        Returns:
+        The samples of the child in <t>, and 0 if its first iteration was
+   valid, 1 if it had crc errors, -1 if it failed.
+*/
+static ee_s16
+startup_exec(char *argv[], secs_ret *t)
+{
+    char     line[STARTUP_SAMPLES * 24 + 16], *p, *end;
+    secs_ret start;
+    ee_u32   i;
+    size_t   len = 0;
+    ssize_t  n;
+    pid_t    pid;
+    int      fds[2], status;
+    long     err;
+
+    if (pipe(fds) != 0)
+        return -1;
+    fflush(stdout); /* do not duplicate buffered output in the child */
+    start = portable_time();
+    pid   = fork();
+    if (pid == 0)
+    {
+        char fd[16], now[32];
+        int  null = open("/dev/null", O_WRONLY);
+        close(fds[0]);
+        if (null >= 0)
+            dup2(null, 1);
+        snprintf(fd, sizeof(fd), "%d", fds[1]);
+        setenv(STARTUP_ENV_FD, fd, 1);
+        snprintf(now, sizeof(now), "%.9f", portable_time());
+        setenv(STARTUP_ENV_TIME, now, 1);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    close(fds[1]);
+    if (pid < 0)
+    {
+        close(fds[0]);
+        return -1;
+    }
+    while (len < sizeof(line) - 1
+           && ((n = read(fds[0], line + len, sizeof(line) - 1 - len)) > 0
+               || (n < 0 && errno == EINTR)))
+    {
+        if (n > 0)
+            len += (size_t)n;
+    }
+    close(fds[0]);
+    line[len] = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    t[STARTUP_WALL] = portable_time() - start;
+    if (!WIFEXITED(status))
+        return -1;
+
+    for (i = 0, p = line; i < STARTUP_TOTAL + 1; i++, p = end)
+    {
+        t[i] = (secs_ret)strtod(p, &end);
+        if (end == p)
+            return -1;
+    }
+    err = strtol(p, &end, 10);
+    if (end == p)
+        return -1;
+    return err ? 1 : 0;
+}
+
+/* Function: startup_execs
+        Measure the startup over <execs> executions of the program.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+static ee_s16
+startup_execs(ee_u32 execs, const char *snapshot_file, int argc, char *argv[])
+{
+    char      snapshot_arg[512], startup_arg[] = "--startup";
+    char *    args[STARTUP_MAX_ARGS];
+    secs_ret *samples, *v, t[STARTUP_SAMPLES];
+    ee_u32    i, k, n = 0, invalid = 0;
+    ee_s16    err = 0, ret;
+
+    if (execs > STARTUP_MAX_EXECS)
+        execs = STARTUP_MAX_EXECS;
+    if (argc + 3 > STARTUP_MAX_ARGS)
+    {
+        ee_printf("ERROR! Too many arguments\n");
+        return 1;
+    }
+    args[n++] = argv[0];
+    args[n++] = startup_arg;
+    if (snapshot_file != NULL)
+    {
+        snprintf(
+            snapshot_arg, sizeof(snapshot_arg), "--snapshot=%s", snapshot_file);
+        args[n++] = snapshot_arg;
+    }
+    for (i = 1; i < (ee_u32)argc; i++)
+        args[n++] = argv[i];
+    args[n] = NULL;
+
+    /* the samples of each exec, then the values of a phase to sort */
+    samples = (secs_ret *)portable_malloc(execs * (STARTUP_SAMPLES + 1)
+                                          * sizeof(secs_ret));
+    if (samples == NULL)
+    {
+        ee_printf("ERROR! Cannot allocate the samples\n");
+        return 1;
+    }
+    v = samples + execs * STARTUP_SAMPLES;
+    /* warm-up exec, not counted */
+    for (k = 0; k <= execs; k++)
+    {
+        ret = startup_exec(args, k ? samples + (k - 1) * STARTUP_SAMPLES : t);
+        if (ret < 0)
+        {
+            ee_printf("ERROR! Exec %u of %s failed\n", k, argv[0]);
+            err = 1;
+            break;
+        }
+        if (ret > 0 && k > 0)
+            invalid++;
+    }
+
+    if (!err)
+    {
+        ee_printf("Startup execs    : %u (after a warm-up exec)\n", execs);
+        ee_printf("Startup phase      Median (ms)    P90 (ms)    Max (ms)\n");
+        for (i = 0; i < STARTUP_SAMPLES; i++)
+        {
+            for (k = 0; k < execs; k++)
+                v[k] = samples[k * STARTUP_SAMPLES + i];
+            startup_sort(v, execs);
+            if (v[execs - 1] < 0)
+            {
+                ee_printf("%-18s %11s\n", startup_names[i], "-");
+                continue;
+            }
+            t[i] = (execs & 1) ? v[execs / 2]
+                               : (v[execs / 2 - 1] + v[execs / 2]) / 2;
+            ee_printf("%-18s %11.3f %11.3f %11.3f\n",
+                      startup_names[i],
+                      t[i] * 1000,
+                      v[(ee_u32)((execs - 1) * 0.9 + 0.5)] * 1000,
+                      v[execs - 1] * 1000);
+        }
+        ee_printf("Cold start       : %.3f ms from exec to the first "
+                  "validated result (median)\n",
+                  t[STARTUP_TOTAL] * 1000);
+        if (invalid)
+        {
+            ee_printf("ERROR! Crc errors in %u of %u execs\n", invalid, execs);
+            err = 1;
+        }
+    }
+    portable_free(samples);
+    return err;
+}
+
+/* Function: core_startup_run
+        Measure the startup of this process, or of <execs> executions of the
+   program.
+
+        Parameters:
+        res - seeds, iterations (0 to calibrate), algorithms and total size of
+   the data block.
+        main_time - <portable_time> at the start of main.
+        init_time - <portable_time> after <portable_init>.
+        execs - number of executions to measure, 0 for this process only.
+        snapshot_file - snapshot of the data, NULL to initialize it.
+        argc, argv - remaining arguments, the seeds.
+
+        Returns:
+        0 on success, 1 on error.
+*/
+ee_s16
+core_startup_run(core_results *res,
+                 secs_ret      main_time,
+                 secs_ret      init_time,
+                 ee_u32        execs,
+                 const char *  snapshot_file,
+                 int           argc,
+                 char *        argv[])
+{
+    if (execs > 0)
+        return startup_execs(execs, snapshot_file, argc, argv);
+    return startup_once(res, main_time, init_time, snapshot_file);
+}
+#endif /* STARTUP_RUN */
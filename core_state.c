@@ -17,8 +17,6 @@ Original Author: Shay Gal-on
 */
 
 #include "coremark.h"
-/* local functions */
-enum CORE_STATE core_state_transition(ee_u8 **instr, ee_u32 *transition_count);
 
 /*
 Topic: Description
@@ -65,7 +63,7 @@ core_bench_state(ee_u32 blksize,
     /* run the state machine over the input */
     while (*p != 0)
     {
-        enum CORE_STATE fstate = core_state_transition(&p, track_counts);
+        enum CORE_STATE fstate = KERNEL_STATE_TRANSITION(&p, track_counts);
         final_counts[fstate]++;
 #if CORE_DEBUG
         ee_printf("%d,", fstate);
@@ -77,6 +75,7 @@ core_bench_state(ee_u32 blksize,
     p = memblock;
     while (p < (memblock + blksize))
     { /* insert some corruption */
+        TRACE_STATE(p);
         if (*p != ',')
             *p ^= (ee_u8)seed1;
         p += step;
@@ -85,7 +84,7 @@ core_bench_state(ee_u32 blksize,
     /* run the state machine over the input again */
     while (*p != 0)
     {
-        enum CORE_STATE fstate = core_state_transition(&p, track_counts);
+        enum CORE_STATE fstate = KERNEL_STATE_TRANSITION(&p, track_counts);
         final_counts[fstate]++;
 #if CORE_DEBUG
         ee_printf("%d,", fstate);
@@ -97,6 +96,7 @@ core_bench_state(ee_u32 blksize,
     p = memblock;
     while (p < (memblock + blksize))
     { /* undo corruption is seed1 and seed2 are equal */
+        TRACE_STATE(p);
         if (*p != ',')
             *p ^= (ee_u8)seed2;
         p += step;
@@ -213,6 +213,7 @@ ee_isdigit(ee_u8 c)
    end state is returned (either specific format determined or invalid).
 */
 
+CORE_CLONES
 enum CORE_STATE
 core_state_transition(ee_u8 **instr, ee_u32 *transition_count)
 {
@@ -221,6 +222,7 @@ core_state_transition(ee_u8 **instr, ee_u32 *transition_count)
     enum CORE_STATE state = CORE_START;
     for (; *str && state != CORE_INVALID; str++)
     {
+        TRACE_STATE(str);
         NEXT_SYMBOL = *str;
         if (NEXT_SYMBOL == ',') /* end of this input */
         {
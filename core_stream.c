@@ -0,0 +1,309 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Streaming state machine benchmark.
+
+        Run <core_state_transition> over a corpus read from a file, which may
+        be much larger than memory. The file is read in chunks into two
+        buffers: a helper thread reads chunk N+1 with pread while chunk N is
+        parsed, so that I/O and parsing are pipelined.
+
+        Tokens are separated by ',' as in the data built by <core_init_state>.
+        Each chunk is parsed up to its last separator, and the partial token
+        at the end is carried over to the front of the next chunk, so the
+        result is the same as parsing the whole file at once. A token longer
+        than a chunk is split (and counted as such).
+
+        Reported:
+        - parse throughput (bytes / time spent in the state machine).
+        - end to end throughput.
+        - I/O overlap efficiency: the fraction of read time hidden behind
+        parsing, 1 - (time waiting for data / time reading).
+*/
+#if STREAM_RUN
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define STREAM_DEFAULT_CHUNK (1024 * 1024)
+
+#define STREAM_FREE 0 /* buffer may be filled by the reader */
+#define STREAM_FULL 1 /* buffer holds data to parse */
+
+typedef struct STREAM_BUF_S
+{
+    ee_u8 * mem;  /* carry area of <chunk> bytes, then the data */
+    ee_s32  len;  /* bytes read, 0 at end of file, -1 on error */
+    int     state;
+} stream_buf;
+
+typedef struct STREAM_READER_S
+{
+    int             fd;
+    ee_u32          chunk;
+    stream_buf      buf[2];
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    secs_ret        io_time; /* time spent in pread */
+    int             stop;
+} stream_reader;
+
+/* Function: stream_read_thread
+        Fill the buffers in turn with consecutive chunks of the file, until
+   end of file.
+*/
+static void *
+stream_read_thread(void *arg)
+{
+    stream_reader *r   = (stream_reader *)arg;
+    off_t          off = 0;
+    int            k;
+    for (k = 0;; k ^= 1)
+    {
+        stream_buf *b = &r->buf[k];
+        ssize_t     n = 0, got = 0;
+        secs_ret    t0;
+
+        pthread_mutex_lock(&r->lock);
+        while (b->state != STREAM_FREE && !r->stop)
+            pthread_cond_wait(&r->cond, &r->lock);
+        pthread_mutex_unlock(&r->lock);
+        if (r->stop)
+            break;
+
+        t0 = portable_time();
+        while (got < (ssize_t)r->chunk)
+        {
+            n = pread(r->fd, b->mem + r->chunk + got, r->chunk - got, off);
+            if (n <= 0)
+                break;
+            got += n;
+            off += n;
+        }
+#ifdef POSIX_FADV_DONTNEED
+        /* the corpus is read once, do not let it fill the page cache */
+        posix_fadvise(r->fd, off - got, got, POSIX_FADV_DONTNEED);
+#endif
+        r->io_time += portable_time() - t0;
+
+        pthread_mutex_lock(&r->lock);
+        b->len   = (n < 0 && got == 0) ? -1 : (ee_s32)got;
+        b->state = STREAM_FULL;
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+        if (got == 0)
+            break;
+    }
+    return NULL;
+}
+
+/* Function: stream_parse
+        Run the state machine over a NUL terminated region, skipping stray
+   NUL bytes.
+
+        Returns:
+        Number of tokens.
+*/
+static ee_u32
+stream_parse(ee_u8 *p, ee_u8 *end, ee_u32 *final_counts, ee_u32 *track_counts)
+{
+    ee_u32 tokens = 0;
+    while (p < end)
+    {
+        if (*p == 0)
+        {
+            p++;
+            continue;
+        }
+        final_counts[KERNEL_STATE_TRANSITION(&p, track_counts)]++;
+        tokens++;
+    }
+    return tokens;
+}
+
+/* Function: core_stream_run
+        Run the streaming state machine benchmark over a file.
+
+        Parameters:
+        filename - corpus to parse.
+        chunk - size of each read, 0 for the default (1MB).
+
+        Returns:
+        0 on success, 1 on error.
+*/
+ee_s16
+core_stream_run(const char *filename, ee_u32 chunk)
+{
+    stream_reader r;
+    pthread_t     thread;
+    ee_u32        final_counts[NUM_CORE_STATES];
+    ee_u32        track_counts[NUM_CORE_STATES];
+    unsigned long long bytes = 0, tokens = 0;
+    ee_u32        carry = 0, chunks = 0, splits = 0, i;
+    ee_u8 *       tail = NULL;
+    secs_ret      t_start, t_total, parse_time = 0, wait_time = 0;
+    ee_u16        crc = 0;
+    int           k, err = 0;
+
+    if (chunk == 0)
+        chunk = STREAM_DEFAULT_CHUNK;
+    memset(&r, 0, sizeof(r));
+    r.chunk = chunk;
+    r.fd    = open(filename, O_RDONLY);
+    if (r.fd < 0)
+    {
+        ee_printf("ERROR! Cannot open stream file %s\n", filename);
+        return 1;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(r.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    for (k = 0; k < 2; k++)
+    {
+        /* carry area + chunk + terminating NUL */
+        r.buf[k].mem = (ee_u8 *)portable_malloc(2 * (size_t)chunk + 1);
+        if (r.buf[k].mem == NULL)
+        {
+            ee_printf("ERROR! Cannot allocate stream buffers\n");
+            if (k)
+                portable_free(r.buf[0].mem);
+            close(r.fd);
+            return 1;
+        }
+    }
+    for (i = 0; i < NUM_CORE_STATES; i++)
+        final_counts[i] = track_counts[i] = 0;
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.cond, NULL);
+
+    t_start = portable_time();
+    pthread_create(&thread, NULL, stream_read_thread, &r);
+    for (k = 0;; k ^= 1)
+    {
+        stream_buf *b = &r.buf[k];
+        ee_u8 *     start, *end, *last;
+        secs_ret    t0 = portable_time();
+
+        pthread_mutex_lock(&r.lock);
+        while (b->state != STREAM_FULL)
+            pthread_cond_wait(&r.cond, &r.lock);
+        pthread_mutex_unlock(&r.lock);
+        wait_time += portable_time() - t0;
+        if (b->len < 0)
+        {
+            ee_printf("ERROR! Cannot read stream file %s\n", filename);
+            err = 1;
+            break;
+        }
+
+        /* move the partial token of the previous chunk in front of this one,
+         * then release the previous buffer to the reader */
+        start = b->mem + chunk - carry;
+        if (carry)
+            memcpy(start, tail, carry);
+        if (tail != NULL)
+        {
+            pthread_mutex_lock(&r.lock);
+            r.buf[k ^ 1].state = STREAM_FREE;
+            pthread_cond_broadcast(&r.cond);
+            pthread_mutex_unlock(&r.lock);
+        }
+
+        end = b->mem + chunk + b->len;
+        if (b->len == 0)
+            last = end; /* end of file, parse what is left */
+        else
+        {
+            for (last = end; last > start && last[-1] != ','; last--)
+                ;
+            if (end - last > (ee_s32)chunk)
+            {
+                last = end; /* token larger than a chunk, split it */
+                splits++;
+            }
+        }
+        carry = (ee_u32)(end - last);
+        tail  = last;
+
+        t0 = portable_time();
+        if (last > start)
+        {
+            ee_u8 save = *last;
+            *last      = 0;
+            tokens += stream_parse(start, last, final_counts, track_counts);
+            *last = save;
+        }
+        parse_time += portable_time() - t0;
+        bytes += b->len;
+        if (b->len == 0)
+            break;
+        chunks++;
+    }
+    pthread_mutex_lock(&r.lock);
+    r.stop = 1;
+    pthread_cond_broadcast(&r.cond);
+    pthread_mutex_unlock(&r.lock);
+    pthread_join(thread, NULL);
+    t_total = portable_time() - t_start;
+
+    for (i = 0; i < NUM_CORE_STATES; i++)
+    {
+        crc = crcu32(final_counts[i], crc);
+        crc = crcu32(track_counts[i], crc);
+    }
+    if (!err)
+    {
+        ee_printf("Stream file      : %s\n", filename);
+        ee_printf("Stream bytes     : %llu in %u chunks of %u\n",
+                  (unsigned long long)bytes,
+                  chunks,
+                  chunk);
+        ee_printf("Stream tokens    : %llu (int %u, float %u, sci %u, "
+                  "invalid %u, split %u)\n",
+                  (unsigned long long)tokens,
+                  final_counts[CORE_INT],
+                  final_counts[CORE_FLOAT],
+                  final_counts[CORE_SCIENTIFIC],
+                  final_counts[CORE_INVALID],
+                  splits);
+        ee_printf("Stream crc       : 0x%04x\n", crc);
+        ee_printf("Total time (secs): %f\n", t_total);
+        ee_printf("Parse time (secs): %f\n", parse_time);
+        ee_printf("I/O time (secs)  : %f\n", r.io_time);
+        ee_printf("I/O wait (secs)  : %f\n", wait_time);
+        if (parse_time > 0)
+            ee_printf("Parse MB/sec     : %f\n", bytes / parse_time / 1e6);
+        if (t_total > 0)
+            ee_printf("Total MB/sec     : %f\n", bytes / t_total / 1e6);
+        if (r.io_time > 0)
+            ee_printf("I/O overlap      : %.1f%%\n",
+                      wait_time < r.io_time
+                          ? 100 * (1 - wait_time / r.io_time)
+                          : 0.0);
+    }
+    pthread_cond_destroy(&r.cond);
+    pthread_mutex_destroy(&r.lock);
+    portable_free(r.buf[0].mem);
+    portable_free(r.buf[1].mem);
+    close(r.fd);
+    return (ee_s16)err;
+}
+#endif /* STREAM_RUN */
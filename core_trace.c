@@ -0,0 +1,194 @@
+/*
+Copyright 2018 Embedded Microprocessor Benchmark Consortium (EEMBC)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coremark.h"
+/*
+Topic: Description
+        Memory address trace capture.
+
+        In a <TRACE_RUN> build, the kernels record the addresses they
+        access with the TRACE_LIST, TRACE_MATRIX and TRACE_STATE macros.
+        Recording is enabled by <core_trace_start> for the timed run only.
+        Each thread records into a buffer of its own, allocated beforehand,
+        and the buffers are written to files by <core_trace_flush> after
+        the timed run.
+
+        A record is the difference to the previous address of the thread,
+        zigzag encoded so that small negative steps stay small, shifted left
+        by 2 with the kind of access (TRACE_KIND_*) in the low bits, then
+        written as a little endian base 128 varint. Most records take one
+        or two bytes. Recording stops when a buffer is full, and the file is
+        marked as truncated.
+
+        A trace file starts with the 8 byte magic "CMTRACE1", then 4 values
+        of 32 bits in host byte order: number of records, number of bytes of
+        records, 1 if truncated and the size of a pointer. The records
+        follow.
+*/
+#if TRACE_RUN
+#include <stdio.h>
+#include <string.h>
+
+#if (MULTITHREAD > 1) && !USE_PTHREAD
+#error "Traces of forked contexts are lost, use threads with TRACE_RUN"
+#endif
+
+#define TRACE_MAX_THREADS MULTITHREAD
+#define TRACE_MAX_RECORD  10 /* bytes of a 64 bit varint */
+
+typedef struct TRACE_BUFFER_S
+{
+    ee_u8 *    buf;
+    ee_u8 *    cur;
+    ee_u8 *    end;
+    ee_ptr_int last;
+    ee_u32     records;
+    ee_u8      truncated;
+} trace_buffer;
+
+ee_u8 core_trace_on;
+static trace_buffer             trace_buffers[TRACE_MAX_THREADS];
+static ee_u32                   trace_threads;
+static TRACE_TLS trace_buffer * trace_cur;
+
+/* Function: trace_attach
+        Give the calling thread the next free buffer.
+
+        Returns:
+        The buffer, NULL if there is none left.
+*/
+static trace_buffer *
+trace_attach(void)
+{
+    ee_u32 i = __sync_fetch_and_add(&trace_threads, 1);
+    return i < TRACE_MAX_THREADS ? &trace_buffers[i] : NULL;
+}
+
+/* Function: core_trace_record
+        Record an access, called by the TRACE_* macros while recording is
+   enabled.
+*/
+void
+core_trace_record(const void *addr, ee_u32 kind)
+{
+    trace_buffer *b = trace_cur;
+    ee_ptr_int    a = (ee_ptr_int)addr, d, v;
+
+    if (b == NULL)
+    {
+        b = trace_cur = trace_attach();
+        if (b == NULL)
+            return;
+    }
+    if (b->cur + TRACE_MAX_RECORD > b->end)
+    {
+        b->truncated = 1;
+        return;
+    }
+    d       = a - b->last;
+    b->last = a;
+    /* zigzag: 0, -1, 1, -2, ... to 0, 1, 2, 3, ... */
+    v = (d >> (sizeof(d) * 8 - 1)) ? ~(d << 1) : (d << 1);
+    v = (v << 2) | kind;
+    while (v >= 0x80)
+    {
+        *b->cur++ = (ee_u8)(v | 0x80);
+        v >>= 7;
+    }
+    *b->cur++ = (ee_u8)v;
+    b->records++;
+}
+
+/* Function: core_trace_start
+        Allocate the buffers and enable recording.
+
+        Returns:
+        0 on success, 1 if the buffers cannot be allocated.
+*/
+ee_s16
+core_trace_start(void)
+{
+    ee_u32 i;
+    for (i = 0; i < TRACE_MAX_THREADS; i++)
+    {
+        trace_buffer *b = &trace_buffers[i];
+        memset(b, 0, sizeof(*b));
+        b->buf = (ee_u8 *)portable_malloc(TRACE_BUFFER_SIZE);
+        if (b->buf == NULL)
+        {
+            ee_printf("ERROR! Cannot allocate the trace buffers\n");
+            while (i--)
+                portable_free(trace_buffers[i].buf);
+            return 1;
+        }
+        b->cur = b->buf;
+        b->end = b->buf + TRACE_BUFFER_SIZE;
+    }
+    trace_threads = 0;
+    core_trace_on = 1;
+    return 0;
+}
+
+/* Function: core_trace_flush
+        Disable recording, and write the buffer of each thread that recorded
+   to <filename>.<n>, then free the buffers.
+
+        Returns:
+        0 on success, 1 if a file cannot be written.
+*/
+ee_s16
+core_trace_flush(const char *filename)
+{
+    ee_u32 i, n = trace_threads;
+    ee_s16 err = 0;
+
+    core_trace_on = 0;
+    if (n > TRACE_MAX_THREADS)
+        n = TRACE_MAX_THREADS;
+    for (i = 0; i < n; i++)
+    {
+        trace_buffer *b = &trace_buffers[i];
+        char          name[512];
+        FILE *        fp;
+        ee_u32        header[4];
+
+        snprintf(name, sizeof(name), "%s.%u", filename, i);
+        header[0] = b->records;
+        header[1] = (ee_u32)(b->cur - b->buf);
+        header[2] = b->truncated;
+        header[3] = sizeof(void *);
+        fp        = fopen(name, "wb");
+        if (fp == NULL || fwrite("CMTRACE1", 1, 8, fp) != 8
+            || fwrite(header, sizeof(header), 1, fp) != 1
+            || fwrite(b->buf, 1, header[1], fp) != header[1])
+        {
+            ee_printf("ERROR! Cannot write trace %s\n", name);
+            err = 1;
+        }
+        else
+            ee_printf("Trace            : %u records, %u bytes in %s%s\n",
+                      header[0],
+                      header[1],
+                      name,
+                      b->truncated ? " (truncated, buffer full)" : "");
+        if (fp != NULL)
+            fclose(fp);
+    }
+    for (i = 0; i < TRACE_MAX_THREADS; i++)
+        portable_free(trace_buffers[i].buf);
+    return err;
+}
+#endif /* TRACE_RUN */
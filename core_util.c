@@ -125,6 +125,42 @@ get_seed_args(int i, int argc, char *argv[])
     return 0;
 }
 
+/* Function: get_option_arg
+        Find an option of the form "--name" or "--name=value" on the command
+   line, and remove it from the arguments, so that the positional seed
+   arguments keep their index.
+
+        Returns:
+        Pointer to the option value ("" if no value was given), or NULL if the
+   option is not present.
+*/
+char *
+get_option_arg(const char *name, int *argc, char *argv[])
+{
+    int i, j, len = 0;
+    while (name[len])
+        len++;
+    for (i = 1; i < *argc; i++)
+    {
+        char *arg = argv[i];
+        if ((arg[0] != '-') || (arg[1] != '-'))
+            continue;
+        for (j = 0; j < len && arg[2 + j] == name[j]; j++)
+            ;
+        if ((j < len) || ((arg[2 + len] != 0) && (arg[2 + len] != '=')))
+            continue;
+        arg += 2 + len;
+        if (*arg == '=')
+            arg++;
+        /* shift the remaining args */
+        for (j = i; j < *argc - 1; j++)
+            argv[j] = argv[j + 1];
+        (*argc)--;
+        return arg;
+    }
+    return NULL;
+}
+
 #elif (SEED_METHOD == SEED_FUNC)
 /* If using OS based function, you must define and implement the functions below
  * in core_portme.h and core_portme.c ! */
@@ -186,6 +222,7 @@ crcu8(ee_u8 data, ee_u16 crc)
     }
     return crc;
 }
+CORE_CLONES
 ee_u16
 crcu16(ee_u16 newval, ee_u16 crc)
 {
@@ -203,7 +240,7 @@ crcu32(ee_u32 newval, ee_u16 crc)
 ee_u16
 crc16(ee_s16 newval, ee_u16 crc)
 {
-    return crcu16((ee_u16)newval, crc);
+    return KERNEL_CRCU16((ee_u16)newval, crc);
 }
 
 ee_u8
@@ -62,9 +62,11 @@ typedef ee_u32 secs_ret;
 
 #if MAIN_HAS_NORETURN
 #define MAIN_RETURN_VAL
+#define MAIN_FAIL_VAL
 #define MAIN_RETURN_TYPE void
 #else
 #define MAIN_RETURN_VAL  0
+#define MAIN_FAIL_VAL    1
 #define MAIN_RETURN_TYPE int
 #endif
 
@@ -72,6 +74,77 @@ void       start_time(void);
 void       stop_time(void);
 CORE_TICKS get_time(void);
 secs_ret   time_in_secs(CORE_TICKS ticks);
+/* Free running time in seconds, provided by ports that support the run modes
+ * taking several measurements */
+secs_ret portable_time(void);
+/* CPU affinity of the calling thread, provided by ports that support the run
+ * modes pinning their work */
+ee_u32 portable_num_cpus(void);
+ee_u8  portable_set_affinity(ee_u32 cpu);
+
+/* Configuration: QUIET_SYSTEM
+        Define to 1 if the port supports a low noise run mode
+   (--quiet-system), e.g. real time scheduling, locked memory and pinned
+   contexts, applied by <portable_init>. <portable_quiet_print> reports the
+   settings in effect.
+*/
+#ifndef QUIET_SYSTEM
+#define QUIET_SYSTEM 0
+#endif
+#if QUIET_SYSTEM
+void portable_quiet_print(void);
+#endif
+
+/* Configuration: MULTIVERSION
+        Define to 1 to build the hot kernels (CORE_CLONES) once for each target
+   in MULTIVERSION_TARGETS with target_clones, so that one binary runs the
+   best version for the cpu it is loaded on. Ports that support it define
+   MULTIVERSION_TARGETS and <portable_clone_name>, which names the version
+   selected for the report.
+*/
+#ifndef MULTIVERSION
+#define MULTIVERSION 0
+#endif
+#if MULTIVERSION
+#define CORE_CLONES __attribute__((target_clones(MULTIVERSION_TARGETS)))
+const char *portable_clone_name(void);
+#else
+#define CORE_CLONES
+#endif
+
+/* Configuration: TRACE_RUN
+        Define to 1 to build the memory address trace mode (--trace=<file>):
+   the list node visits, matrix element accesses and state byte reads of the
+   reference kernels record their addresses, delta encoded, into a buffer of
+   TRACE_BUFFER_SIZE bytes per thread (TRACE_TLS storage). The buffers are
+   written to <file>.<thread> after the timed run, for the cache simulator
+   (make cachesim). Not for scoring, the recording slows the kernels down.
+*/
+#ifndef TRACE_RUN
+#define TRACE_RUN 0
+#endif
+#define TRACE_KIND_LIST   0
+#define TRACE_KIND_MATRIX 1
+#define TRACE_KIND_STATE  2
+#if TRACE_RUN
+#ifndef TRACE_TLS
+#define TRACE_TLS __thread
+#endif
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE (64 * 1024 * 1024)
+#endif
+extern ee_u8 core_trace_on;
+void         core_trace_record(const void *addr, ee_u32 kind);
+ee_s16       core_trace_start(void);
+ee_s16       core_trace_flush(const char *filename);
+#define TRACE_ACCESS(p, kind) \
+    (core_trace_on ? core_trace_record((p), (kind)) : (void)0)
+#else
+#define TRACE_ACCESS(p, kind) ((void)0)
+#endif
+#define TRACE_LIST(p)   TRACE_ACCESS(p, TRACE_KIND_LIST)
+#define TRACE_MATRIX(p) TRACE_ACCESS(p, TRACE_KIND_MATRIX)
+#define TRACE_STATE(p)  TRACE_ACCESS(p, TRACE_KIND_STATE)
 
 /* Misc useful functions */
 ee_u16 crcu8(ee_u8 data, ee_u16 crc);
@@ -164,12 +237,439 @@ ee_u8 core_start_parallel(core_results *res);
 ee_u8 core_stop_parallel(core_results *res);
 #endif
 
+/* Framework functions shared by the different run modes (core_run.c) */
+void       core_init_data(core_results *res, ee_u32 num_ctx);
+ee_u8      core_size_valid(ee_u32 size, ee_u32 execs);
+ee_u32     core_calibrate(core_results *res);
+CORE_TICKS core_run_contexts(core_results *res, ee_u32 num_ctx);
+void *     core_save_data(core_results *res);
+void       core_restore_data(core_results *res, void *saved);
+ee_s16     core_known_id(core_results *res, ee_u16 *seedcrc);
+ee_s16     core_check_crcs(core_results *res, ee_u32 num_ctx, ee_s16 known_id);
+void       core_known_crcs(ee_s16 known_id, ee_u16 *crcs);
+
+#if (SEED_METHOD == SEED_ARG)
+char *get_option_arg(const char *name, int *argc, char *argv[]);
+#endif
+
+/* Topic: Optional features
+        Unless stated otherwise, the configurations below default to 0. A
+   port enables in its core_portme.h those whose requirements it meets, as
+   linux64 does.
+*/
+
+/* Configuration: CORE_RUN_API
+        Define to 1 to provide <core_run>, the entry point of the embeddable
+   library (make lib). Requires <portable_time>.
+*/
+#ifndef CORE_RUN_API
+#define CORE_RUN_API 0
+#endif
+#if CORE_RUN_API
+/* Configuration of a library run */
+typedef struct CORE_RUN_CONFIG_S
+{
+    ee_s16 seed1;      /* same meaning as the command line seeds */
+    ee_s16 seed2;
+    ee_s16 seed3;
+    ee_u32 iterations; /* 0 to calibrate */
+    ee_u32 target_ms;  /* run time to calibrate for, 0 for 10 seconds */
+    ee_u32 execs;      /* algorithms to run (ID_LIST, ...), 0 for all */
+    void * memblock;   /* memory supplied by the caller */
+    ee_u32 size;       /* size of memblock, e.g. TOTAL_DATA_SIZE */
+} core_run_config;
+
+/* Results of a library run */
+typedef struct CORE_RUN_RESULT_S
+{
+    ee_u32   iterations;
+    secs_ret secs;
+    secs_ret iterations_per_sec;
+    ee_u16   seedcrc;
+    ee_u16   crclist;
+    ee_u16   crcmatrix;
+    ee_u16   crcstate;
+    ee_u16   crcfinal;
+    ee_s16   known_id; /* known configuration, -1 if it cannot be validated */
+    ee_s16   errors;   /* crcs that differ from the known values */
+} core_run_result;
+
+ee_s16 core_run(const core_run_config *cfg, core_run_result *out);
+#endif
+
+/* Configuration: BATCH_RUN
+        Define to 1 to support the multi-seed batch mode (--batch=<file>).
+   Requires seeds from the command line, malloc and stdio, and is enabled by
+   default when those are available.
+*/
+#ifndef BATCH_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && HAS_STDIO
+#define BATCH_RUN 1
+#else
+#define BATCH_RUN 0
+#endif
+#endif
+#if BATCH_RUN
+#define BATCH_FIELDS 5 /* seed1 seed2 seed3 size iterations */
+ee_s32 *core_batch_load(const char *filename, ee_u32 *num_rows, ee_u32 *max_size);
+ee_s16  core_batch_run(const char *  filename,
+                       core_results *res,
+                       ee_u32        num_ctx,
+                       const char *  cache);
+#endif
+
+/* Configuration: SNAPSHOT_RUN
+        Define to 1 to support snapshot and restore of the initialized data
+   blocks (--snapshot=<file>). Requires mmap.
+*/
+#ifndef SNAPSHOT_RUN
+#define SNAPSHOT_RUN 0
+#endif
+#if SNAPSHOT_RUN
+ee_u8 core_snapshot_save(const char *filename, core_results *res, ee_u32 blksize);
+ee_u8 core_snapshot_load(const char *filename, core_results *res, ee_u32 num_ctx);
+ee_u8 core_snapshot_release(core_results *res, ee_u32 num_ctx);
+#endif
+
+/* Configuration: STREAM_RUN
+        Define to 1 to support the streaming state machine benchmark
+   (--stream=<file>). Requires pthreads and pread.
+*/
+#ifndef STREAM_RUN
+#define STREAM_RUN 0
+#endif
+#if STREAM_RUN
+ee_s16 core_stream_run(const char *filename, ee_u32 chunk);
+#endif
+
+/* Configuration: PIPELINE_RUN
+        Define to 1 to support the pipelined execution mode (--pipeline), with
+   the state, list and matrix kernels as stages on separate cores. Requires
+   pthreads and cpu affinity.
+*/
+#ifndef PIPELINE_RUN
+#define PIPELINE_RUN 0
+#endif
+#if PIPELINE_RUN
+ee_s16 core_pipeline_run(core_results *res, ee_u32 records, const char *cpus);
+#endif
+
+/* Configuration: ALIGN_SWEEP
+        Define to 1 to support the data alignment sweep (--align-sweep), which
+   runs <core_run> with the data block at offsets across a cache line and a
+   page. Requires <CORE_RUN_API>.
+*/
+#ifndef ALIGN_SWEEP
+#define ALIGN_SWEEP 0
+#endif
+#if ALIGN_SWEEP
+ee_s16 core_align_sweep(core_results *res, ee_u32 repeats);
+#endif
+
+/* Configuration: AB_RUN
+        Define to 1 to support the interleaved A/B comparison (--ab-a, --ab-b)
+   of two kernel configurations or two library builds. Requires
+   <CORE_RUN_API>, and <PLUGIN_DLOPEN> to load library builds.
+*/
+#ifndef AB_RUN
+#define AB_RUN 0
+#endif
+#if AB_RUN
+ee_s16 core_ab_run(core_results *res,
+                   const char *  spec_a,
+                   const char *  spec_b,
+                   ee_u32        pairs,
+                   ee_u32        slice_ms,
+                   ee_u32        cpu);
+#endif
+
+/* Configuration: COMPARE_RUN
+        Define to 1 to support result files (--json) and the comparison with
+   a stored baseline (--compare), with <portable_fingerprint> naming the
+   host. Requires <CORE_RUN_API>.
+*/
+#ifndef COMPARE_RUN
+#define COMPARE_RUN 0
+#endif
+#if COMPARE_RUN
+void   portable_fingerprint(char *buf, ee_u32 len);
+ee_s16 core_compare_run(core_results *res,
+                        const char *  json_file,
+                        const char *  baseline,
+                        ee_u32        samples,
+                        ee_u32        sample_ms,
+                        const char *  threshold,
+                        const char *  plugins);
+#endif
+
+/* Configuration: COUNT_RUN
+        Define to 1 to support the instruction count mode (--count), which
+   reports what the port counts in the timed section of each kernel. Ports
+   that support it provide an ee_u64 type, <portable_count_open> and
+   <portable_counts>, and count in <start_time> and <stop_time>.
+*/
+#ifndef COUNT_RUN
+#define COUNT_RUN 0
+#endif
+#if COUNT_RUN
+/* Counts of a timed section */
+typedef struct CORE_COUNTS_S
+{
+    ee_u64      instructions; /* retired in user mode */
+    const char *source;       /* what counted them */
+} core_counts;
+
+ee_s16 portable_count_open(void);
+ee_s16 portable_counts(const char *name, core_counts *counts);
+ee_s16 core_count_run(core_results *res,
+                      const char *  budget_file,
+                      const char *  save_file,
+                      const char *  tolerance);
+#endif
+
+/* Configuration: CGROUP_AWARE
+        Define to 1 to size the parallel contexts to the cpus the cgroup of
+   the process allows, and to mark runs that the cgroup cpu quota throttled
+   as invalid. Ports that support it provide <portable_cgroup_section>,
+   called around the timed run of the score, and <portable_cgroup_check>.
+*/
+#ifndef CGROUP_AWARE
+#define CGROUP_AWARE 0
+#endif
+#if CGROUP_AWARE
+void   portable_cgroup_section(ee_u8 start);
+ee_s16 portable_cgroup_check(void);
+#endif
+
+/* Configuration: HYBRID_RUN
+        Define to 1 to support heterogeneous cores: the core types are
+   reported by regular runs on hybrid processors, and the hybrid mode
+   (--hybrid) scores each class of cpus and the static and dynamic
+   distribution of iterations over all cpus. Ports that support it provide
+   <portable_core_types>. Requires <CORE_RUN_API>, pthreads and
+   <portable_set_affinity>.
+*/
+#ifndef HYBRID_RUN
+#define HYBRID_RUN 0
+#endif
+#if HYBRID_RUN
+#define HYBRID_MAX_TYPES 4
+ee_u32 portable_core_types(ee_u8 *type, ee_u32 n, const char **names);
+void   core_hybrid_print(void);
+ee_s16 core_hybrid_run(core_results *res, ee_u32 ms);
+#endif
+
+/* Configuration: CPUMAP_RUN
+        Define to 1 to support the per cpu score map (--cpu-map), which runs
+   one context pinned to each cpu in turn and flags the outliers. Requires
+   <CORE_RUN_API>, pthreads and <portable_set_affinity>.
+*/
+#ifndef CPUMAP_RUN
+#define CPUMAP_RUN 0
+#endif
+#if CPUMAP_RUN
+ee_s16 core_cpumap_run(core_results *res,
+                       const char *  list,
+                       ee_u32        group,
+                       ee_u32        ms,
+                       ee_u32        repeats,
+                       const char *  csv_file);
+#endif
+
+/* Configuration: DAEMON_RUN
+        Define to 1 to support the metrics exporter daemon mode (--daemon),
+   which probes the benchmark with <core_run> every interval and serves the
+   metrics in the Prometheus text format. Ports that support it provide
+   <portable_background> and <portable_cpu_mhz>. Requires <CORE_RUN_API>,
+   sockets and signals.
+*/
+#ifndef DAEMON_RUN
+#define DAEMON_RUN 0
+#endif
+#if DAEMON_RUN
+ee_s16   portable_background(ee_u32 budget, const char *cgroup);
+secs_ret portable_cpu_mhz(void);
+ee_s16   core_daemon_run(core_results *res,
+                         const char *  addr,
+                         const char *  file,
+                         ee_u32        interval,
+                         ee_u32        probe_ms,
+                         ee_u32        budget,
+                         const char *  cgroup);
+#endif
+
+/* Configuration: STARTUP_RUN
+        Define to 1 to support the startup latency mode (--startup), which
+   breaks down the time from exec to the first validated iteration, and
+   repeats it over many execs (--startup=<execs>). Ports that support it
+   provide <portable_process_age>. Requires fork and exec.
+*/
+#ifndef STARTUP_RUN
+#define STARTUP_RUN 0
+#endif
+#if STARTUP_RUN
+secs_ret portable_process_age(void);
+ee_s16   core_startup_run(core_results *res,
+                          secs_ret      main_time,
+                          secs_ret      init_time,
+                          ee_u32        execs,
+                          const char *  snapshot_file,
+                          int           argc,
+                          char *        argv[]);
+#endif
+
+/* Configuration: MIX_RUN
+        Define to 1 to support the work mix (--mix=<list>:<matrix>:<state>),
+   with the size of each algorithm (--mix-sizes) and its share of the time
+   set explicitly, and crcs computed for each configuration. Requires
+   <portable_time>.
+*/
+#ifndef MIX_RUN
+#define MIX_RUN 0
+#endif
+#if MIX_RUN
+ee_s16 core_mix_run(core_results *res, char *weights, char *sizes, ee_u32 ms);
+#endif
+
+/* Configuration: REFERENCE_RUN
+        Define to 1 to validate configurations that are not in the table of
+   known crcs against a reference implementation of the algorithms, with the
+   crcs of each configuration kept in a cache file (--reference-cache), and
+   to print them (--reference). Requires malloc and stdio.
+*/
+#ifndef REFERENCE_RUN
+#define REFERENCE_RUN 0
+#endif
+#if REFERENCE_RUN
+typedef struct CORE_REF_S core_ref;
+core_ref *core_ref_new(const core_results *res,
+                       const ee_u32 *      bytes,
+                       const ee_u32 *      offset,
+                       ee_u32              total);
+void      core_ref_free(core_ref *r);
+ee_u16    core_ref_list(core_ref *r, ee_s16 finder_idx);
+ee_u16    core_ref_matrix(core_ref *r, ee_s16 seed, ee_u16 crc);
+ee_u16    core_ref_state(core_ref *r, ee_s16 step, ee_u16 crc);
+ee_u16    core_ref_crcu16(ee_u16 val, ee_u16 crc);
+ee_s16    core_reference_crcs(const core_results *res,
+                              const char *        cache,
+                              ee_u16 *            crcs);
+ee_s16    core_reference_cached(const core_results *res,
+                                const char *        cache,
+                                ee_u16 *            crcs);
+ee_s16    core_reference_check(core_results *res,
+                               ee_u32        num_ctx,
+                               const char *  cache);
+ee_s16    core_reference_run(core_results *res, const char *cache);
+#endif
+
+/* Configuration: PREFLIGHT_RUN
+        Define to 1 to check untimed iterations on all the contexts at the
+   same time before the calibration and the timed run (--preflight=<n>
+   iterations, <PREFLIGHT_ITERATIONS> by default, 0 to skip), and stop with a
+   diagnosis of the contexts and kernels if their crcs are wrong. Requires
+   <portable_time>.
+*/
+#ifndef PREFLIGHT_RUN
+#define PREFLIGHT_RUN 0
+#endif
+#if PREFLIGHT_RUN
+/* the crcs checked are those of the first iteration, and an iteration
+ * takes about a second at 300 KB */
+#ifndef PREFLIGHT_ITERATIONS
+#define PREFLIGHT_ITERATIONS 1
+#endif
+ee_s16 core_preflight(core_results *res,
+                      ee_u32        num_ctx,
+                      ee_u32        iterations,
+                      const char *  cache);
+#endif
+
+/* Configuration: CLUSTER_RUN
+        Define to 1 to support the localhost cluster mode (--cluster=<N>), a
+   coordinator driving worker processes over a Unix domain socket. Requires
+   <BATCH_RUN>, fork and Unix domain sockets.
+*/
+#ifndef CLUSTER_RUN
+#define CLUSTER_RUN 0
+#endif
+#if CLUSTER_RUN
+ee_s16 core_cluster_run(core_results *res,
+                        ee_u32        workers,
+                        const char *  path,
+                        ee_u8         attach,
+                        const char *  jobs_file,
+                        ee_u32        outlier);
+ee_s16 core_cluster_worker(const char *path);
+#endif
+
+/* Configuration: PLUGIN_RUN
+        Define to 1 to support workload plugins (--plugin=<name>[,...]), extra
+   algorithms run and reported after the CoreMark score, or on their own with
+   --plugin-only, and sampled in result files. <PLUGIN_DLOPEN> additionally
+   allows loading plugins from shared objects.
+*/
+#ifndef PLUGIN_RUN
+#define PLUGIN_RUN 0
+#endif
+#ifndef PLUGIN_DLOPEN
+#define PLUGIN_DLOPEN 0
+#endif
+/* Type: core_plugin_ctx
+        A plugin opened for a run, see core_plugin.c.
+*/
+typedef struct CORE_PLUGIN_CTX_S core_plugin_ctx;
+#if PLUGIN_RUN
+/* Version of <core_plugin>, changed whenever the structure changes */
+#define CORE_PLUGIN_ABI 1
+/* Structure: core_plugin
+        Description of a workload plugin, see core_plugin.c. A plugin in a
+   shared object exports one as "coremark_plugin".
+*/
+typedef struct CORE_PLUGIN_S
+{
+    ee_u32      abi; /* CORE_PLUGIN_ABI */
+    const char *name;
+    const char *(*describe)(void);
+    /* bytes of memory needed for a run with the given size per algorithm */
+    ee_u32 (*sizing)(ee_u32 size);
+    /* initialize the memory from the seeds, returns 0 on success */
+    ee_s16 (*init)(void * mem,
+                   ee_u32 bytes,
+                   ee_s16 seed1,
+                   ee_s16 seed2,
+                   ee_s16 seed3);
+    /* run one iteration, returns a value folded into the plugin crc */
+    ee_u16 (*bench)(void *mem, ee_u32 bytes);
+    /* check the value of the first iteration: 1 valid, 0 unknown, -1 error */
+    ee_s16 (*validate)(void *mem, ee_u32 bytes, ee_u16 first);
+} core_plugin;
+ee_s16 core_plugin_register(const core_plugin *p);
+void   core_plugins_list(void);
+ee_s16 core_plugins_run(const char *names, core_results *res, ee_u32 target_ms);
+core_plugin_ctx *core_plugin_open(const char *name, const core_results *res);
+secs_ret         core_plugin_sample(core_plugin_ctx *c, ee_u32 n);
+void             core_plugin_close(core_plugin_ctx *c);
+#endif
+
 /* list benchmark functions */
+typedef ee_s32 (*list_cmp)(list_data *a, list_data *b, core_results *res);
 list_head *core_list_init(ee_u32 blksize, list_head *memblock, ee_s16 seed);
 ee_u16     core_bench_list(core_results *res, ee_s16 finder_idx);
+list_head *core_list_find(list_head *list, list_data *info);
+list_head *core_list_insert_new(list_head * insert_point,
+                                list_data * info,
+                                list_head **memblock,
+                                list_data **datablock,
+                                list_head * memblock_end,
+                                list_data * datablock_end);
+list_head *core_list_mergesort(list_head *   list,
+                               list_cmp      cmp,
+                               core_results *res);
 
 /* state benchmark functions */
 void   core_init_state(ee_u32 size, ee_s16 seed, ee_u8 *p);
+enum CORE_STATE core_state_transition(ee_u8 **instr, ee_u32 *transition_count);
 ee_u16 core_bench_state(ee_u32 blksize,
                         ee_u8 *memblock,
                         ee_s16 seed1,
@@ -183,5 +683,51 @@ ee_u32 core_init_matrix(ee_u32      blksize,
                         ee_s32      seed,
                         mat_params *p);
 ee_u16 core_bench_matrix(mat_params *p, ee_s16 seed, ee_u16 crc);
+ee_s16 matrix_sum(ee_u32 N, MATRES *C, MATDAT clipval);
+void   matrix_mul_vect(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+void   matrix_mul_matrix(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+
+/* Configuration: KERNEL_REGISTRY
+        Define to 1 to call the kernels through a table of function pointers,
+   so that alternative implementations can be selected at run time
+   (--kernel=<kernel>:<variant>) and checked against the reference ones
+   (--verify-all). With 0, the reference kernels are called directly.
+*/
+#ifndef KERNEL_REGISTRY
+#define KERNEL_REGISTRY 0
+#endif
+#if KERNEL_REGISTRY
+typedef struct CORE_KERNELS_S
+{
+    list_head *(*list_find)(list_head *list, list_data *info);
+    list_head *(*list_mergesort)(list_head *   list,
+                                 list_cmp      cmp,
+                                 core_results *res);
+    void (*matrix_mul_matrix)(ee_u32 N, MATRES *C, MATDAT *A, MATDAT *B);
+    enum CORE_STATE (*state_transition)(ee_u8 **instr,
+                                        ee_u32 *transition_count);
+    ee_u16 (*crcu16)(ee_u16 newval, ee_u16 crc);
+} core_kernels;
+/* Variable: core_kernel
+        Kernels used by the benchmark, the reference ones unless selected
+   otherwise with <core_kernels_select>. Only changed before a run starts.
+*/
+extern core_kernels core_kernel;
+#define KERNEL_LIST_FIND         core_kernel.list_find
+#define KERNEL_LIST_MERGESORT    core_kernel.list_mergesort
+#define KERNEL_MATRIX_MUL_MATRIX core_kernel.matrix_mul_matrix
+#define KERNEL_STATE_TRANSITION  core_kernel.state_transition
+#define KERNEL_CRCU16            core_kernel.crcu16
+ee_s16 core_kernels_select(const char *spec);
+void   core_kernels_list(void);
+void   core_kernels_print(void);
+ee_s16 core_kernels_verify(ee_u32 trials);
+#else
+#define KERNEL_LIST_FIND         core_list_find
+#define KERNEL_LIST_MERGESORT    core_list_mergesort
+#define KERNEL_MATRIX_MUL_MATRIX matrix_mul_matrix
+#define KERNEL_STATE_TRANSITION  core_state_transition
+#define KERNEL_CRCU16            crcu16
+#endif
 
 #endif
@@ -16,12 +16,319 @@ limitations under the License.
 Original Author: Shay Gal-on
 */
 
+#define _GNU_SOURCE /* for CPU affinity */
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
 #include "coremark.h"
 #if CALLGRIND_RUN
 #include <valgrind/callgrind.h>
 #endif
+#if COUNT_RUN
+#include <string.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+/* perf counter of the instructions of this thread, -1 if not opened */
+static int count_fd = -1;
+#endif
+
+#if CGROUP_AWARE || DAEMON_RUN
+#include <string.h>
+
+/* Function: cgroup_word
+        Whether a list separated by commas or spaces holds <word>.
+*/
+static int
+cgroup_word(const char *list, const char *word)
+{
+    size_t n = strlen(word);
+    while (*list)
+    {
+        size_t k = strcspn(list, ", \n");
+        if (k == n && strncmp(list, word, n) == 0)
+            return 1;
+        list += k;
+        list += strspn(list, ", \n");
+    }
+    return 0;
+}
+
+/* Function: cgroup_dir
+        Find the directory of the cgroup of the process that has the cpu
+   controller: in the unified hierarchy (cgroup v2) when the controller is
+   enabled there, else in the cpu hierarchy of cgroup v1.
+
+   When the path is "/", e.g. in a container with its own cgroup namespace,
+   or is not found under the mount, e.g. a v1 path of the host seen from a
+   container, the directory is the root of the mounted hierarchy, which
+   then holds the limits of the container.
+
+        Returns:
+        2 or 1 for the version of the hierarchy, 0 if there is none.
+*/
+static int
+cgroup_dir(char *dir, size_t len)
+{
+    char  line[512], v1[512] = "", v2[512] = "", controllers[256] = "";
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if (fp == NULL)
+        return 0;
+    /* lines are "<id>:<controllers>:<path>", controllers empty for v2 */
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        char *ctrl = strchr(line, ':'), *path;
+        line[strcspn(line, "\n")] = 0;
+        if (ctrl == NULL || (path = strchr(ctrl + 1, ':')) == NULL)
+            continue;
+        *path++ = 0;
+        if (ctrl[1] == 0)
+            snprintf(v2, sizeof(v2), "%s", path);
+        else if (cgroup_word(ctrl + 1, "cpu"))
+            snprintf(v1, sizeof(v1), "%s", path);
+    }
+    fclose(fp);
+    fp = fopen("/sys/fs/cgroup/cgroup.controllers", "r");
+    if (fp != NULL)
+    {
+        if (fgets(controllers, sizeof(controllers), fp) == NULL)
+            controllers[0] = 0;
+        fclose(fp);
+    }
+    if (v2[0] && cgroup_word(controllers, "cpu"))
+    {
+        snprintf(dir, len, "/sys/fs/cgroup%s", v2);
+        if (strcmp(v2, "/") == 0 || access(dir, F_OK) != 0)
+            snprintf(dir, len, "/sys/fs/cgroup");
+        return 2;
+    }
+    if (v1[0])
+    {
+        static const char *mounts[]
+            = { "/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct" };
+        int i;
+        for (i = 0; i < 2; i++)
+        {
+            snprintf(dir, len, "%s%s", mounts[i], v1);
+            if (strcmp(v1, "/") != 0 && access(dir, F_OK) == 0)
+                return 1;
+        }
+        for (i = 0; i < 2; i++)
+        {
+            snprintf(dir, len, "%s", mounts[i]);
+            if (access(dir, F_OK) == 0)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* Function: cgroup_read
+        Read the first line of a file of the cgroup directory <dir>.
+
+        Returns:
+        1 on success, 0 if the file cannot be read.
+*/
+static int
+cgroup_read(const char *dir, const char *name, char *buf, size_t len)
+{
+    char  path[600];
+    FILE *fp;
+    int   ok;
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    fp = fopen(path, "r");
+    if (fp == NULL)
+        return 0;
+    ok = fgets(buf, (int)len, fp) != NULL;
+    fclose(fp);
+    return ok;
+}
+#endif
+
+#if CGROUP_AWARE
+/* Cpu limits of the cgroup, and its throttling during the scored section */
+static struct
+{
+    int                version; /* 0 if not in a cgroup with a cpu limit */
+    char               dir[512];
+    char               stat_dir[512]; /* cgroup of the limiting quota */
+    secs_ret           quota;   /* cpus allowed by the quota, 0 if none */
+    ee_u32             cpus;    /* cpus allowed by the affinity (cpuset) */
+    ee_u32             sized;   /* contexts chosen from the limits, or 0 */
+    unsigned long long periods; /* throttled periods at the start */
+    unsigned long long usecs;   /* throttled time at the start */
+    unsigned long long throttled_periods, throttled_usecs;
+} cgroup;
+
+/* Function: cgroup_quota
+        Cpus allowed by the cpu quota of the cgroup and of its parents up to
+   the root of the mounted hierarchy, the smallest of them. The cgroup with
+   that quota is kept in stat_dir, as its cpu.stat counts the throttling it
+   causes.
+
+        Returns:
+        Number of cpus, 0 if there is no quota.
+*/
+static secs_ret
+cgroup_quota(void)
+{
+    char     dir[512], buf[64], *slash;
+    secs_ret quota = 0;
+    /* length of the root of the mounted hierarchy, the last one read */
+    size_t root = strlen(cgroup.version == 2 ? "/sys/fs/cgroup"
+                         : strncmp(cgroup.dir, "/sys/fs/cgroup/cpu,", 19) == 0
+                             ? "/sys/fs/cgroup/cpu,cpuacct"
+                             : "/sys/fs/cgroup/cpu");
+    snprintf(dir, sizeof(dir), "%s", cgroup.dir);
+    for (;;)
+    {
+        long long q = -1, period = 0;
+        if (cgroup.version == 2)
+        {
+            /* "max 100000" or "<quota> <period>" */
+            if (cgroup_read(dir, "cpu.max", buf, sizeof(buf))
+                && sscanf(buf, "%lld %lld", &q, &period) != 2)
+                q = -1;
+        }
+        else if (cgroup_read(dir, "cpu.cfs_quota_us", buf, sizeof(buf)))
+        {
+            q = strtoll(buf, NULL, 10);
+            if (cgroup_read(dir, "cpu.cfs_period_us", buf, sizeof(buf)))
+                period = strtoll(buf, NULL, 10);
+        }
+        if (q > 0 && period > 0
+            && (quota == 0 || (secs_ret)q / period < quota))
+        {
+            quota = (secs_ret)q / period;
+            snprintf(cgroup.stat_dir, sizeof(cgroup.stat_dir), "%s", dir);
+        }
+        slash = strrchr(dir, '/');
+        if (slash == NULL || (size_t)(slash - dir) < root)
+            break;
+        *slash = 0;
+    }
+    return quota;
+}
+
+/* Function: cgroup_throttling
+        Read the throttled periods and time from the cpu.stat of the cgroup
+   of the limiting quota.
+*/
+static void
+cgroup_throttling(unsigned long long *periods, unsigned long long *usecs)
+{
+    char  path[600], key[64];
+    FILE *fp;
+    unsigned long long value;
+    *periods = 0;
+    *usecs   = 0;
+    snprintf(path, sizeof(path), "%s/cpu.stat", cgroup.stat_dir);
+    fp = fopen(path, "r");
+    if (fp == NULL)
+        return;
+    while (fscanf(fp, "%63s %llu", key, &value) == 2)
+    {
+        if (strcmp(key, "nr_throttled") == 0)
+            *periods = value;
+        else if (strcmp(key, "throttled_usec") == 0)
+            *usecs = value;
+        else if (strcmp(key, "throttled_time") == 0) /* v1, in ns */
+            *usecs = value / 1000;
+    }
+    fclose(fp);
+}
+
+/* Function: cgroup_init
+        Find the cgroup and its cpu limits.
+*/
+static void
+cgroup_init(void)
+{
+    cpu_set_t set;
+    cgroup.version = cgroup_dir(cgroup.dir, sizeof(cgroup.dir));
+    snprintf(cgroup.stat_dir, sizeof(cgroup.stat_dir), "%s", cgroup.dir);
+    if (cgroup.version)
+        cgroup.quota = cgroup_quota();
+    /* the affinity of the process is already limited to its cpuset */
+    cgroup.cpus = portable_num_cpus();
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0)
+        cgroup.cpus = (ee_u32)CPU_COUNT(&set);
+}
+
+#if (MULTITHREAD > 1) && (SEED_METHOD == SEED_ARG)
+/* Function: cgroup_contexts
+        Number of contexts that fit in the cpus allowed to the process: the
+   cpus of its cpuset, and the whole cpus of its quota.
+*/
+static ee_u32
+cgroup_contexts(ee_u32 n)
+{
+    ee_u32 fit = cgroup.cpus;
+    if (cgroup.quota > 0 && cgroup.quota < fit)
+        fit = cgroup.quota >= 1 ? (ee_u32)cgroup.quota : 1;
+    if (fit < n)
+    {
+        cgroup.sized = fit;
+        n            = fit;
+    }
+    return n;
+}
+#endif
+
+/* Function: portable_cgroup_section
+        Mark the start (<start> set) and the end of the scored section, the
+   throttling is counted in between. Other timed sections, e.g. the
+   calibration, are not counted.
+*/
+void
+portable_cgroup_section(ee_u8 start)
+{
+    unsigned long long periods, usecs;
+    if (!cgroup.version)
+        return;
+    cgroup_throttling(&periods, &usecs);
+    if (start)
+    {
+        cgroup.periods = periods;
+        cgroup.usecs   = usecs;
+    }
+    else
+    {
+        cgroup.throttled_periods = periods - cgroup.periods;
+        cgroup.throttled_usecs   = usecs - cgroup.usecs;
+    }
+}
+
+/* Function: portable_cgroup_check
+        Report the cpu limits of the cgroup, and whether the cgroup was
+   throttled during the scored section. Throttling means the run measured
+   the quota rather than the speed of the cpus.
+
+        Returns:
+        1 if the run was throttled, 0 otherwise.
+*/
+ee_s16
+portable_cgroup_check(void)
+{
+    if (cgroup.quota > 0 || cgroup.sized)
+    {
+        ee_printf("Cgroup limits    : %u cpus", cgroup.cpus);
+        if (cgroup.quota > 0)
+            ee_printf(", quota %.2f cpus", cgroup.quota);
+        if (cgroup.sized)
+            ee_printf(", %u contexts", cgroup.sized);
+        ee_printf("\n");
+    }
+    if (cgroup.throttled_periods == 0)
+        return 0;
+    ee_printf("ERROR! Throttled by the cgroup cpu quota: %llu periods, %f "
+              "secs\n",
+              cgroup.throttled_periods,
+              (secs_ret)cgroup.throttled_usecs / 1000000);
+    return 1;
+}
+#endif
 
 #if (MEM_METHOD == MEM_MALLOC)
 #include <malloc.h>
@@ -144,6 +451,13 @@ start_time(void)
 #if CALLGRIND_RUN
     CALLGRIND_START_INSTRUMENTATION
 #endif
+#if COUNT_RUN
+    if (count_fd >= 0)
+    {
+        ioctl(count_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(count_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
 #if MICA
     asm volatile("int3"); /*1 */
 #endif
@@ -159,6 +473,10 @@ start_time(void)
 void
 stop_time(void)
 {
+#if COUNT_RUN
+    if (count_fd >= 0)
+        ioctl(count_fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
 #if CALLGRIND_RUN
     CALLGRIND_STOP_INSTRUMENTATION
 #endif
@@ -196,12 +514,838 @@ time_in_secs(CORE_TICKS ticks)
     secs_ret retval = ((secs_ret)ticks) / (secs_ret)EE_TICKS_PER_SEC;
     return retval;
 }
+/* Function: portable_time
+        Return a free running time in seconds, from an arbitrary origin.
+
+        Used by the run modes that take many measurements (e.g. streaming),
+   where the single <start_time>/<stop_time> pair cannot be used.
+*/
+secs_ret
+portable_time(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (secs_ret)t.tv_sec + (secs_ret)t.tv_nsec / (secs_ret)1000000000;
+}
 #else
 #error "Please implement timing functionality in core_portme.c"
 #endif /* SAMPLE_TIME_IMPLEMENTATION */
 
 ee_u32 default_num_contexts = MULTITHREAD;
 
+/* Function: portable_num_cpus
+        Return the number of online cpus.
+*/
+ee_u32
+portable_num_cpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (ee_u32)n : 1;
+}
+
+/* Function: portable_set_affinity
+        Pin the calling thread to a single cpu.
+
+        Returns:
+        1 on success, 0 if the thread could not be pinned.
+*/
+ee_u8
+portable_set_affinity(ee_u32 cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+#if MULTIVERSION
+/* Function: portable_clone_name
+        Name of the clone of the kernels selected on this cpu: the highest
+   level of <MULTIVERSION_TARGETS> that the cpu supports, as chosen by the
+   resolvers gcc generates.
+*/
+const char *
+portable_clone_name(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("x86-64-v4"))
+        return "x86-64-v4";
+    if (__builtin_cpu_supports("x86-64-v3"))
+        return "x86-64-v3";
+    if (__builtin_cpu_supports("x86-64-v2"))
+        return "x86-64-v2";
+    return "default";
+}
+#endif
+
+#if COUNT_RUN
+/* Function: portable_count_open
+        Prepare counting the timed sections. Under valgrind, callgrind counts
+   the instrumented sections, see <start_time>. Otherwise, open the perf
+   counter of the instructions this thread retires in user mode, enabled
+   between <start_time> and <stop_time>.
+
+        Returns:
+        0 on success, 1 if there is no counter.
+*/
+ee_s16
+portable_count_open(void)
+{
+    struct perf_event_attr attr;
+#if CALLGRIND_RUN
+    if (RUNNING_ON_VALGRIND)
+        return 0;
+#endif
+    if (count_fd >= 0)
+        return 0;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    count_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    return count_fd < 0;
+}
+
+/* Function: portable_counts
+        Counts of the last timed section. Under callgrind, dump its counts
+   under <name> instead, in a file of its own.
+
+        Returns:
+        0 if the counts are returned, 1 if they are counted outside the
+   process.
+*/
+ee_s16
+portable_counts(const char *name, core_counts *counts)
+{
+    unsigned long long value = 0;
+    counts->instructions     = 0;
+#if CALLGRIND_RUN
+    if (RUNNING_ON_VALGRIND)
+    {
+        CALLGRIND_DUMP_STATS_AT(name);
+        counts->source = "callgrind";
+        return 1;
+    }
+#else
+    (void)name;
+#endif
+    counts->source = "perf instructions";
+    if (count_fd >= 0 && read(count_fd, &value, sizeof(value)) == sizeof(value))
+        counts->instructions = value;
+    return 0;
+}
+#endif
+
+#if COMPARE_RUN
+#include <string.h>
+#include <sys/utsname.h>
+
+/* Function: portable_fingerprint
+        Name the host for result files: the cpu model, the number of cpus
+   online, the kernel and the machine. Results of hosts with different
+   fingerprints are not compared.
+*/
+void
+portable_fingerprint(char *buf, ee_u32 len)
+{
+    char           model[128] = "unknown cpu", line[256];
+    struct utsname u;
+    FILE *         fp = fopen("/proc/cpuinfo", "r");
+    if (fp != NULL)
+    {
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            char *v = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && v != NULL)
+            {
+                v += 1 + (v[1] == ' ');
+                v[strcspn(v, "\n")] = 0;
+                snprintf(model, sizeof(model), "%s", v);
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    if (uname(&u) != 0)
+    {
+        strcpy(u.release, "unknown");
+        strcpy(u.machine, "unknown");
+    }
+    snprintf(buf,
+             len,
+             "%s, %ld cpus, %s %s",
+             model,
+             sysconf(_SC_NPROCESSORS_ONLN),
+             u.release,
+             u.machine);
+}
+#endif
+
+#if DAEMON_RUN
+#include <string.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+/* Dedicated cgroup of the daemon, created by <portable_background> */
+static struct
+{
+    char  parent[512]; /* cgroup the process came from */
+    char  dir[600];    /* its child holding the daemon, "" if none */
+    ee_u8 enabled;     /* cpu controller enabled by us in the parent */
+} background;
+
+/* Function: background_write
+        Write <value> to the file <name> of the cgroup directory <dir>.
+
+        Returns:
+        0 on success, 1 otherwise.
+*/
+static int
+background_write(const char *dir, const char *name, const char *value)
+{
+    char  path[700];
+    FILE *fp;
+    int   err;
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    fp = fopen(path, "r+");
+    if (fp == NULL)
+        return 1;
+    err = fputs(value, fp) < 0;
+    return (fclose(fp) != 0 || err) ? 1 : 0;
+}
+
+/* Function: background_restore
+        Move the process back to the cgroup it came from and remove the
+   cgroup created for the daemon, so no limit is left behind.
+*/
+static void
+background_restore(void)
+{
+    char pid[32];
+    if (background.dir[0] == 0)
+        return;
+    snprintf(pid, sizeof(pid), "%ld\n", (long)getpid());
+    background_write(background.parent, "cgroup.procs", pid);
+    rmdir(background.dir);
+    if (background.enabled)
+        background_write(background.parent, "cgroup.subtree_control", "-cpu");
+    background.dir[0] = 0;
+}
+
+/* Function: portable_background
+        Run the process at the lowest priority: nice 19 and SCHED_IDLE, so
+   that it only uses cpus that are idle otherwise. With a budget, also limit
+   the process to <budget> percent of one cpu, with a cpu.max (cgroup v2).
+   Without <cgroup>, the process moves to a child "coremark-daemon" of its
+   own cgroup (see <cgroup_dir>), which gets the limit, so the other
+   processes of that cgroup, e.g. its systemd service or session, are not
+   limited. <portable_fini> moves it back and removes the child. With
+   <cgroup>, the process moves there and that cgroup is limited.
+
+        Returns:
+        0 on success, 1 if the budget cannot be applied.
+*/
+ee_s16
+portable_background(ee_u32 budget, const char *cgroup)
+{
+    struct sched_param sp;
+    char               dir[600], pid[32], max[32], controllers[256] = "";
+
+    memset(&sp, 0, sizeof(sp));
+    setpriority(PRIO_PROCESS, 0, 19);
+    sched_setscheduler(0, SCHED_IDLE, &sp);
+    if (budget == 0)
+        return 0;
+    snprintf(pid, sizeof(pid), "%ld\n", (long)getpid());
+    snprintf(max, sizeof(max), "%u 100000\n", budget * 1000);
+    if (cgroup != NULL && *cgroup)
+    {
+        if (background_write(cgroup, "cgroup.procs", pid) != 0)
+            return 1;
+        return (ee_s16)background_write(cgroup, "cpu.max", max);
+    }
+    if (cgroup_dir(background.parent, sizeof(background.parent)) != 2
+        || strcmp(background.parent, "/sys/fs/cgroup") == 0)
+        return 1; /* never the root cgroup, that is the whole system */
+    snprintf(dir, sizeof(dir), "%s/coremark-daemon", background.parent);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+        return 1;
+    if (background_write(dir, "cgroup.procs", pid) != 0)
+    {
+        rmdir(dir);
+        return 1;
+    }
+    snprintf(background.dir, sizeof(background.dir), "%s", dir);
+    /* the child only has a cpu.max once the parent enables the controller
+     * for its children, which needs the parent to hold no other process */
+    if (cgroup_read(background.parent,
+                    "cgroup.subtree_control",
+                    controllers,
+                    sizeof(controllers))
+        && !cgroup_word(controllers, "cpu"))
+    {
+        if (background_write(
+                background.parent, "cgroup.subtree_control", "+cpu")
+            != 0)
+        {
+            background_restore();
+            return 1;
+        }
+        background.enabled = 1;
+    }
+    if (background_write(dir, "cpu.max", max) != 0)
+    {
+        background_restore();
+        return 1;
+    }
+    return 0;
+}
+
+/* Function: portable_cpu_mhz
+        Current frequency of the cpu the thread runs on, from cpufreq, or
+   from /proc/cpuinfo without it.
+
+        Returns:
+        The frequency in MHz, 0 if unknown.
+*/
+secs_ret
+portable_cpu_mhz(void)
+{
+    char  path[96], line[256];
+    long  khz = 0;
+    FILE *fp;
+    int   cpu = sched_getcpu(), n = -1;
+
+    snprintf(path,
+             sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
+             cpu < 0 ? 0 : cpu);
+    fp = fopen(path, "r");
+    if (fp != NULL)
+    {
+        if (fscanf(fp, "%ld", &khz) != 1)
+            khz = 0;
+        fclose(fp);
+        if (khz > 0)
+            return (secs_ret)khz / 1000;
+    }
+    fp = fopen("/proc/cpuinfo", "r");
+    if (fp == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        char *v = strchr(line, ':');
+        if (v == NULL)
+            continue;
+        if (strncmp(line, "processor", 9) == 0)
+            n = atoi(v + 1);
+        else if (strncmp(line, "cpu MHz", 7) == 0 && (n == cpu || cpu < 0))
+        {
+            fclose(fp);
+            return (secs_ret)strtod(v + 1, NULL);
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+#endif
+
+#if STARTUP_RUN
+#include <string.h>
+#include <time.h>
+
+/* Function: portable_process_age
+        Time since the process started, from its start time in
+   /proc/self/stat, in clock ticks since boot. The resolution is one clock
+   tick, usually 10 ms.
+
+        Returns:
+        The age in seconds, 0 if unknown.
+*/
+secs_ret
+portable_process_age(void)
+{
+    char               buf[1024], *p;
+    unsigned long long start;
+    struct timespec    now;
+    long               hz = sysconf(_SC_CLK_TCK);
+    FILE *             fp;
+    size_t             n;
+    int                field;
+
+    fp = fopen("/proc/self/stat", "r");
+    if (fp == NULL)
+        return 0;
+    n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = 0;
+    /* the command name may hold spaces, count the fields after it */
+    p = strrchr(buf, ')');
+    if (p == NULL || hz <= 0 || clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+        return 0;
+    for (field = 2; field < 22 && p != NULL; field++)
+        p = strchr(p + 1, ' ');
+    if (p == NULL || sscanf(p, "%llu", &start) != 1)
+        return 0;
+    return (secs_ret)now.tv_sec + (secs_ret)now.tv_nsec / 1000000000
+           - (secs_ret)start / hz;
+}
+#endif
+
+#if HYBRID_RUN
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/* Function: hybrid_mark
+        Set the type of the cpus listed in a sysfs file such as
+   /sys/devices/cpu_core/cpus ("0-15").
+
+        Returns:
+        Number of cpus marked.
+*/
+static ee_u32
+hybrid_mark(const char *path, ee_u8 *type, ee_u32 n, ee_u8 t)
+{
+    char  line[1024], *p = line, *end;
+    FILE *fp = fopen(path, "r");
+    ee_u32 marked = 0;
+    if (fp == NULL)
+        return 0;
+    if (fgets(line, sizeof(line), fp) == NULL)
+        line[0] = 0;
+    fclose(fp);
+    while (*p >= '0' && *p <= '9')
+    {
+        unsigned long first = strtoul(p, &end, 10), last = first;
+        if (*end == '-')
+            last = strtoul(end + 1, &end, 10);
+        for (; first <= last && first < n; first++, marked++)
+            type[first] = t;
+        p = end + (*end == ',');
+    }
+    return marked;
+}
+
+/* Function: hybrid_capacity
+        Classify the cpus by the cpu_capacity of the scheduler (arm64
+   big.LITTLE and DynamIQ), largest capacity first. Once there are
+   <HYBRID_MAX_TYPES> classes, other capacities join the next smaller class.
+
+        Returns:
+        Number of classes, 1 if all cpus have the same capacity or it is
+   unknown.
+*/
+static ee_u32
+hybrid_capacity(ee_u8 *type, ee_u32 n, const char **names)
+{
+    static char name[HYBRID_MAX_TYPES][32];
+    long        cap[HYBRID_MAX_TYPES], c;
+    ee_u32      i, j, k = 0;
+    char        path[96];
+    FILE *      fp;
+
+    for (i = 0; i < n; i++)
+    {
+        snprintf(path,
+                 sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cpu_capacity",
+                 i);
+        fp = fopen(path, "r");
+        if (fp == NULL)
+            return 1;
+        if (fscanf(fp, "%ld", &c) != 1)
+            c = 0;
+        fclose(fp);
+        /* insert into the distinct capacities, largest first */
+        for (j = 0; j < k && cap[j] > c; j++)
+            ;
+        if (j < k && cap[j] == c)
+            continue;
+        if (k == HYBRID_MAX_TYPES)
+            continue;
+        memmove(&cap[j + 1], &cap[j], (k - j) * sizeof(long));
+        cap[j] = c;
+        k++;
+    }
+    for (i = 0; i < n && k > 1; i++)
+    {
+        snprintf(path,
+                 sizeof(path),
+                 "/sys/devices/system/cpu/cpu%u/cpu_capacity",
+                 i);
+        fp = fopen(path, "r");
+        if (fp == NULL || fscanf(fp, "%ld", &c) != 1)
+            c = 0;
+        if (fp != NULL)
+            fclose(fp);
+        for (j = 0; j < k - 1 && cap[j] > c; j++)
+            ;
+        type[i] = (ee_u8)j;
+    }
+    for (j = 0; j < k && k > 1; j++)
+    {
+        snprintf(name[j], sizeof(name[j]), "capacity %ld", cap[j]);
+        names[j] = name[j];
+    }
+    return k > 1 ? k : 1;
+}
+
+/* Function: portable_core_types
+        Find the types of the cpus of a hybrid processor, from:
+        - the Intel hybrid pmus, /sys/devices/cpu_core, cpu_atom and
+        cpu_lowpower.
+        - the cpu_capacity of each cpu.
+        - on x86 without them, the core type of cpuid leaf 0x1a, read on each
+        cpu in turn.
+
+        Parameters:
+        type - set to the class of each of the first <n> cpus, 0 for the
+   fastest class.
+        n - number of cpus.
+        names - set to the name of each class.
+
+        Returns:
+        Number of classes, 1 if the processor is not hybrid.
+*/
+ee_u32
+portable_core_types(ee_u8 *type, ee_u32 n, const char **names)
+{
+    ee_u32 k;
+    memset(type, 0, n);
+    names[0] = "all";
+    if (hybrid_mark("/sys/devices/cpu_core/cpus", type, n, 0) > 0
+        && hybrid_mark("/sys/devices/cpu_atom/cpus", type, n, 1) > 0)
+    {
+        names[0] = "P-core";
+        names[1] = "E-core";
+        if (hybrid_mark("/sys/devices/cpu_lowpower/cpus", type, n, 2) == 0)
+            return 2;
+        names[2] = "LP E-core";
+        return 3;
+    }
+    memset(type, 0, n);
+    k = hybrid_capacity(type, n, names);
+    if (k > 1)
+        return k;
+    memset(type, 0, n);
+#if defined(__x86_64__) || defined(__i386__)
+    {
+        unsigned int a, b, c, d, i, seen = 0;
+        cpu_set_t    saved;
+        /* leaf 7 edx bit 15: hybrid part */
+        if (!__get_cpuid_count(7, 0, &a, &b, &c, &d) || !(d & (1u << 15))
+            || sched_getaffinity(0, sizeof(saved), &saved) != 0)
+            return 1;
+        for (i = 0; i < n; i++)
+        {
+            if (!portable_set_affinity(i)
+                || !__get_cpuid_count(0x1a, 0, &a, &b, &c, &d))
+                continue;
+            /* core type in bits 31-24: 0x40 Core, 0x20 Atom */
+            type[i] = (a >> 24) == 0x20;
+            seen |= 1u << type[i];
+        }
+        sched_setaffinity(0, sizeof(saved), &saved);
+        if (seen == 3)
+        {
+            names[0] = "P-core";
+            names[1] = "E-core";
+            return 2;
+        }
+        memset(type, 0, n);
+    }
+#endif
+    return 1;
+}
+#endif
+
+#if QUIET_SYSTEM
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/personality.h>
+#include <sys/resource.h>
+
+#define QUIET_MAX_CPUS 256
+#define QUIET_PRIORITY 50 /* SCHED_FIFO priority of the benchmark */
+
+/* Settings applied by --quiet-system, and the text of each for the report.
+ * The governors are restored by <portable_fini>. */
+static struct
+{
+    ee_u8  enabled;
+    ee_u32 cpus[QUIET_MAX_CPUS];
+    ee_u32 num_cpus;
+    ee_u32 next_cpu;
+    char   sched[64];
+    char   mlock[64];
+    char   affinity[96];
+    char   aslr[64];
+    char   governor[64];
+    char   saved_governor[QUIET_MAX_CPUS][32];
+} quiet;
+
+/* Function: quiet_has_arg
+        Whether an option is on the command line, without removing it.
+*/
+static int
+quiet_has_arg(int argc, char *argv[], const char *opt)
+{
+    size_t n = strlen(opt);
+    int    i;
+    for (i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], opt, n) == 0
+            && (argv[i][n] == 0 || argv[i][n] == '='))
+            return 1;
+    }
+    return 0;
+}
+
+/* Function: quiet_parse_cpus
+        Parse a cpu list such as "2-3,6".
+
+        Returns:
+        Number of cpus, 0 if the list is invalid.
+*/
+static ee_u32
+quiet_parse_cpus(const char *list, ee_u32 *cpus)
+{
+    ee_u32 n = 0;
+    while (*list)
+    {
+        char *        end;
+        unsigned long first = strtoul(list, &end, 10), last = first;
+        if (end == list)
+            return 0;
+        if (*end == '-')
+        {
+            list = end + 1;
+            last = strtoul(list, &end, 10);
+            if (end == list || last < first)
+                return 0;
+        }
+        for (; first <= last && n < QUIET_MAX_CPUS; first++)
+            cpus[n++] = (ee_u32)first;
+        if (*end == ',')
+            end++;
+        else if (*end != 0)
+            return 0;
+        list = end;
+    }
+    return n;
+}
+
+/* Function: quiet_governor
+        Set the cpufreq governor of a cpu, saving the previous one.
+
+        Returns:
+        1 if set, 0 if not writable or not present.
+*/
+static int
+quiet_governor(ee_u32 cpu, const char *governor, char *saved, size_t len)
+{
+    char  path[96];
+    FILE *f;
+    snprintf(path,
+             sizeof(path),
+             "/sys/devices/system/cpu/cpu%u/cpufreq/scaling_governor",
+             cpu);
+    if (saved != NULL)
+    {
+        saved[0] = 0;
+        f        = fopen(path, "r");
+        if (f == NULL)
+            return 0;
+        if (fgets(saved, (int)len, f) != NULL)
+            saved[strcspn(saved, "\n")] = 0;
+        fclose(f);
+    }
+    f = fopen(path, "w");
+    if (f == NULL)
+        return 0;
+    if (fputs(governor, f) < 0)
+    {
+        fclose(f);
+        return 0;
+    }
+    return fclose(f) == 0;
+}
+
+/* Function: quiet_system
+        Apply the low noise settings of --quiet-system[=<cpus>] [--no-aslr]:
+   re-exec with ASLR disabled, mlockall, SCHED_FIFO, pin to the cpus and set
+   their cpufreq governor to performance. Each setting is recorded, whether
+   it was applied or not, for <portable_quiet_print>.
+*/
+static void
+quiet_system(int *argc, char *argv[])
+{
+    struct rlimit      limit;
+    struct sched_param param;
+    char *             cpus;
+    int                pers = personality(0xffffffff), exec_err = 0;
+    ee_u32             i, set = 0;
+
+    /* ASLR is decided when the program is loaded: re-exec with it disabled,
+     * before the options are removed from the command line */
+    if (quiet_has_arg(*argc, argv, "--quiet-system")
+        && quiet_has_arg(*argc, argv, "--no-aslr") && pers != -1
+        && !(pers & ADDR_NO_RANDOMIZE))
+    {
+        if (personality((unsigned long)pers | ADDR_NO_RANDOMIZE) != -1)
+            execv("/proc/self/exe", argv);
+        exec_err = errno;
+        personality((unsigned long)pers);
+    }
+    cpus = get_option_arg("quiet-system", argc, argv);
+    get_option_arg("no-aslr", argc, argv);
+    if (cpus == NULL)
+        return;
+    quiet.enabled = 1;
+
+    if (pers != -1 && (pers & ADDR_NO_RANDOMIZE))
+        snprintf(quiet.aslr, sizeof(quiet.aslr), "disabled");
+    else if (exec_err)
+        snprintf(quiet.aslr,
+                 sizeof(quiet.aslr),
+                 "enabled (re-exec failed: %s)",
+                 strerror(exec_err));
+    else
+        snprintf(quiet.aslr, sizeof(quiet.aslr), "enabled");
+
+    /* lock future mappings only if the limit allows it, or every later
+     * allocation beyond the limit would fail */
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0
+        && (limit.rlim_cur == RLIM_INFINITY || geteuid() == 0))
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+            snprintf(quiet.mlock, sizeof(quiet.mlock), "current and future");
+        else
+            snprintf(quiet.mlock,
+                     sizeof(quiet.mlock),
+                     "failed (%s)",
+                     strerror(errno));
+    }
+    else if (mlockall(MCL_CURRENT) == 0)
+        snprintf(quiet.mlock,
+                 sizeof(quiet.mlock),
+                 "current only (RLIMIT_MEMLOCK)");
+    else
+        snprintf(
+            quiet.mlock, sizeof(quiet.mlock), "failed (%s)", strerror(errno));
+
+    /* threads and child processes inherit the policy */
+    param.sched_priority = QUIET_PRIORITY;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) == 0)
+        snprintf(quiet.sched,
+                 sizeof(quiet.sched),
+                 "SCHED_FIFO priority %d",
+                 QUIET_PRIORITY);
+    else
+        snprintf(quiet.sched,
+                 sizeof(quiet.sched),
+                 "default (SCHED_FIFO: %s)",
+                 strerror(errno));
+
+    if (*cpus)
+    {
+        quiet.num_cpus = quiet_parse_cpus(cpus, quiet.cpus);
+        if (quiet.num_cpus == 0)
+            snprintf(quiet.affinity,
+                     sizeof(quiet.affinity),
+                     "none (invalid cpu list %.32s)",
+                     cpus);
+        else if (!portable_set_affinity(quiet.cpus[0]))
+        {
+            snprintf(quiet.affinity,
+                     sizeof(quiet.affinity),
+                     "none (cannot pin to cpu %u)",
+                     quiet.cpus[0]);
+            quiet.num_cpus = 0;
+        }
+        else
+            snprintf(quiet.affinity,
+                     sizeof(quiet.affinity),
+                     "cpus %.64s, one per context in turn",
+                     cpus);
+    }
+    else
+        snprintf(quiet.affinity, sizeof(quiet.affinity), "none (no cpu list)");
+
+    for (i = 0; i < (quiet.num_cpus ? quiet.num_cpus : portable_num_cpus())
+                && i < QUIET_MAX_CPUS;
+         i++)
+    {
+        ee_u32 cpu = quiet.num_cpus ? quiet.cpus[i] : i;
+        set += quiet_governor(cpu,
+                              "performance",
+                              quiet.saved_governor[i],
+                              sizeof(quiet.saved_governor[i]));
+    }
+    if (set)
+        snprintf(quiet.governor,
+                 sizeof(quiet.governor),
+                 "performance on %u cpus",
+                 set);
+    else
+        snprintf(quiet.governor,
+                 sizeof(quiet.governor),
+                 "unchanged (not writable)");
+}
+
+/* Function: quiet_restore
+        Restore the cpufreq governors changed by <quiet_system>.
+*/
+static void
+quiet_restore(void)
+{
+    ee_u32 i;
+    for (i = 0; i < QUIET_MAX_CPUS; i++)
+    {
+        if (quiet.saved_governor[i][0])
+            quiet_governor(quiet.num_cpus ? quiet.cpus[i] : i,
+                           quiet.saved_governor[i],
+                           NULL,
+                           0);
+    }
+}
+
+#if (MULTITHREAD > 1)
+/* Function: quiet_next_cpu
+        Cpu for the next parallel context, -1 if contexts are not pinned.
+*/
+static int
+quiet_next_cpu(void)
+{
+    if (quiet.num_cpus == 0)
+        return -1;
+    return (int)quiet.cpus[quiet.next_cpu++ % quiet.num_cpus];
+}
+#endif
+
+/* Function: portable_quiet_print
+        Report the settings of --quiet-system.
+*/
+void
+portable_quiet_print(void)
+{
+    if (!quiet.enabled)
+        return;
+    ee_printf("Quiet scheduling : %s\n", quiet.sched);
+    ee_printf("Quiet memory lock: %s\n", quiet.mlock);
+    ee_printf("Quiet affinity   : %s\n", quiet.affinity);
+    ee_printf("Quiet ASLR       : %s\n", quiet.aslr);
+    ee_printf("Quiet governor   : %s\n", quiet.governor);
+}
+#endif /* QUIET_SYSTEM */
+
 /* Function: portable_init
         Target specific initialization code
         Test for some common mistakes.
@@ -231,6 +1375,13 @@ portable_init(core_portable *p, int *argc, char *argv[])
         "ERROR! Main has no argc, but SEED_METHOD defined to SEED_ARG!\n");
 #endif
 
+#if QUIET_SYSTEM
+    /* first, as it may re-exec with the command line as given */
+    quiet_system(argc, argv);
+#endif
+#if CGROUP_AWARE
+    cgroup_init();
+#endif
 #if (MULTITHREAD > 1) && (SEED_METHOD == SEED_ARG)
     int nargs = *argc, i;
     if ((nargs > 1) && (*argv[1] == 'M'))
@@ -245,6 +1396,10 @@ portable_init(core_portable *p, int *argc, char *argv[])
             argv[i] = argv[i + 1];
         *argc = nargs;
     }
+#if CGROUP_AWARE
+    else /* as many contexts as the cgroup allows to run at once */
+        default_num_contexts = cgroup_contexts(default_num_contexts);
+#endif
 #endif /* sample of potential platform specific init via command line, reset \
           the number of contexts being used if first argument is M<n>*/
     p->portable_id = 1;
@@ -255,6 +1410,12 @@ portable_init(core_portable *p, int *argc, char *argv[])
 void
 portable_fini(core_portable *p)
 {
+#if QUIET_SYSTEM
+    quiet_restore();
+#endif
+#if DAEMON_RUN
+    background_restore();
+#endif
     p->portable_id = 0;
 }
 
@@ -278,6 +1439,23 @@ portable_fini(core_portable *p)
 ee_u8
 core_start_parallel(core_results *res)
 {
+#if QUIET_SYSTEM
+    int cpu = quiet_next_cpu();
+    if (cpu >= 0)
+    {
+        pthread_attr_t attr;
+        cpu_set_t      set;
+        ee_u8          err;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        err = (ee_u8)pthread_create(
+            &(res->port.thread), &attr, iterate, (void *)res);
+        pthread_attr_destroy(&attr);
+        return err;
+    }
+#endif
     return (ee_u8)pthread_create(
         &(res->port.thread), NULL, iterate, (void *)res);
 }
@@ -293,7 +1471,11 @@ ee_u8
 core_start_parallel(core_results *res)
 {
     key_t key = 4321 + key_id;
+#if QUIET_SYSTEM
+    int cpu = quiet_next_cpu();
+#endif
     key_id++;
+    fflush(stdout); /* else the children print the output so far again */
     res->port.pid   = fork();
     res->port.shmid = shmget(key, 8, IPC_CREAT | 0666);
     if (res->port.shmid < 0)
@@ -302,6 +1484,10 @@ core_start_parallel(core_results *res)
     }
     if (res->port.pid == 0)
     {
+#if QUIET_SYSTEM
+        if (cpu >= 0)
+            portable_set_affinity((ee_u32)cpu);
+#endif
         iterate(res);
         res->port.shm = shmat(res->port.shmid, NULL, 0);
         /* copy the validation values to the shared memory area  and quit*/
@@ -344,61 +1530,49 @@ core_stop_parallel(core_results *res)
     return 1;
 }
 #elif USE_SOCKET
-static int key_id = 0;
 ee_u8
 core_start_parallel(core_results *res)
 {
-    int bound, buffer_length = 8;
-    res->port.sa.sin_family      = AF_INET;
-    res->port.sa.sin_addr.s_addr = htonl(0x7F000001);
-    res->port.sa.sin_port        = htons(7654 + key_id);
-    key_id++;
+    int sv[2];
+#if QUIET_SYSTEM
+    int cpu = quiet_next_cpu();
+#endif
+    /* the connected pair is created before the child starts, so that results
+     * of a short run are never sent before anyone is listening */
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+    {
+        ee_printf("socketpair(): %s\n", strerror(errno));
+        return 0;
+    }
+    fflush(stdout); /* else the children print the output so far again */
     res->port.pid = fork();
     if (res->port.pid == 0)
     { /* benchmark child */
+#if QUIET_SYSTEM
+        if (cpu >= 0)
+            portable_set_affinity((ee_u32)cpu);
+#endif
+        close(sv[0]);
         iterate(res);
-        res->port.sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
-        if (-1 == res->port.sock) /* if socket failed to initialize, exit */
-        {
-            ee_printf("Error Creating Socket");
-        }
-        else
-        {
-            int bytes_sent = sendto(res->port.sock,
-                                    &(res->crc),
-                                    buffer_length,
-                                    0,
-                                    (struct sockaddr *)&(res->port.sa),
-                                    sizeof(struct sockaddr_in));
-            if (bytes_sent < 0)
-                ee_printf("Error sending packet: %s\n", strerror(errno));
-            close(res->port.sock); /* close the socket */
-        }
+        if (send(sv[1], &(res->crc), 8, 0) < 0)
+            ee_printf("Error sending results: %s\n", strerror(errno));
+        close(sv[1]);
         exit(0);
     }
-    /* parent process, open the socket */
-    res->port.sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    bound          = bind(res->port.sock,
-                 (struct sockaddr *)&(res->port.sa),
-                 sizeof(struct sockaddr));
-    if (bound < 0)
-        ee_printf("bind(): %s\n", strerror(errno));
+    close(sv[1]);
+    res->port.sock = sv[0];
     return 1;
 }
 ee_u8
 core_stop_parallel(core_results *res)
 {
     int status;
-    int fromlen = sizeof(struct sockaddr);
-    int recsize = recvfrom(res->port.sock,
-                           &(res->crc),
-                           8,
-                           0,
-                           (struct sockaddr *)&(res->port.sa),
-                           &fromlen);
-    if (recsize < 0)
-    {
-        ee_printf("Error in receive: %s\n", strerror(errno));
+    int recsize = recv(res->port.sock, &(res->crc), 8, 0);
+    close(res->port.sock);
+    if (recsize != 8)
+    {
+        ee_printf("Error in receive: %s\n",
+                  recsize < 0 ? strerror(errno) : "no results");
         return 0;
     }
     pid_t wpid = waitpid(res->port.pid, &status, WUNTRACED);
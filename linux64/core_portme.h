@@ -109,6 +109,7 @@ typedef float              ee_f16;
 typedef double             ee_f32;
 typedef unsigned char      ee_u8;
 typedef unsigned int       ee_u32;
+typedef unsigned long long ee_u64;
 typedef unsigned long long ee_ptr_int;
 typedef size_t             ee_size_t;
 /* align an offset to point to a 32b value */
@@ -139,6 +140,353 @@ typedef size_t             ee_size_t;
 #define MEM_METHOD MEM_MALLOC
 #endif
 
+/* Configuration: CORE_RUN_API
+        Library entry point <core_run>, timed with <portable_time>.
+
+        Valid values:
+        0 - Not supported.
+        1 - Provide <core_run> (default).
+*/
+#ifndef CORE_RUN_API
+#define CORE_RUN_API 1
+#endif
+
+/* Configuration: SNAPSHOT_RUN
+        Snapshot and restore of the initialized data blocks via mmap.
+
+        Valid values:
+        0 - Always initialize the data.
+        1 - Support --snapshot=<file> (requires seeds from the command line).
+*/
+#ifndef SNAPSHOT_RUN
+#if (SEED_METHOD == SEED_ARG)
+#define SNAPSHOT_RUN 1
+#else
+#define SNAPSHOT_RUN 0
+#endif
+#endif
+
+/* Configuration: STREAM_RUN
+        Streaming state machine benchmark over a file, with reads on a helper
+   thread.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --stream=<file> (requires seeds from the command line).
+*/
+#ifndef STREAM_RUN
+#if (SEED_METHOD == SEED_ARG)
+#define STREAM_RUN 1
+#else
+#define STREAM_RUN 0
+#endif
+#endif
+
+/* Configuration: PIPELINE_RUN
+        Pipelined execution of the kernels on separate pinned cores.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --pipeline (requires seeds from the command line).
+*/
+#ifndef PIPELINE_RUN
+#if (SEED_METHOD == SEED_ARG)
+#define PIPELINE_RUN 1
+#else
+#define PIPELINE_RUN 0
+#endif
+#endif
+
+/* Configuration: ALIGN_SWEEP
+        Data alignment sweep with <core_run>.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --align-sweep[=<repeats>] (requires seeds from the command
+   line and malloc).
+*/
+#ifndef ALIGN_SWEEP
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define ALIGN_SWEEP 1
+#else
+#define ALIGN_SWEEP 0
+#endif
+#endif
+
+/* Configuration: AB_RUN
+        Interleaved A/B comparison with <core_run>.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --ab-a=<spec> and --ab-b=<spec> (requires seeds from the
+   command line and malloc).
+*/
+#ifndef AB_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define AB_RUN 1
+#else
+#define AB_RUN 0
+#endif
+#endif
+
+/* Configuration: COMPARE_RUN
+        Result files and comparison with a baseline with <core_run>.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --samples[=<N>], --json=<file> and --compare=<file>
+   (requires seeds from the command line and malloc).
+*/
+#ifndef COMPARE_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define COMPARE_RUN 1
+#else
+#define COMPARE_RUN 0
+#endif
+#endif
+
+/* Configuration: COUNT_RUN
+        Instruction count mode, with the perf instruction counter of the
+   thread, or callgrind when built with CALLGRIND_RUN.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --count[=<budgets>] (requires seeds from the command line
+   and malloc).
+*/
+#ifndef COUNT_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC)
+#define COUNT_RUN 1
+#else
+#define COUNT_RUN 0
+#endif
+#endif
+
+/* Configuration: CGROUP_AWARE
+        Contexts sized to the cpuset and cpu quota of the cgroup (v1 or v2),
+   and throttling of the timed run of the score from cpu.stat.
+
+        Valid values:
+        0 - Ignore cgroups.
+        1 - Without M<n>, run as many contexts as the cgroup allows, up to
+   <MULTITHREAD>, and fail runs that were throttled (default).
+*/
+#ifndef CGROUP_AWARE
+#define CGROUP_AWARE 1
+#endif
+
+/* Configuration: HYBRID_RUN
+        Core types of hybrid processors from sysfs or cpuid, and the hybrid
+   mode with <core_run> and pinned threads.
+
+        Valid values:
+        0 - Not supported.
+        1 - Report the core types, and support --hybrid (requires seeds from
+   the command line and malloc).
+*/
+#ifndef HYBRID_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define HYBRID_RUN 1
+#else
+#define HYBRID_RUN 0
+#endif
+#endif
+
+/* Configuration: CPUMAP_RUN
+        Per cpu score map with <core_run> and pinned threads.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --cpu-map[=<cpus>] (requires seeds from the command line
+   and malloc).
+*/
+#ifndef CPUMAP_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define CPUMAP_RUN 1
+#else
+#define CPUMAP_RUN 0
+#endif
+#endif
+
+/* Configuration: DAEMON_RUN
+        Metrics exporter daemon mode with <core_run>, at idle priority and
+   optionally limited by the cpu.max of a cgroup v2.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --daemon[=<port|path>] (requires seeds from the command
+   line and malloc).
+*/
+#ifndef DAEMON_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define DAEMON_RUN 1
+#else
+#define DAEMON_RUN 0
+#endif
+#endif
+
+/* Configuration: STARTUP_RUN
+        Startup latency breakdown, with the process start time from
+   /proc/self/stat.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --startup[=<execs>] (requires seeds from the command line
+   and malloc).
+*/
+#ifndef STARTUP_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC)
+#define STARTUP_RUN 1
+#else
+#define STARTUP_RUN 0
+#endif
+#endif
+
+/* Configuration: MIX_RUN
+        Work mix with explicit sizes and time shares of the algorithms.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --mix[=<list>:<matrix>:<state>] (requires seeds from the
+   command line and malloc).
+*/
+#ifndef MIX_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC) && CORE_RUN_API
+#define MIX_RUN 1
+#else
+#define MIX_RUN 0
+#endif
+#endif
+
+/* Configuration: REFERENCE_RUN
+        Crcs of any configuration from a reference implementation.
+
+        Valid values:
+        0 - Not supported.
+        1 - Validate configurations without known crcs, with a cache file
+   (requires seeds from the command line and malloc).
+*/
+#ifndef REFERENCE_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC)
+#define REFERENCE_RUN 1
+#else
+#define REFERENCE_RUN 0
+#endif
+#endif
+
+/* Configuration: PREFLIGHT_RUN
+        Untimed check of all the contexts before a run.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --preflight=<iterations>, on by default (requires seeds
+   from the command line).
+*/
+#ifndef PREFLIGHT_RUN
+#if (SEED_METHOD == SEED_ARG)
+#define PREFLIGHT_RUN 1
+#else
+#define PREFLIGHT_RUN 0
+#endif
+#endif
+
+/* Configuration: CLUSTER_RUN
+        Localhost cluster mode, a coordinator and worker processes over Unix
+   domain sockets.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --cluster=<N> and --cluster-worker=<socket> (requires seeds
+   from the command line and malloc).
+*/
+#ifndef CLUSTER_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC)
+#define CLUSTER_RUN 1
+#else
+#define CLUSTER_RUN 0
+#endif
+#endif
+
+/* Configuration: KERNEL_REGISTRY
+        Kernels called through a table, with variants selectable at run time.
+
+        Valid values:
+        0 - Call the reference kernels directly (default), so that the score
+   measures the same code as a build without the registry.
+        1 - Support --kernel=<kernel>:<variant>, --list-kernels and
+   --verify-all (requires seeds from the command line and malloc).
+*/
+#ifndef KERNEL_REGISTRY
+#define KERNEL_REGISTRY 0
+#endif
+#if KERNEL_REGISTRY
+#if (SEED_METHOD != SEED_ARG) || (MEM_METHOD != MEM_MALLOC)
+#error "KERNEL_REGISTRY requires SEED_ARG and MEM_MALLOC"
+#endif
+#endif
+
+/* Configuration: PLUGIN_RUN
+        Workload plugins run after the CoreMark score.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --plugin=<name|path.so>[,...], --plugin-only and
+   --list-plugins (requires seeds from the command line and malloc).
+*/
+#ifndef PLUGIN_RUN
+#if (SEED_METHOD == SEED_ARG) && (MEM_METHOD == MEM_MALLOC)
+#define PLUGIN_RUN 1
+#else
+#define PLUGIN_RUN 0
+#endif
+#endif
+/* Configuration: PLUGIN_DLOPEN
+        Load plugins from shared objects with dlopen.
+
+        Valid values:
+        0 - Built-in plugins only.
+        1 - Also accept the path of a shared object in --plugin (default).
+*/
+#ifndef PLUGIN_DLOPEN
+#define PLUGIN_DLOPEN PLUGIN_RUN
+#endif
+
+/* Configuration: QUIET_SYSTEM
+        Low noise run mode set up by <portable_init>.
+
+        Valid values:
+        0 - Not supported.
+        1 - Support --quiet-system[=<cpus>] and --no-aslr (requires seeds from
+   the command line).
+*/
+#ifndef QUIET_SYSTEM
+#if (SEED_METHOD == SEED_ARG)
+#define QUIET_SYSTEM 1
+#else
+#define QUIET_SYSTEM 0
+#endif
+#endif
+
+/* Configuration: MULTIVERSION
+        Hot kernels built once per x86-64 level with target_clones, and
+   selected when the program is loaded.
+
+        Valid values:
+        0 - Build the kernels for the level of the compiler flags (default).
+        1 - Clones for x86-64, x86-64-v2, x86-64-v3 and x86-64-v4 (requires gcc
+   12 or later on x86-64).
+*/
+#ifndef MULTIVERSION
+#define MULTIVERSION 0
+#endif
+#if MULTIVERSION
+#if !defined(__x86_64__) || defined(__clang__) || (__GNUC__ < 12)
+#error "MULTIVERSION requires gcc 12 or later on x86-64"
+#endif
+#define MULTIVERSION_TARGETS \
+    "default", "arch=x86-64-v2", "arch=x86-64-v3", "arch=x86-64-v4"
+#endif
+
 /* Configuration: MULTITHREAD
         Define for parallel execution
 
@@ -194,7 +542,8 @@ typedef size_t             ee_size_t;
 
 /* Configuration: USE_SOCKET
         Sample implementation for launching parallel contexts
-        This implementation uses fork, socket, sendto and recvfrom
+        This implementation uses fork, socketpair, send and recv, with one
+   Unix domain socket pair per context.
 
         Valid values:
         0 - Do not use fork and sockets API.
@@ -257,8 +606,6 @@ extern ee_u32 default_num_contexts;
 #elif USE_SOCKET
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
 #include <sys/wait.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -283,9 +630,8 @@ typedef struct CORE_PORTABLE_S
     int   shmid;
     void *shm;
 #elif USE_SOCKET
-    pid_t              pid;
-    int                sock;
-    struct sockaddr_in sa;
+    pid_t pid;
+    int   sock;
 #endif /* Method for multithreading */
 #endif /* MULTITHREAD>1 */
     ee_u8 portable_id;